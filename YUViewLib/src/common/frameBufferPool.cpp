@@ -0,0 +1,309 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "frameBufferPool.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <QMutexLocker>
+#ifdef Q_OS_WIN
+#include <malloc.h>
+#endif
+
+// Byte arrays are allocated with a size that is a multiple of this. All sizes in one bucket share buffers.
+#define POOL_BUCKET_SIZE (64 * 1024)
+// Buffers smaller than this are not worth pooling
+#define POOL_MIN_BUFFER_SIZE (256 * 1024)
+
+#define FRAMEBUFFERPOOL_DEBUG_OUTPUT 0
+#if FRAMEBUFFERPOOL_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_POOL qDebug
+#else
+#define DEBUG_POOL(fmt,...) ((void)0)
+#endif
+
+namespace
+{
+
+int getBucketSize(int size)
+{
+  return int((int64_t(size) + POOL_BUCKET_SIZE - 1) / POOL_BUCKET_SIZE * POOL_BUCKET_SIZE);
+}
+
+int64_t getBucketSize(int64_t size)
+{
+  return (size + POOL_BUCKET_SIZE - 1) / POOL_BUCKET_SIZE * POOL_BUCKET_SIZE;
+}
+
+char *allocateAligned(int64_t size, int alignment)
+{
+#ifdef Q_OS_WIN
+  return static_cast<char*>(_aligned_malloc(size_t(size), size_t(alignment)));
+#else
+  void *mem = nullptr;
+  if (posix_memalign(&mem, size_t(alignment), size_t(size)) != 0)
+    return nullptr;
+  return static_cast<char*>(mem);
+#endif
+}
+
+void freeAligned(char *mem)
+{
+#ifdef Q_OS_WIN
+  _aligned_free(mem);
+#else
+  free(mem);
+#endif
+}
+
+} // namespace
+
+frameBufferPool &frameBufferPool::instance()
+{
+  static frameBufferPool pool;
+  return pool;
+}
+
+QByteArray frameBufferPool::getByteArray(int size)
+{
+  if (size < POOL_MIN_BUFFER_SIZE)
+    return QByteArray(size, Qt::Uninitialized);
+
+  const int bucketSize = getBucketSize(size);
+  QByteArray buffer;
+  {
+    QMutexLocker lock(&mutex);
+    const int idx = findByteArray(bucketSize);
+    if (idx >= 0)
+    {
+      buffer = buffers[idx].data;
+      poolBytes -= buffers[idx].size;
+      buffers.removeAt(idx);
+      hits++;
+    }
+    else
+      misses++;
+  }
+
+  if (buffer.isNull())
+  {
+    // Reserve the whole bucket so that the buffer can be reused for all sizes of the bucket
+    DEBUG_POOL("frameBufferPool::getByteArray allocate %d bytes", bucketSize);
+    buffer.reserve(bucketSize);
+  }
+  // Resizing within the reserved capacity does not reallocate
+  buffer.resize(size);
+  return buffer;
+}
+
+void frameBufferPool::prepareByteArray(QByteArray &buffer, int size)
+{
+  // A view (QByteArray::fromRawData) has no capacity. It is replaced like a shared buffer.
+  if (buffer.size() >= size && buffer.capacity() >= size && buffer.isDetached())
+    return;
+  if (size < POOL_MIN_BUFFER_SIZE)
+  {
+    if (buffer.size() < size)
+      buffer.resize(size);
+    return;
+  }
+  // Don't copy the old content of a shared buffer. Just replace it.
+  buffer = getByteArray(size);
+}
+
+void frameBufferPool::makeOwned(QByteArray &buffer)
+{
+  // A QByteArray created with fromRawData does not allocate memory. So its capacity is 0.
+  if (buffer.isEmpty() || buffer.capacity() >= buffer.size())
+    return;
+  QByteArray copy = getByteArray(buffer.size());
+  std::memcpy(copy.data(), buffer.constData(), size_t(buffer.size()));
+  buffer = copy;
+}
+
+QImage frameBufferPool::getImage(const QSize &size, QImage::Format format)
+{
+  {
+    QMutexLocker lock(&mutex);
+    const int idx = findImage(size, format);
+    if (idx >= 0)
+    {
+      QImage image = buffers[idx].image;
+      poolBytes -= buffers[idx].size;
+      buffers.removeAt(idx);
+      hits++;
+      return image;
+    }
+    if (int64_t(size.width()) * size.height() * 4 >= POOL_MIN_BUFFER_SIZE)
+      misses++;
+  }
+  return QImage(size, format);
+}
+
+frameBufferPool::alignedMemory frameBufferPool::getAlignedMemory(int64_t size, int alignment)
+{
+  const int64_t bucketSize = getBucketSize(size);
+  if (bucketSize >= POOL_MIN_BUFFER_SIZE)
+  {
+    QMutexLocker lock(&mutex);
+    const int idx = findAlignedMemory(bucketSize, alignment);
+    if (idx >= 0)
+    {
+      alignedMemory memory = buffers[idx].aligned;
+      poolBytes -= buffers[idx].size;
+      buffers.removeAt(idx);
+      hits++;
+      return memory;
+    }
+    misses++;
+  }
+
+  DEBUG_POOL("frameBufferPool::getAlignedMemory allocate %lld bytes", (long long)bucketSize);
+  char *mem = allocateAligned(bucketSize, alignment);
+  if (mem == nullptr)
+    return alignedMemory();
+  return alignedMemory(mem, freeAligned);
+}
+
+void frameBufferPool::release(QByteArray &buffer)
+{
+  // Only buffers that were allocated by the pool have the size of a bucket
+  pooledBuffer b;
+  b.size = buffer.capacity();
+  if (b.size >= POOL_MIN_BUFFER_SIZE && b.size % POOL_BUCKET_SIZE == 0 && buffer.isDetached())
+  {
+    b.data = buffer;
+    add(b);
+  }
+  buffer = QByteArray();
+}
+
+void frameBufferPool::release(QImage &image)
+{
+  pooledBuffer b;
+  b.size = image.sizeInBytes();
+  if (b.size >= POOL_MIN_BUFFER_SIZE && image.isDetached())
+  {
+    b.image = image;
+    add(b);
+  }
+  image = QImage();
+}
+
+void frameBufferPool::release(alignedMemory &memory, int64_t size, int alignment)
+{
+  pooledBuffer b;
+  b.size = getBucketSize(size);
+  if (!memory.isNull() && b.size >= POOL_MIN_BUFFER_SIZE)
+  {
+    b.aligned = memory;
+    b.alignment = alignment;
+    add(b);
+  }
+  memory.reset();
+}
+
+void frameBufferPool::setMaxSize(int64_t maxBytes)
+{
+  QMutexLocker lock(&mutex);
+  maxPoolBytes = maxBytes;
+  removeOldestBuffers();
+}
+
+void frameBufferPool::clear()
+{
+  QList<pooledBuffer> freeBuffers;
+  {
+    QMutexLocker lock(&mutex);
+    freeBuffers.swap(buffers);
+    poolBytes = 0;
+  }
+  // The memory is freed here without holding the lock
+}
+
+frameBufferPool::statistics frameBufferPool::getStatistics() const
+{
+  QMutexLocker lock(&mutex);
+  statistics stats;
+  stats.hits = hits;
+  stats.misses = misses;
+  stats.nrBuffers = buffers.count();
+  stats.nrBytes = poolBytes;
+  stats.maxBytes = maxPoolBytes;
+  return stats;
+}
+
+int frameBufferPool::findByteArray(int bucketSize) const
+{
+  for (int i = buffers.count() - 1; i >= 0; i--)
+    if (!buffers[i].data.isNull() && buffers[i].data.capacity() == bucketSize)
+      return i;
+  return -1;
+}
+
+int frameBufferPool::findImage(const QSize &size, QImage::Format format) const
+{
+  for (int i = buffers.count() - 1; i >= 0; i--)
+    if (!buffers[i].image.isNull() && buffers[i].image.size() == size && buffers[i].image.format() == format)
+      return i;
+  return -1;
+}
+
+int frameBufferPool::findAlignedMemory(int64_t bucketSize, int alignment) const
+{
+  for (int i = buffers.count() - 1; i >= 0; i--)
+    if (!buffers[i].aligned.isNull() && buffers[i].size == bucketSize && buffers[i].alignment == alignment)
+      return i;
+  return -1;
+}
+
+void frameBufferPool::add(const pooledBuffer &buffer)
+{
+  QMutexLocker lock(&mutex);
+  if (buffer.size > maxPoolBytes)
+    return;
+  buffers.append(buffer);
+  poolBytes += buffer.size;
+  removeOldestBuffers();
+}
+
+void frameBufferPool::removeOldestBuffers()
+{
+  while (poolBytes > maxPoolBytes && !buffers.isEmpty())
+  {
+    DEBUG_POOL("frameBufferPool::removeOldestBuffers free %lld bytes", (long long)buffers.first().size);
+    poolBytes -= buffers.first().size;
+    buffers.removeFirst();
+  }
+}
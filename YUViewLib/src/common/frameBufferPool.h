@@ -0,0 +1,131 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QSize>
+
+#include "common/typedef.h"
+
+// The default maximum size of all buffers in the pool
+#define FRAME_BUFFER_POOL_DEFAULT_MAX_BYTES (int64_t(256) * 1024 * 1024)
+
+/* A pool of frame sized buffers (raw data in QByteArrays and converted QImages). Loading, decoding and converting a frame
+ * needs a new buffer for every frame. Allocating (and freeing) these large buffers for every frame costs a lot of time
+ * (page faults, clearing of the memory by the OS). Instead, the buffers of frames that are removed from the cache are
+ * returned to the pool and the next frame is loaded into them.
+ * Byte arrays are grouped in buckets of POOL_BUCKET_SIZE bytes so that a buffer can be reused for all sizes of the
+ * same bucket. Images are only reused for the same size and format. Only buffers that are not shared (no other copy
+ * of the QByteArray/QImage exists) are put into the pool. Small buffers are not pooled.
+ * All functions are thread-safe.
+ */
+class frameBufferPool
+{
+public:
+  static frameBufferPool &instance();
+
+  // Get a byte array of the given size. The content is undefined.
+  QByteArray getByteArray(int size);
+  // Make sure that the buffer is not shared and that it has at least the given size. If not, it is replaced by a
+  // buffer from the pool. Use this before writing to a buffer that may have been passed on (e.g. to the cache).
+  void prepareByteArray(QByteArray &buffer, int size);
+  // If the buffer does not own its data (a view of other memory like a memory mapped file), copy the data into a
+  // buffer from the pool. Use this before keeping such a buffer (e.g. in the cache).
+  void makeOwned(QByteArray &buffer);
+#if SSE_CONVERSION
+  void prepareByteArray(byteArrayAligned &buffer, int size) { if (buffer.capacity() < size) buffer.resize(size); }
+#endif
+  // Get an image of the given size and format. The content is undefined.
+  QImage getImage(const QSize &size, QImage::Format format);
+  // Get memory with a start address that is a multiple of the given alignment (e.g. for reading with direct I/O).
+  // The size is rounded up to the bucket size. The content is undefined. The memory is freed when the last copy
+  // of the pointer is gone. It can also be given back to the pool using release (with the same size and alignment)
+  // if no other copy of the pointer is used anymore.
+  typedef QSharedPointer<char> alignedMemory;
+  alignedMemory getAlignedMemory(int64_t size, int alignment);
+
+  // Give the buffer back to the pool. The given buffer is cleared. If another copy of the buffer exists, it
+  // can not be reused and is not added to the pool.
+  void release(QByteArray &buffer);
+  void release(QImage &image);
+  void release(alignedMemory &memory, int64_t size, int alignment);
+
+  // Set the maximum size of all buffers in the pool in bytes. If the pool is full, the oldest buffers are freed.
+  void setMaxSize(int64_t maxBytes);
+  // Free all buffers in the pool
+  void clear();
+
+  struct statistics
+  {
+    int64_t hits {0};
+    int64_t misses {0};
+    int nrBuffers {0};
+    int64_t nrBytes {0};
+    int64_t maxBytes {0};
+  };
+  statistics getStatistics() const;
+
+private:
+  frameBufferPool() {}
+
+  struct pooledBuffer
+  {
+    QByteArray data;
+    QImage image;
+    alignedMemory aligned;
+    int alignment {0};
+    int64_t size {0};
+  };
+
+  // Get the index of a matching buffer in the pool (the most recently returned one) or -1
+  int findByteArray(int bucketSize) const;
+  int findImage(const QSize &size, QImage::Format format) const;
+  int findAlignedMemory(int64_t bucketSize, int alignment) const;
+  void add(const pooledBuffer &buffer);
+  // Free the oldest buffers until the size limit is met. The mutex must be locked.
+  void removeOldestBuffers();
+
+  mutable QMutex mutex;
+  // The buffers in the order in which they were returned (oldest first)
+  QList<pooledBuffer> buffers;
+  int64_t poolBytes {0};
+  int64_t maxPoolBytes {FRAME_BUFFER_POOL_DEFAULT_MAX_BYTES};
+  int64_t hits {0};
+  int64_t misses {0};
+};
@@ -40,6 +40,9 @@
 #elif defined(Q_OS_WIN32)
 #include <windows.h>
 #endif
+#if SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #include <QIcon>
 #include <QSettings>
@@ -133,6 +136,67 @@ unsigned int functions::systemMemorySizeInMB()
   return memorySizeInMB;
 }
 
+namespace
+{
+
+struct cpuFeatures
+{
+  cpuFeatures()
+  {
+#if SIMD_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int nrIDs = info[0];
+    if (nrIDs >= 1)
+    {
+      __cpuid(info, 1);
+      sse2 = (info[3] & (1 << 26)) != 0;
+      sse41 = (info[2] & (1 << 19)) != 0;
+      // AVX registers can only be used if the OS saves them (OSXSAVE and XCR0 bits 1 and 2)
+      const bool osxsave = (info[2] & (1 << 27)) != 0;
+      const bool avx = (info[2] & (1 << 28)) != 0;
+      const bool osSupportsYMM = osxsave && ((_xgetbv(0) & 0x6) == 0x6);
+      if (nrIDs >= 7 && avx && osSupportsYMM)
+      {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+      }
+    }
+#elif SIMD_X86
+    __builtin_cpu_init();
+    sse2 = __builtin_cpu_supports("sse2");
+    sse41 = __builtin_cpu_supports("sse4.1");
+    avx2 = __builtin_cpu_supports("avx2");
+#endif
+  }
+  bool sse2 {false};
+  bool sse41 {false};
+  bool avx2 {false};
+};
+
+const cpuFeatures &getCpuFeatures()
+{
+  static const cpuFeatures features;
+  return features;
+}
+
+} // namespace
+
+bool functions::cpuSupportsSSE2()
+{
+  return getCpuFeatures().sse2;
+}
+
+bool functions::cpuSupportsSSE41()
+{
+  return getCpuFeatures().sse41;
+}
+
+bool functions::cpuSupportsAVX2()
+{
+  return getCpuFeatures().avx2;
+}
+
 QIcon functions::convertIcon(QString iconPath)
 {
   QSettings settings;
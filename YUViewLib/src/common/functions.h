@@ -103,6 +103,12 @@ unsigned int getOptimalThreadCount();
 // This function is thread safe and inexpensive to call.
 unsigned int systemMemorySizeInMB();
 
+// Runtime detection of the SIMD instruction sets that the CPU (and the OS) supports.
+// The detection is only performed once. On non x86 platforms these always return false.
+bool cpuSupportsSSE2();
+bool cpuSupportsSSE41();
+bool cpuSupportsAVX2();
+
 // These are the names of the supported themes
 QStringList getThemeNameList();
 // Get the name of the theme in the resource file that we will load
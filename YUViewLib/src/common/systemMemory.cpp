@@ -0,0 +1,219 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "systemMemory.h"
+
+#include <algorithm>
+#include <QFile>
+#include <QList>
+
+namespace systemMemory
+{
+
+namespace
+{
+
+// Keep at least this much of the (cgroup) memory free for the rest of the system
+const int64_t MIN_RESERVE_BYTES = int64_t(256) * 1024 * 1024;
+// The budget is never reduced below this value (same as the minimum of the threshold in the settings)
+const int64_t MIN_BUDGET_BYTES = int64_t(20) * 1000 * 1000;
+
+QByteArray readSmallFile(const QString &path)
+{
+  // Files in /proc and /sys report a size of 0. So don't rely on the size and just read until the end.
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return {};
+  return file.readAll();
+}
+
+#ifdef Q_OS_LINUX
+
+struct cgroupFiles
+{
+  QString limitFile;
+  QString usageFile;
+};
+
+// Get the memory limit files of the cgroup of this process and of all its parents (the closest one first).
+// A parent can have a lower limit than the cgroup itself.
+QList<cgroupFiles> findCgroupFiles()
+{
+  QList<cgroupFiles> files;
+  for (const QByteArray &line : readSmallFile("/proc/self/cgroup").split('\n'))
+  {
+    // The lines have the format "hierarchy-ID:controller-list:cgroup-path"
+    const int firstColon = line.indexOf(':');
+    const int secondColon = line.indexOf(':', firstColon + 1);
+    if (firstColon < 0 || secondColon < 0)
+      continue;
+    const QList<QByteArray> controllers = line.mid(firstColon + 1, secondColon - firstColon - 1).split(',');
+    const bool isV2 = line.left(firstColon) == "0" && controllers.count() == 1 && controllers[0].isEmpty();
+    const bool isV1Memory = controllers.contains("memory");
+    if (!isV2 && !isV1Memory)
+      continue;
+
+    const QString root = isV2 ? "/sys/fs/cgroup" : "/sys/fs/cgroup/memory";
+    const QString limitName = isV2 ? "/memory.max" : "/memory.limit_in_bytes";
+    const QString usageName = isV2 ? "/memory.current" : "/memory.usage_in_bytes";
+    QString path = QString::fromLocal8Bit(line.mid(secondColon + 1)).trimmed();
+    while (true)
+    {
+      // Inside of a container, the path of the cgroup may not exist in the mounted hierarchy
+      if (QFile::exists(root + path + limitName))
+        files.append({root + path + limitName, root + path + usageName});
+      if (path.isEmpty() || path == "/")
+        break;
+      path = path.left(path.lastIndexOf('/'));
+    }
+    if (!files.isEmpty())
+      break;
+  }
+  return files;
+}
+
+#endif
+
+} // namespace
+
+bool parseMeminfo(const QByteArray &data, memoryState &state)
+{
+  state.totalBytes = -1;
+  state.availableBytes = -1;
+  for (const QByteArray &line : data.split('\n'))
+  {
+    // The lines have the format "MemAvailable:    1234567 kB"
+    const int colon = line.indexOf(':');
+    if (colon < 0)
+      continue;
+    const QByteArray name = line.left(colon);
+    if (name != "MemTotal" && name != "MemAvailable")
+      continue;
+    QByteArray value = line.mid(colon + 1).trimmed();
+    int64_t factor = 1;
+    if (value.endsWith(" kB"))
+    {
+      value.chop(3);
+      factor = 1024;
+    }
+    bool ok;
+    const int64_t v = value.trimmed().toLongLong(&ok);
+    if (!ok || v < 0)
+      continue;
+    if (name == "MemTotal")
+      state.totalBytes = v * factor;
+    else
+      state.availableBytes = v * factor;
+  }
+  return state.totalBytes > 0 && state.availableBytes >= 0;
+}
+
+int64_t parseCgroupValue(const QByteArray &data)
+{
+  bool ok;
+  const int64_t v = data.trimmed().toLongLong(&ok);
+  return (ok && v >= 0) ? v : -1;
+}
+
+memoryState readMemoryState()
+{
+  memoryState state;
+#ifdef Q_OS_LINUX
+  if (!parseMeminfo(readSmallFile("/proc/meminfo"), state))
+    return state;
+
+  // The cgroups do not change while we are running
+  static const QList<cgroupFiles> cgroups = findCgroupFiles();
+  for (const cgroupFiles &cgroup : cgroups)
+  {
+    // Use the cgroup with the least free memory
+    const int64_t limit = parseCgroupValue(readSmallFile(cgroup.limitFile));
+    const int64_t usage = parseCgroupValue(readSmallFile(cgroup.usageFile));
+    if (limit <= 0 || usage < 0)
+      continue;
+    if (state.cgroupLimitBytes < 0 || limit - usage < state.cgroupLimitBytes - state.cgroupUsageBytes)
+    {
+      state.cgroupLimitBytes = limit;
+      state.cgroupUsageBytes = usage;
+    }
+  }
+#endif
+  return state;
+}
+
+cacheBudget getCacheBudget(const memoryState &state, int64_t cacheLevelCurrent, int64_t cacheLevelThreshold)
+{
+  cacheBudget budget;
+  budget.bytes = cacheLevelThreshold;
+  if (!state.isValid())
+  {
+    budget.reason = "Threshold (memory information not available)";
+    return budget;
+  }
+
+  // How much memory is there and how much of it is still free? A cgroup limit of cgroups v1 without
+  // a limit is a very large number. Only consider a limit that is lower than the system memory.
+  int64_t total = state.totalBytes;
+  int64_t available = state.availableBytes;
+  bool limitedByCgroup = false;
+  if (state.cgroupLimitBytes > 0 && state.cgroupLimitBytes < total)
+  {
+    total = state.cgroupLimitBytes;
+    const int64_t cgroupAvailable = std::max(int64_t(0), state.cgroupLimitBytes - state.cgroupUsageBytes);
+    if (cgroupAvailable < available)
+    {
+      available = cgroupAvailable;
+      limitedByCgroup = true;
+    }
+  }
+
+  // The cache may grow into the free memory except for a reserve. The memory used by the cache itself could be freed.
+  const int64_t reserve = std::min(std::max(total / 10, MIN_RESERVE_BYTES), total / 2);
+  const int64_t adaptiveMax = std::max(cacheLevelCurrent, int64_t(0)) + available - reserve;
+  const int64_t availableMB = available / 1000000;
+  if (adaptiveMax >= cacheLevelThreshold)
+  {
+    budget.reason = QString("Threshold (%1 MB memory available)").arg(availableMB);
+    return budget;
+  }
+
+  budget.bytes = std::max(adaptiveMax, MIN_BUDGET_BYTES);
+  budget.underPressure = true;
+  if (limitedByCgroup)
+    budget.reason = QString("Low memory in cgroup (%1 MB of %2 MB available)").arg(availableMB).arg(total / 1000000);
+  else
+    budget.reason = QString("Low system memory (%1 MB of %2 MB available)").arg(availableMB).arg(total / 1000000);
+  return budget;
+}
+
+} // namespace systemMemory
@@ -0,0 +1,80 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Information about the memory of the system that is used to adapt the size of the video cache to the free memory.
+// The information is read from /proc/meminfo and from the memory controller of the cgroup that YUView runs in.
+// This is only available on Linux. On all other platforms, the returned state is invalid.
+namespace systemMemory
+{
+
+struct memoryState
+{
+  bool isValid() const { return totalBytes > 0 && availableBytes >= 0; }
+
+  // MemTotal and MemAvailable from /proc/meminfo
+  int64_t totalBytes {-1};
+  int64_t availableBytes {-1};
+  // The memory limit and usage of the cgroup (-1 if there is no limit)
+  int64_t cgroupLimitBytes {-1};
+  int64_t cgroupUsageBytes {-1};
+};
+
+// Parse the content of /proc/meminfo. Returns false if MemTotal or MemAvailable were not found.
+bool parseMeminfo(const QByteArray &data, memoryState &state);
+// Parse a value from a cgroup file (memory.max, memory.current, ...). "max" (no limit) and invalid values return -1.
+int64_t parseCgroupValue(const QByteArray &data);
+
+// Read the current state of the system memory. This reads a few small files from /proc and /sys so it is cheap
+// enough to be called once per second.
+memoryState readMemoryState();
+
+struct cacheBudget
+{
+  int64_t bytes {0};
+  // A human readable reason why the budget has this size (shown in the cache info panel)
+  QString reason;
+  // Is the budget lower than the threshold because memory is running low?
+  bool underPressure {false};
+};
+
+// Get the budget for the video cache. The threshold from the settings is the upper limit. If memory is running low,
+// the budget is reduced so that a reserve of memory stays free for the rest of the system. cacheLevelCurrent is the
+// memory currently used by the cache (which could be freed to make room).
+cacheBudget getCacheBudget(const memoryState &state, int64_t cacheLevelCurrent, int64_t cacheLevelThreshold);
+
+} // namespace systemMemory
@@ -0,0 +1,276 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "taskPool.h"
+
+#include <algorithm>
+#include <QThread>
+
+// Activate this if you want to know which thread runs/steals which task.
+#define TASKPOOL_DEBUG_OUTPUT 0
+#if TASKPOOL_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_TASKPOOL qDebug
+#else
+#define DEBUG_TASKPOOL(fmt,...) ((void)0)
+#endif
+
+struct taskPool::task
+{
+  std::function<void()> function;
+  taskPriority priority;
+  // 0: queued, 1: running, 2: done
+  QAtomicInt state {0};
+  QMutex mutex;
+  QWaitCondition finished;
+
+  // A task is either run by a thread of the pool or by a thread that waits for it. Only one of them can claim it.
+  bool claim() { return state.testAndSetOrdered(0, 1); }
+  void run()
+  {
+    function();
+    QMutexLocker lock(&mutex);
+    state.storeRelease(2);
+    finished.wakeAll();
+  }
+};
+
+namespace
+{
+
+int laneIndex(taskPriority priority)
+{
+  return (priority == taskPriority::interactive) ? 0 : 1;
+}
+
+} // namespace
+
+class taskPool::workerThread : public QThread
+{
+public:
+  workerThread(taskPool *pool, int index) : pool(pool), index(index) {}
+
+  void push(const std::shared_ptr<task> &t)
+  {
+    QMutexLocker lock(&queueMutex);
+    queues[laneIndex(t->priority)].push_back(t);
+  }
+  // The owner of the queue takes the newest task (it is most likely still in the cache of the CPU) ...
+  bool popNewest(int lane, std::shared_ptr<task> &t) { return pop(lane, true, t); }
+  // ... while other threads steal the oldest one
+  bool popOldest(int lane, std::shared_ptr<task> &t) { return pop(lane, false, t); }
+
+  taskPool *const pool;
+  const int index;
+
+protected:
+  void run() Q_DECL_OVERRIDE;
+
+private:
+  bool pop(int lane, bool newest, std::shared_ptr<task> &t)
+  {
+    QMutexLocker lock(&queueMutex);
+    auto &queue = queues[lane];
+    while (!queue.empty())
+    {
+      if (newest)
+      {
+        t = queue.back();
+        queue.pop_back();
+      }
+      else
+      {
+        t = queue.front();
+        queue.pop_front();
+      }
+      pool->nrQueuedTasks.fetchAndSubOrdered(1);
+      // Tasks that are already run by a waiting thread are skipped
+      if (t->claim())
+        return true;
+    }
+    return false;
+  }
+
+  QMutex queueMutex;
+  std::deque<std::shared_ptr<task>> queues[2];
+};
+
+thread_local taskPool::workerThread *taskPool::currentWorker = nullptr;
+thread_local taskPriority taskPool::currentPriority = taskPriority::interactive;
+
+void taskPool::workerThread::run()
+{
+  currentWorker = this;
+  QThread::Priority threadPriority = QThread::InheritPriority;
+  while (true)
+  {
+    std::shared_ptr<task> t;
+    if (!pool->takeTask(this, t))
+    {
+      QMutexLocker lock(&pool->sleepMutex);
+      while (pool->nrQueuedTasks.loadAcquire() <= 0 && !pool->quitting)
+        pool->workAvailable.wait(&pool->sleepMutex);
+      if (pool->quitting)
+        return;
+      continue;
+    }
+
+    // Background tasks should not interrupt normal operation. Interactive tasks run with a higher priority.
+    const QThread::Priority taskThreadPriority = (t->priority == taskPriority::interactive) ? QThread::HighPriority : QThread::LowestPriority;
+    if (taskThreadPriority != threadPriority)
+    {
+      setPriority(taskThreadPriority);
+      threadPriority = taskThreadPriority;
+    }
+
+    currentPriority = t->priority;
+    t->run();
+  }
+}
+
+bool taskPool::taskHandle::isRunning() const
+{
+  return t && t->state.loadAcquire() != 2;
+}
+
+void taskPool::taskHandle::waitForFinished()
+{
+  if (!t)
+    return;
+  if (t->claim())
+  {
+    // Nobody started the task yet. Don't wait for a thread to pick it up.
+    t->run();
+    return;
+  }
+  QMutexLocker lock(&t->mutex);
+  while (t->state.loadAcquire() != 2)
+    t->finished.wait(&t->mutex);
+}
+
+bool taskPool::taskHandle::cancel()
+{
+  if (!t || !t->claim())
+    return false;
+  // The task stays in the queue until a thread pops it. It can not be claimed again, so it is skipped then.
+  QMutexLocker lock(&t->mutex);
+  t->state.storeRelease(2);
+  t->finished.wakeAll();
+  return true;
+}
+
+taskPool &taskPool::instance()
+{
+  static taskPool pool;
+  return pool;
+}
+
+taskPool::taskPool()
+{
+  // Two more threads than cores. While all cores are busy with background work, interactive tasks do not have to
+  // wait for a background task to finish.
+  reserveThreads(QThread::idealThreadCount() + 2);
+}
+
+taskPool::~taskPool()
+{
+  {
+    QMutexLocker lock(&sleepMutex);
+    quitting = true;
+    workAvailable.wakeAll();
+  }
+  const int n = nrWorkers.loadAcquire();
+  for (int i = 0; i < n; i++)
+  {
+    workers[i]->wait();
+    delete workers[i];
+  }
+}
+
+void taskPool::reserveThreads(int nrThreads)
+{
+  QMutexLocker lock(&reserveMutex);
+  nrThreads = std::min(nrThreads, maxNrWorkers);
+  for (int i = nrWorkers.loadAcquire(); i < nrThreads; i++)
+  {
+    workers[i] = new workerThread(this, i);
+    workers[i]->start();
+    nrWorkers.storeRelease(i + 1);
+    DEBUG_TASKPOOL("taskPool::reserveThreads Started thread %d", i);
+  }
+}
+
+taskPool::taskHandle taskPool::submit(const std::function<void()> &function, taskPriority priority)
+{
+  auto t = std::make_shared<task>();
+  t->function = function;
+  t->priority = priority;
+
+  // Tasks that are submitted from a task go to the queue of the same thread. Other tasks are distributed.
+  workerThread *worker = currentWorker;
+  if (worker == nullptr || worker->pool != this)
+    worker = workers[unsigned(nextWorker.fetchAndAddRelaxed(1)) % unsigned(nrWorkers.loadAcquire())];
+
+  nrQueuedTasks.fetchAndAddOrdered(1);
+  worker->push(t);
+  {
+    QMutexLocker lock(&sleepMutex);
+    workAvailable.wakeOne();
+  }
+  return taskHandle(t);
+}
+
+taskPriority taskPool::getCurrentPriority()
+{
+  return currentPriority;
+}
+
+bool taskPool::takeTask(workerThread *worker, std::shared_ptr<task> &t)
+{
+  // All interactive tasks of all threads are taken before any background task.
+  const int n = nrWorkers.loadAcquire();
+  for (int lane = 0; lane < 2; lane++)
+  {
+    if (worker->popNewest(lane, t))
+      return true;
+    for (int i = 1; i < n; i++)
+    {
+      if (workers[(worker->index + i) % n]->popOldest(lane, t))
+      {
+        DEBUG_TASKPOOL("taskPool::takeTask Thread %d stole a task from thread %d", worker->index, (worker->index + i) % n);
+        return true;
+      }
+    }
+  }
+  return false;
+}
@@ -0,0 +1,115 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+
+// The priority lane of a task. Interactive tasks (the user waits for the result) are always taken before background
+// tasks (caching, compression, parsing of files).
+enum class taskPriority
+{
+  interactive,
+  background
+};
+
+// A pool of threads that is shared by everything that runs in the background (loading and caching of frames, the
+// parallel conversion of frames, the compression of cached frames and the parsers of statistics files).
+// Each thread has its own queue of tasks for each priority lane. Tasks that are submitted from within a task are put
+// into the queue of the thread that runs the task. A thread that runs out of work takes tasks from the queues of the
+// other threads (work stealing). Threads without work sleep until new tasks are submitted.
+class taskPool
+{
+public:
+  struct task;
+
+  // Similar to a QFuture, this can be used to check if a task is done or to wait for it to finish.
+  class taskHandle
+  {
+  public:
+    taskHandle() {}
+    // Is the task still queued or running?
+    bool isRunning() const;
+    // Wait until the task is done. If the task was not started yet, it is run in the calling thread.
+    void waitForFinished();
+    // Drop the task if it was not started yet. It will never run then. Return false if the task is already running
+    // or done (this does not wait for it).
+    bool cancel();
+  private:
+    friend class taskPool;
+    taskHandle(std::shared_ptr<task> t) : t(t) {}
+    std::shared_ptr<task> t;
+  };
+
+  static taskPool &instance();
+
+  taskHandle submit(const std::function<void()> &function, taskPriority priority = taskPriority::background);
+
+  // Make sure that the pool has at least the given number of threads. The pool never shrinks.
+  void reserveThreads(int nrThreads);
+  int getNrThreads() const { return nrWorkers.loadAcquire(); }
+
+  // The priority of the task that is running in the calling thread. If the calling thread is not a thread of the
+  // pool, this is interactive (e.g. the main thread which converts a frame that is drawn).
+  static taskPriority getCurrentPriority();
+
+private:
+  taskPool();
+  ~taskPool();
+
+  class workerThread;
+  // Get the next task for the given worker. First from its own queue, then from the queues of the other workers.
+  bool takeTask(workerThread *worker, std::shared_ptr<task> &t);
+
+  // The worker that runs in the calling thread (if it is a thread of a pool) and the priority of its current task
+  static thread_local workerThread *currentWorker;
+  static thread_local taskPriority currentPriority;
+
+  static const int maxNrWorkers = 256;
+  workerThread *workers[maxNrWorkers];
+  QAtomicInt nrWorkers {0};
+  QMutex reserveMutex;
+  // The worker that gets the next task that is not submitted from a thread of the pool
+  QAtomicInt nextWorker {0};
+
+  // Threads without work wait for this condition
+  QMutex sleepMutex;
+  QWaitCondition workAvailable;
+  QAtomicInt nrQueuedTasks {0};
+  bool quitting {false};
+};
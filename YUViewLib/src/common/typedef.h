@@ -107,8 +107,23 @@ const bool is_Q_OS_LINUX = false;
 // However, it is not yet clear what to do if the user wants/needs a second instance.
 #define WIN_LINUX_SINGLE_INSTANCE 0
 
-// Activate SSE YUV conversion
-// Do not activate. This is not supported right now.
+// SIMD code paths (SSE4.1/AVX2) are only compiled for x86 targets. Which one is used is decided
+// at runtime depending on the instruction sets that the CPU supports (see functions::cpuSupportsAVX2()).
+// With gcc/clang, the functions using the intrinsics must be marked with the target instruction set
+// so that the rest of the code can still be compiled for the baseline architecture.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#else
+#define SIMD_X86 0
+#endif
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET(instructionSet) __attribute__((target(instructionSet)))
+#else
+#define SIMD_TARGET(instructionSet)
+#endif
+
+// Aligned buffers for the decoders and file reading.
+// Do not activate. This is not supported right now. The YUV conversion uses the runtime dispatched SIMD kernels.
 #define SSE_CONVERSION 0
 #if SSE_CONVERSION
 
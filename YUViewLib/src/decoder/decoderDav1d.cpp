@@ -38,6 +38,7 @@
 #include <QDir>
 #include <QSettings>
 
+#include "common/frameBufferPool.h"
 #include "common/typedef.h"
 
 using namespace YUView;
@@ -430,9 +431,8 @@ void decoderDav1d::copyImgToByteArray(const Dav1dPictureWrapper &src, QByteArray
 
   DEBUG_DAV1D("decoderDav1d::copyImgToByteArray nrBytes %d", nrBytes);
 
-  // Is the output big enough?
-  if (dst.capacity() < nrBytes)
-   dst.resize(nrBytes);
+  // Is the output big enough? The buffers of frames that were removed from the cache are reused.
+  frameBufferPool::instance().prepareByteArray(dst, nrBytes);
 
   uint8_t *dst_c = (uint8_t*)dst.data();
 
@@ -32,6 +32,8 @@
 
 #include "decoderFFmpeg.h"
 
+#include "common/frameBufferPool.h"
+
 #define DECODERFFMPEG_DEBUG_OUTPUT 0
 #if DECODERFFMPEG_DEBUG_OUTPUT && !NDEBUG
 #include <QDebug>
@@ -181,9 +183,8 @@ void decoderFFmpeg::copyCurImageToBuffer()
     const int nrBytesC = frameSize.width() / pixFmt.getSubsamplingHor() * frameSize.height() / pixFmt.getSubsamplingVer() * nrBytesPerSample;
     const int nrBytes = nrBytesY + 2 * nrBytesC;
 
-    // Is the output big enough?
-    if (currentOutputBuffer.capacity() < nrBytes)
-      currentOutputBuffer.resize(nrBytes);
+    // Is the output big enough? The buffer may still be used by the cache (if so, it is replaced).
+    frameBufferPool::instance().prepareByteArray(currentOutputBuffer, nrBytes);
 
     // Copy line by line. The linesize of the source may be larger than the width of the frame.
     // This may be because the frame buffer is (8) byte aligned. Also the internal decoded
@@ -227,9 +228,8 @@ void decoderFFmpeg::copyCurImageToBuffer()
     const int nrBytesPerComponent = frameSize.width() * frameSize.height() * nrBytesPerSample;
     const int nrBytes = 3 * nrBytesPerComponent;
 
-    // Is the output big enough?
-    if (currentOutputBuffer.capacity() < nrBytes)
-      currentOutputBuffer.resize(nrBytes);
+    // Is the output big enough? The buffer may still be used by the cache (if so, it is replaced).
+    frameBufferPool::instance().prepareByteArray(currentOutputBuffer, nrBytes);
 
     char* dst = currentOutputBuffer.data();
     int hDst = frameSize.height();
@@ -37,6 +37,7 @@
 #include <QDir>
 #include <QSettings>
 
+#include "common/frameBufferPool.h"
 #include "common/typedef.h"
 
 // Debug the decoder ( 0:off 1:interactive deocder only 2:caching decoder only 3:both)
@@ -340,9 +341,8 @@ void decoderHM::copyImgToByteArray(libHMDec_picture *src, QByteArray &dst)
   int nrBytesOutput = (outSizeY + outSizeCb + outSizeCr) * (outputTwoByte ? 2 : 1);
   DEBUG_DECHM("decoderHM::copyImgToByteArray nrBytesOutput %d", nrBytesOutput);
 
-  // Is the output big enough?
-  if (dst.capacity() < nrBytesOutput)
-    dst.resize(nrBytesOutput);
+  // Is the output big enough? The buffers of frames that were removed from the cache are reused.
+  frameBufferPool::instance().prepareByteArray(dst, nrBytesOutput);
 
   // The source (from HM) is always short (16bit). The destination is a QByteArray so
   // we have to cast it right.
@@ -37,6 +37,7 @@
 #include <QDir>
 #include <QSettings>
 
+#include "common/frameBufferPool.h"
 #include "common/typedef.h"
 
 using namespace YUView;
@@ -410,9 +411,8 @@ void decoderLibde265::copyImgToByteArray(const de265_image *src, QByteArray &dst
 
   DEBUG_LIBDE265("decoderLibde265::copyImgToByteArray nrBytes %d", nrBytes);
 
-  // Is the output big enough?
-  if (dst.capacity() < nrBytes)
-    dst.resize(nrBytes);
+  // Is the output big enough? The buffers of frames that were removed from the cache are reused.
+  frameBufferPool::instance().prepareByteArray(dst, nrBytes);
 
   uint8_t *dst_c = (uint8_t*)dst.data();
 
@@ -32,16 +32,41 @@
 
 #include "fileSource.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QRegExp>
 #include <QSettings>
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#endif
 
+#include "common/frameBufferPool.h"
 #include "common/typedef.h"
- 
+
+#define FILESOURCE_DEBUG_OUTPUT 0
+#if FILESOURCE_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_FILESOURCE qDebug
+#else
+#define DEBUG_FILESOURCE(fmt,...) ((void)0)
+#endif
+
+// The alignment of the position, the size and the buffer of reads with direct I/O. This is the page size and a
+// multiple of the logical block size of common file systems.
+#define DIRECT_IO_ALIGNMENT 4096
+
 #define FILESOURCE_DEBUG_SIMULATESLOWLOADING 0
 #if FILESOURCE_DEBUG_SIMULATESLOWLOADING && !NDEBUG
 #include <QThread>
@@ -55,6 +80,14 @@ fileSource::fileSource()
   connect(&fileWatcher, &QFileSystemWatcher::fileChanged, this, &fileSource::fileSystemWatcherFileChanged);
 }
 
+fileSource::~fileSource()
+{
+  // Deleting the QFiles removes the mappings
+  delete currentMapping;
+  qDeleteAll(oldMappings);
+  closeDirectIOFile();
+}
+
 bool fileSource::openFile(const QString &filePath)
 {
   // Check if the file exists
@@ -64,6 +97,14 @@ bool fileSource::openFile(const QString &filePath)
 
   if (isFileOpened && srcFile.isOpen())
     srcFile.close();
+  // The file may have changed. A new mapping is created if updateMemoryMappingSetting is called again.
+  mappingMutex.lock();
+  retireCurrentMapping();
+  mappingMutex.unlock();
+  closeDirectIOFile();
+  readStatBytes.storeRelease(0);
+  readStatNrCalls.storeRelease(0);
+  readStatNanoseconds.storeRelease(0);
 
   // open file for reading
   srcFile.setFileName(filePath);
@@ -102,17 +143,266 @@ int64_t fileSource::readBytes(QByteArray &targetBuffer, int64_t startPos, int64_
   if(!isOk())
     return 0;
 
-  if (targetBuffer.size() < nrBytes)
-    targetBuffer.resize(nrBytes);
+  // If the target is still used somewhere else (e.g. in the cache), read into a buffer from the pool instead
+  frameBufferPool::instance().prepareByteArray(targetBuffer, int(nrBytes));
 
 #if FILESOURCE_DEBUG_SIMULATESLOWLOADING && !NDEBUG
   QThread::msleep(50);
 #endif
 
-  // lock the seek and read function
-  QMutexLocker locker(&readMutex);
-  srcFile.seek(startPos);
-  return srcFile.read(targetBuffer.data(), nrBytes);
+  QElapsedTimer readTimer;
+  readTimer.start();
+
+  int64_t nrBytesRead = -1;
+#ifdef Q_OS_LINUX
+  if (isDirectIO())
+  {
+    nrBytesRead = readBytesDirectIO(targetBuffer.data(), startPos, nrBytes);
+    // Don't try again if direct I/O does not work for this file
+    if (nrBytesRead < 0)
+    {
+      directIOFailed.storeRelease(1);
+      useDirectIO.storeRelease(0);
+    }
+  }
+#endif
+
+  // Read normally if direct I/O is not used or if it failed
+  if (nrBytesRead < 0)
+  {
+#ifdef Q_OS_UNIX
+    // Positional read directly from the file descriptor. This does not touch the file position (or the buffer) of
+    // the QFile, so no lock is needed.
+    const int fd = srcFile.handle();
+    nrBytesRead = 0;
+    while (nrBytesRead < nrBytes)
+    {
+      const ssize_t n = pread(fd, targetBuffer.data() + nrBytesRead, size_t(nrBytes - nrBytesRead), off_t(startPos + nrBytesRead));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        break;
+      nrBytesRead += n;
+    }
+#else
+    // lock the seek and read function
+    QMutexLocker locker(&readMutex);
+    srcFile.seek(startPos);
+    nrBytesRead = qMax(srcFile.read(targetBuffer.data(), nrBytes), qint64(0));
+#endif
+  }
+
+  readStatNanoseconds.fetchAndAddRelaxed(readTimer.nsecsElapsed());
+  readStatBytes.fetchAndAddRelaxed(nrBytesRead);
+  readStatNrCalls.fetchAndAddRelaxed(1);
+
+  return nrBytesRead;
+}
+
+#ifdef Q_OS_LINUX
+int64_t fileSource::readBytesDirectIO(char *target, int64_t startPos, int64_t nrBytes)
+{
+  // With O_DIRECT, the position and size of the read and the address of the buffer must be aligned to the block size
+  // of the file system. Read the aligned range that contains the requested bytes into aligned memory from the pool
+  // and copy the requested bytes from there.
+  const int64_t alignedStart = startPos & ~int64_t(DIRECT_IO_ALIGNMENT - 1);
+  const int64_t alignedEnd = (startPos + nrBytes + DIRECT_IO_ALIGNMENT - 1) & ~int64_t(DIRECT_IO_ALIGNMENT - 1);
+  const int64_t alignedSize = alignedEnd - alignedStart;
+
+  frameBufferPool &pool = frameBufferPool::instance();
+  frameBufferPool::alignedMemory memory = pool.getAlignedMemory(alignedSize, DIRECT_IO_ALIGNMENT);
+  if (memory.isNull())
+    return -1;
+
+  int64_t nrAlignedBytesRead = 0;
+  while (nrAlignedBytesRead < alignedSize)
+  {
+    const ssize_t n = pread(directIOFile, memory.data() + nrAlignedBytesRead, size_t(alignedSize - nrAlignedBytesRead), off_t(alignedStart + nrAlignedBytesRead));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+    {
+      // E.g. the file system does not support the alignment. Read without direct I/O.
+      DEBUG_FILESOURCE("fileSource::readBytesDirectIO pread failed (errno %d)", errno);
+      pool.release(memory, alignedSize, DIRECT_IO_ALIGNMENT);
+      return -1;
+    }
+    if (n == 0)
+      break;
+    nrAlignedBytesRead += n;
+  }
+
+  // At the end of the file, fewer bytes than requested are read
+  const int64_t offset = startPos - alignedStart;
+  const int64_t nrBytesRead = qBound(int64_t(0), nrAlignedBytesRead - offset, nrBytes);
+  if (nrBytesRead > 0)
+    std::memcpy(target, memory.data() + offset, size_t(nrBytesRead));
+  pool.release(memory, alignedSize, DIRECT_IO_ALIGNMENT);
+  return nrBytesRead;
+}
+#endif
+
+bool fileSource::getMappedView(QByteArray &view, int64_t startPos, int64_t nrBytes) const
+{
+  QMutexLocker lock(&mappingMutex);
+  releaseUnusedMappings();
+  fileMapping *mapping = currentMapping;
+  if (mapping == nullptr || startPos < 0 || nrBytes <= 0 || startPos + nrBytes > mapping->size || nrBytes > std::numeric_limits<int>::max())
+    return false;
+
+  const uchar *data = mapping->data + startPos;
+#ifdef Q_OS_LINUX
+  // Tell the kernel that these pages are needed now so that it starts reading them from disk
+  static const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+  const uintptr_t start = uintptr_t(data) & ~(pageSize - 1);
+  madvise(reinterpret_cast<void*>(start), uintptr_t(data) + nrBytes - start, MADV_WILLNEED);
+#endif
+
+  view = QByteArray::fromRawData(reinterpret_cast<const char*>(data), int(nrBytes));
+  mapping->views.append(view);
+  return true;
+}
+
+bool fileSource::isMemoryMapped() const
+{
+  QMutexLocker lock(&mappingMutex);
+  return currentMapping != nullptr;
+}
+
+void fileSource::retireCurrentMapping()
+{
+  if (currentMapping != nullptr)
+    oldMappings.append(currentMapping);
+  currentMapping = nullptr;
+  releaseUnusedMappings();
+}
+
+void fileSource::releaseUnusedMappings() const
+{
+  auto isUnused = [](const QByteArray &view) { return view.isDetached(); };
+  if (currentMapping != nullptr)
+    currentMapping->views.erase(std::remove_if(currentMapping->views.begin(), currentMapping->views.end(), isUnused), currentMapping->views.end());
+  for (auto it = oldMappings.begin(); it != oldMappings.end();)
+  {
+    fileMapping *mapping = *it;
+    mapping->views.erase(std::remove_if(mapping->views.begin(), mapping->views.end(), isUnused), mapping->views.end());
+    if (mapping->views.isEmpty())
+    {
+      DEBUG_FILESOURCE("fileSource::releaseUnusedMappings Unmapping an old mapping");
+      // Deleting the QFile removes the mapping
+      delete mapping;
+      it = oldMappings.erase(it);
+    }
+    else
+      ++it;
+  }
+}
+
+void fileSource::readAhead(int64_t startPos, int64_t nrBytes) const
+{
+  if (!isFileOpened || startPos < 0 || nrBytes <= 0)
+    return;
+
+#if defined(Q_OS_LINUX)
+  // With direct I/O the data is not read from the file cache
+  if (isDirectIO())
+    return;
+  QMutexLocker lock(&mappingMutex);
+  const fileMapping *mapping = currentMapping;
+  if (mapping != nullptr)
+  {
+    if (startPos >= mapping->size)
+      return;
+    static const int64_t pageSize = int64_t(sysconf(_SC_PAGESIZE));
+    const int64_t start = startPos & ~(pageSize - 1);
+    const int64_t end = qMin(startPos + nrBytes, mapping->size);
+    madvise(const_cast<uchar*>(mapping->data) + start, size_t(end - start), MADV_WILLNEED);
+  }
+  else
+    posix_fadvise(srcFile.handle(), off_t(startPos), off_t(nrBytes), POSIX_FADV_WILLNEED);
+#elif defined(Q_OS_MACOS)
+  // The mapping (if any) is backed by the same file, so reading ahead on the file also helps the mapped view
+  struct radvisory advice;
+  advice.ra_offset = off_t(startPos);
+  advice.ra_count = int(qMin(nrBytes, int64_t(std::numeric_limits<int>::max())));
+  fcntl(srcFile.handle(), F_RDADVISE, &advice);
+#else
+  // Windows reads ahead by itself if a file is read sequentially
+  Q_UNUSED(startPos);
+  Q_UNUSED(nrBytes);
+#endif
+}
+
+void fileSource::updateDirectIOSetting()
+{
+  QSettings settings;
+  if (!settings.value("DirectIORawFiles", false).toBool() || !isFileOpened || directIOFailed.loadAcquire() != 0)
+  {
+    // The descriptor stays open (if it was opened) and is used again if direct I/O is enabled again
+    useDirectIO.storeRelease(0);
+    return;
+  }
+  if (isDirectIO())
+    return;
+
+#ifdef Q_OS_LINUX
+  if (directIOFile < 0)
+  {
+    // Open the file a second time with O_DIRECT. This fails if the file system does not support direct I/O.
+    directIOFile = ::open(QFile::encodeName(fullFilePath).constData(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+    DEBUG_FILESOURCE("fileSource::updateDirectIOSetting open with O_DIRECT %s", directIOFile >= 0 ? "succeeded" : "failed");
+    if (directIOFile < 0)
+    {
+      directIOFailed.storeRelease(1);
+      return;
+    }
+  }
+  useDirectIO.storeRelease(1);
+  // The file may be mapped already. Reading from the mapping would use the file cache again.
+  QMutexLocker lock(&mappingMutex);
+  retireCurrentMapping();
+#endif
+}
+
+void fileSource::closeDirectIOFile()
+{
+  useDirectIO.storeRelease(0);
+  directIOFailed.storeRelease(0);
+#ifdef Q_OS_LINUX
+  if (directIOFile >= 0)
+    ::close(directIOFile);
+#endif
+  directIOFile = -1;
+}
+
+void fileSource::updateMemoryMappingSetting()
+{
+  QSettings settings;
+  QMutexLocker lock(&mappingMutex);
+  // Reading from the mapping goes through the file cache of the system. This is what direct I/O avoids.
+  // A watched file may be changed (or truncated) by another application while it is mapped. See the header.
+  if (!settings.value("MemoryMapFiles", false).toBool() || settings.value("WatchFiles", true).toBool() || isDirectIO() || !isFileOpened)
+  {
+    retireCurrentMapping();
+    return;
+  }
+  if (currentMapping != nullptr)
+    return;
+
+  // Map the whole file. This fails for empty files or if there is not enough address space (32 bit builds).
+  fileMapping *mapping = new fileMapping;
+  mapping->file.setFileName(fullFilePath);
+  if (mapping->file.open(QIODevice::ReadOnly))
+  {
+    mapping->size = mapping->file.size();
+    mapping->data = (mapping->size > 0) ? mapping->file.map(0, mapping->size) : nullptr;
+  }
+  if (mapping->data == nullptr)
+  {
+    delete mapping;
+    return;
+  }
+  currentMapping = mapping;
 }
 
 QList<infoItem> fileSource::getFileInfoList() const
@@ -137,6 +427,25 @@ QList<infoItem> fileSource::getFileInfoList() const
   QString fileSize = QString("%1").arg(fileInfo.size());
   infoList.append(infoItem("Nr Bytes", fileSize));
 
+  if (isDirectIO())
+    infoList.append(infoItem("Read Mode", "Direct I/O"));
+  else if (isMemoryMapped())
+    infoList.append(infoItem("Read Mode", "Memory mapped"));
+
+  // The amount of data read so far and the read throughput
+  const qint64 nrCalls = readStatNrCalls.loadAcquire();
+  if (nrCalls > 0)
+  {
+    const qint64 nrBytes = readStatBytes.loadAcquire();
+    const qint64 nanoseconds = readStatNanoseconds.loadAcquire();
+    infoList.append(infoItem("Bytes Read", QString("%1 MB in %2 reads").arg(double(nrBytes) / 1000000, 0, 'f', 1).arg(nrCalls)));
+    if (nanoseconds > 0)
+    {
+      const double mbPerSecond = double(nrBytes) * 1000 / nanoseconds;
+      infoList.append(infoItem("Read Throughput", QString("%1 MB/s").arg(mbPerSecond, 0, 'f', 1), "The average throughput of one read from the file. The reads of multiple threads may run in parallel."));
+    }
+  }
+
   return infoList;
 }
 
@@ -326,7 +635,7 @@ void fileSource::clearFileCache()
   if (!isFileOpened)
     return;
 
-#ifdef Q_OS_WIN
+#if defined(Q_OS_WIN)
   // We will close the QFile, open it using the FILE_FLAG_NO_BUFFERING flags, close it and reopen the QFile.
   // Suggested: http://stackoverflow.com/questions/478340/clear-file-cache-to-repeat-performance-testing
   QMutexLocker locker(&readMutex);
@@ -338,5 +647,13 @@ void fileSource::clearFileCache()
 
   srcFile.setFileName(fullFilePath);
   srcFile.open(QIODevice::ReadOnly);
+#elif defined(Q_OS_LINUX)
+  // Drop the pages of the file from the file cache. Pages that are mapped into memory are not dropped, so remove
+  // them from the mapping first. They are read from the file again on the next access.
+  QMutexLocker lock(&mappingMutex);
+  const fileMapping *mapping = currentMapping;
+  if (mapping != nullptr)
+    madvise(const_cast<uchar*>(mapping->data), size_t(mapping->size), MADV_DONTNEED);
+  posix_fadvise(srcFile.handle(), 0, 0, POSIX_FADV_DONTNEED);
 #endif
 }
@@ -32,6 +32,7 @@
 
 #pragma once
 
+#include <QAtomicInteger>
 #include <QFile>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
@@ -52,6 +53,7 @@ class fileSource : public QObject
 
 public:
   fileSource();
+  ~fileSource();
 
   // Try to open the given file and install a watcher for the file.
   virtual bool openFile(const QString &filePath);
@@ -89,11 +91,36 @@ public:
 
   // Read the given number of bytes starting at startPos into the QByteArray out
   // Resize the QByteArray if necessary. Return how many bytes were read.
+  // On unix systems, the data is read with pread which does not use the shared file position. So multiple threads
+  // (e.g. the caching workers) can read different parts of the same file in parallel. Other systems seek and read
+  // while holding a lock.
   int64_t readBytes(QByteArray &targetBuffer, int64_t startPos, int64_t nrBytes);
 #if SSE_CONVERSION
   void readBytes(byteArrayAligned &data, int64_t startPos, int64_t nrBytes);
 #endif
 
+  // If the file is mapped into memory, get a read-only view of the given range of the file. The data of the returned
+  // QByteArray points directly into the mapped file, so nothing is copied. Writing to the view creates a copy. The
+  // mapping is kept (even if the file is opened again) until no copy of the view is used anymore.
+  // Returns false if the file is not mapped or the range is not in the file. Use readBytes then.
+  bool getMappedView(QByteArray &view, int64_t startPos, int64_t nrBytes) const;
+  bool isMemoryMapped() const;
+  // Map the file into memory if this is enabled in the settings. If mapping is not enabled or not possible, the
+  // file is read using readBytes. Files that are watched for changes (see updateFileWatchSetting) are not mapped:
+  // Accessing a mapping of a file that was truncated by another application crashes (SIGBUS). So the file must not
+  // be changed while it is mapped.
+  void updateMemoryMappingSetting();
+  // Read the file with direct I/O (bypassing the file cache of the system) if this is enabled in the settings.
+  // Only supported on Linux and if the file system supports it. If direct I/O is used, the file is not mapped.
+  // If opening the file for direct I/O or reading from it fails, direct I/O is not tried again for this file.
+  void updateDirectIOSetting();
+  bool isDirectIO() const { return useDirectIO.loadAcquire() != 0; }
+
+  // Tell the system that the given range of the file will be read soon. The data is read into the page cache in
+  // the background (Linux and macOS) so that a following readBytes (or access to the mapped view) does not have to
+  // wait for the disk. This does not block.
+  void readAhead(int64_t startPos, int64_t nrBytes) const;
+
   QString getAbsoluteFilePath() const { return fileInfo.absoluteFilePath(); }
 
   // Get the absolute path to the file (from absolute or relative path)
@@ -104,7 +131,7 @@ public:
   // Check if we are supposed to watch the file for changes. If no, remove the file watcher. If yes, install one.
   void updateFileWatchSetting();
 
-  // Clear the cache of the file in the system. Currently only windows supported.
+  // Clear the cache of the file in the system. Currently only supported on Windows and Linux.
   void clearFileCache();
 
 private slots:
@@ -124,6 +151,43 @@ private:
   QFileSystemWatcher fileWatcher;
   bool fileChanged;
 
-  // protect the read function with a mutex
+  // protect the read function with a mutex (if there is no positional read, see readBytes)
   QMutex readMutex;
+
+  // Statistics of readBytes for the info panel. The read time is summed up over all threads, so the throughput is
+  // the average throughput of one read call.
+  QAtomicInteger<qint64> readStatBytes {0};
+  QAtomicInteger<qint64> readStatNrCalls {0};
+  QAtomicInteger<qint64> readStatNanoseconds {0};
+
+  // A memory mapping of the whole file. It has its own QFile because closing the srcFile would remove the mapping.
+  struct fileMapping
+  {
+    QFile file;
+    const uchar *data {nullptr};
+    int64_t size {0};
+    // A copy of each view that was handed out. If the copy is detached, the view is not used anymore.
+    QList<QByteArray> views;
+  };
+  // The current mapping (if any). If the file is opened again, the old mapping is kept until no view of it is used
+  // anymore. The mutex protects the mappings and the lists of views.
+  mutable QMutex mappingMutex;
+  fileMapping *currentMapping {nullptr};
+  mutable QList<fileMapping*> oldMappings;
+  // Stop using the current mapping for new views. The mutex must be locked.
+  void retireCurrentMapping();
+  // Forget the views that are not used anymore and unmap the old mappings without views. The mutex must be locked.
+  void releaseUnusedMappings() const;
+
+  // The file is opened for direct I/O (O_DIRECT) at most once. The descriptor is only closed when the file is opened
+  // again or the fileSource is destroyed (like srcFile). useDirectIO switches between direct I/O and normal reads.
+  int directIOFile {-1};
+  QAtomicInt useDirectIO {0};
+  // Opening the file with O_DIRECT or a read failed. Don't try again until the file is opened again.
+  QAtomicInt directIOFailed {0};
+  void closeDirectIOFile();
+#ifdef Q_OS_LINUX
+  // Read the bytes using direct I/O. Return -1 if this failed.
+  int64_t readBytesDirectIO(char *target, int64_t startPos, int64_t nrBytes);
+#endif
 };
@@ -32,6 +32,8 @@
 
 #include "fileSourceAnnexBFile.h"
 
+#include "filesource/startCodeScanner.h"
+
 #define ANNEXBFILE_DEBUG_OUTPUT 0
 #if ANNEXBFILE_DEBUG_OUTPUT && !NDEBUG
 #include <QDebug>
@@ -43,11 +45,6 @@
 fileSourceAnnexBFile::fileSourceAnnexBFile()
 {
   fileBuffer.resize(BUFFER_SIZE);
-  
-  // Set the start code to look for (0x00 0x00 0x01)
-  startCode.append((char)0);
-  startCode.append((char)0);
-  startCode.append((char)1);
 }
 
 // Open the file and fill the read buffer. 
@@ -59,6 +56,8 @@ bool fileSourceAnnexBFile::openFile(const QString &fileName)
   fileSource::openFile(fileName);
 
   // Fill the buffer
+  bufferStartPosInFile = 0;
+  posInBuffer = 0;
   fileBufferSize = srcFile.read(fileBuffer.data(), BUFFER_SIZE);
   if (fileBufferSize == 0)
     // The file is empty of there was an error reading from the file.
@@ -71,7 +70,7 @@ bool fileSourceAnnexBFile::openFile(const QString &fileName)
 
 void fileSourceAnnexBFile::seekToFirstNAL()
 {
-  int nextStartCodePos = fileBuffer.indexOf(startCode, posInBuffer);
+  int nextStartCodePos = findStartCodeInBuffer(posInBuffer);
   if (nextStartCodePos == -1)
     // The first buffer does not contain a start code. This is very unusual. Use the normal getNextNALUnit to seek
     getNextNALUnit();
@@ -97,11 +96,13 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pa
 
   int nextStartCodePos = -1;
   bool startCodeFound = false;
+  // Skip the start code of the current NAL unit
+  int searchStartPos = int(posInBuffer) + 3;
   while (!startCodeFound)
   {
-    nextStartCodePos = fileBuffer.indexOf(startCode, posInBuffer + 3);
+    nextStartCodePos = findStartCodeInBuffer(searchStartPos);
 
-    if (nextStartCodePos < 0 || (uint64_t)nextStartCodePos > fileBufferSize)
+    if (nextStartCodePos < 0)
     {
       // No start code found ... append all data in the current buffer.
       lastReturnArray += fileBuffer.mid(posInBuffer, fileBufferSize - posInBuffer);
@@ -121,8 +122,9 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pa
       const bool lastByteZero1 = fileBuffer.at(fileBufferSize - 2) == (char)0;
       const bool lastByteZero2 = fileBuffer.at(fileBufferSize - 1) == (char)0;
 
-      // We have to continue searching - get the next buffer
+      // We have to continue searching - get the next buffer. Search it from the start.
       updateBuffer();
+      searchStartPos = 0;
       
       if (fileBufferSize > 2)
       {
@@ -174,6 +176,8 @@ QByteArray fileSourceAnnexBFile::getFrameData(QUint64Pair startEndFilePos)
   
   uint64_t start = startEndFilePos.first;
   uint64_t end = startEndFilePos.second;
+  // All NAL units are appended. Only the added 0 bytes for 3 byte start codes are not included.
+  retArray.reserve(int(end - start + 1));
 
   // Seek the source file to the start position
   seek(start);
@@ -214,29 +218,48 @@ bool fileSourceAnnexBFile::updateBuffer()
   return (fileBufferSize > 0);
 }
 
+int fileSourceAnnexBFile::findStartCodeInBuffer(int startPos) const
+{
+  if (startPos < 0)
+    startPos = 0;
+  if (uint64_t(startPos) + 3 > fileBufferSize)
+    return -1;
+  const int64_t idx = getStartCodeScanner().findStartCode(fileBuffer.constData() + startPos, int64_t(fileBufferSize) - startPos);
+  return (idx < 0) ? -1 : startPos + int(idx);
+}
+
 bool fileSourceAnnexBFile::seek(int64_t pos)
 {
   if (!isFileOpened)
     return false;
 
   DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::seek ot %d", pos);
-  // Seek the file and update the buffer
-  srcFile.seek(pos);
-  fileBufferSize = srcFile.read(fileBuffer.data(), BUFFER_SIZE);
-  if (fileBufferSize == 0)
-    // The file is empty of there was an error reading from the file.
-    return false;
-  bufferStartPosInFile = pos;
-  posInBuffer = 0;
+  if (pos >= int64_t(bufferStartPosInFile) && uint64_t(pos) + 4 <= bufferStartPosInFile + fileBufferSize)
+  {
+    // The position is in the current buffer (e.g. the next frame in getFrameData). No need to read it again.
+    posInBuffer = (unsigned int)(pos - bufferStartPosInFile);
+  }
+  else
+  {
+    // Seek the file and update the buffer
+    srcFile.seek(pos);
+    fileBufferSize = srcFile.read(fileBuffer.data(), BUFFER_SIZE);
+    if (fileBufferSize == 0)
+      // The file is empty of there was an error reading from the file.
+      return false;
+    bufferStartPosInFile = pos;
+    posInBuffer = 0;
+  }
 
   if (pos == 0)
     seekToFirstNAL();
   else
   {
     // Check if we are at a start code position (001 or 0001)
-    if (fileBuffer.at(0) == (char)0 && fileBuffer.at(1) == (char)0 && fileBuffer.at(2) == (char)0 && fileBuffer.at(3) == (char)1)
+    const char *data = fileBuffer.constData() + posInBuffer;
+    if (data[0] == (char)0 && data[1] == (char)0 && data[2] == (char)0 && data[3] == (char)1)
       return true;
-    if (fileBuffer.at(0) == (char)0 && fileBuffer.at(1) == (char)0 && fileBuffer.at(2) == (char)1)
+    if (data[0] == (char)0 && data[1] == (char)0 && data[2] == (char)1)
       return true;
 
     DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::seek could not find start code at seek position");
@@ -72,7 +72,7 @@ public:
   // The data will be returned in the ISO/IEC 14496-15 format (4 bytes size followed by the payload).
   QByteArray getFrameData(QUint64Pair startEndFilePos);
   
-  // Seek the file to the given byte position. Update the buffer.
+  // Seek the file to the given byte position. Update the buffer (if the position is not in the current buffer).
   bool seek(int64_t pos) Q_DECL_OVERRIDE;
 
 protected:
@@ -85,12 +85,13 @@ protected:
   // So if the start code is 0001 it will point to the first byte (the first 0). If the start code is 001, it will point to the first 0 here.
   unsigned int posInBuffer {0};
 
-  // The start code pattern
-  QByteArray startCode;
-
   // load the next buffer
   bool updateBuffer();
 
+  // Find the next start code (0x000001) in the valid bytes of the buffer from the given position on.
+  // Return the position of the first 0 byte or -1 if there is no start code.
+  int findStartCodeInBuffer(int startPos) const;
+
   // Seek to the first NAL header in the bitstream
   void seekToFirstNAL();
 
@@ -32,6 +32,8 @@
 
 #include "fileSourceFFmpegFile.h"
 
+#include <algorithm>
+#include <climits>
 #include <QSettings>
 #include <QProgressDialog>
 
@@ -384,7 +386,7 @@ int fileSourceFFmpegFile::getClosestSeekableDTSBefore(int frameIdx, int &seekToF
   int bestSeekDTS = keyFrameList[0].dts;
   seekToFrameIdx = keyFrameList[0].frame;
 
-  for (pictureIdx idx : keyFrameList)
+  for (const pictureIdx &idx : keyFrameList)
   {
     if (idx.frame >= 0) 
     {
@@ -402,6 +404,38 @@ int fileSourceFFmpegFile::getClosestSeekableDTSBefore(int frameIdx, int &seekToF
   return bestSeekDTS;
 }
 
+QList<int> fileSourceFFmpegFile::getClosestSeekableFrameIndices(int nrFrames) const
+{
+  QList<int> seekFrames;
+  if (keyFrameList.isEmpty())
+    return seekFrames;
+
+  // A key frame is used by getClosestSeekableDTSBefore if the frame indices of all key frames up to it are not
+  // greater than the frame to seek to. This maximum never decreases.
+  QList<int> maxFrames;
+  QList<int> keyFrames;
+  maxFrames.append(INT_MIN);
+  keyFrames.append(keyFrameList[0].frame);
+  for (const pictureIdx &idx : keyFrameList)
+  {
+    if (idx.frame < 0)
+      continue;
+    maxFrames.append(std::max(maxFrames.last(), idx.frame));
+    keyFrames.append(idx.frame);
+  }
+
+  // For the frame indices in increasing order, the key frame to seek to only moves forward
+  seekFrames.reserve(nrFrames);
+  int k = 0;
+  for (int frameIdx = 0; frameIdx < nrFrames; frameIdx++)
+  {
+    while (k + 1 < maxFrames.size() && maxFrames[k + 1] <= frameIdx)
+      k++;
+    seekFrames.append(keyFrames[k]);
+  }
+  return seekFrames;
+}
+
 bool fileSourceFFmpegFile::scanBitstream(QWidget *mainWindow)
 {
   if (!isFileOpened)
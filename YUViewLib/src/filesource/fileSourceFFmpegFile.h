@@ -103,6 +103,9 @@ public:
   // Look through the keyframes and find the closest one before (or equal)
   // the given frameIdx where we can start decoding
   int getClosestSeekableDTSBefore(int frameIdx, int &seekToFrameIdx) const;
+  // Get the frame index that getClosestSeekableDTSBefore returns in seekToFrameIdx for all frames from 0 to nrFrames-1.
+  // The key frames are only scanned once.
+  QList<int> getClosestSeekableFrameIndices(int nrFrames) const;
 
   QStringList getFFmpegLoadingLog() const { return ff.getLog(); }
   
@@ -0,0 +1,161 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "startCodeScanner.h"
+
+#include "common/functions.h"
+#include "common/typedef.h"
+
+// SIMD_X86 is defined in typedef.h
+#if SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+
+// ------------------ Scalar (C++) implementation ------------------
+
+// Search from the given index to the end. Check the third byte of each possible start code first: If it is greater
+// than 1, there can be no start code that contains it and we can skip 3 bytes.
+int64_t findStartCodeFrom(const char *data, int64_t i, int64_t size)
+{
+  const unsigned char *p = (const unsigned char*)data;
+  while (i + 2 < size)
+  {
+    const unsigned char c = p[i + 2];
+    if (c > 1)
+      i += 3;
+    else if (c == 0)
+      i += 1;
+    else if (p[i] == 0 && p[i + 1] == 0)
+      return i;
+    else
+      i += 3;
+  }
+  return -1;
+}
+
+int64_t findStartCodeScalar(const char *data, int64_t size)
+{
+  return findStartCodeFrom(data, 0, size);
+}
+
+// ------------------ SIMD implementations ------------------
+
+#if SIMD_X86
+
+inline int countTrailingZeros(unsigned int mask)
+{
+#ifdef _MSC_VER
+  unsigned long idx;
+  _BitScanForward(&idx, mask);
+  return int(idx);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+// Compare 16 (32) positions at once: The first and second byte must be 0 and the third byte must be 1. The loads of
+// the second and third bytes are shifted by one and two bytes, so the last block needs 2 more readable bytes.
+SIMD_TARGET("sse2")
+int64_t findStartCodeSSE2(const char *data, int64_t size)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  int64_t i = 0;
+  for (; i + 18 <= size; i += 16)
+  {
+    const __m128i b0 = _mm_loadu_si128((const __m128i*)(data + i));
+    const __m128i b1 = _mm_loadu_si128((const __m128i*)(data + i + 1));
+    const __m128i b2 = _mm_loadu_si128((const __m128i*)(data + i + 2));
+    const __m128i match = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)), _mm_cmpeq_epi8(b2, one));
+    const unsigned int mask = unsigned(_mm_movemask_epi8(match));
+    if (mask != 0)
+      return i + countTrailingZeros(mask);
+  }
+  return findStartCodeFrom(data, i, size);
+}
+
+SIMD_TARGET("avx2")
+int64_t findStartCodeAVX2(const char *data, int64_t size)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi8(1);
+  int64_t i = 0;
+  for (; i + 34 <= size; i += 32)
+  {
+    const __m256i b0 = _mm256_loadu_si256((const __m256i*)(data + i));
+    const __m256i b1 = _mm256_loadu_si256((const __m256i*)(data + i + 1));
+    const __m256i b2 = _mm256_loadu_si256((const __m256i*)(data + i + 2));
+    const __m256i match = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)), _mm256_cmpeq_epi8(b2, one));
+    const unsigned int mask = unsigned(_mm256_movemask_epi8(match));
+    if (mask != 0)
+      return i + countTrailingZeros(mask);
+  }
+  return findStartCodeFrom(data, i, size);
+}
+
+#endif // SIMD_X86
+
+const startCodeScanner scannerScalar = {&findStartCodeScalar, "C++"};
+#if SIMD_X86
+const startCodeScanner scannerSSE2 = {&findStartCodeSSE2, "SSE2"};
+const startCodeScanner scannerAVX2 = {&findStartCodeAVX2, "AVX2"};
+#endif
+
+const startCodeScanner *selectScanner()
+{
+#if SIMD_X86
+  if (functions::cpuSupportsAVX2())
+    return &scannerAVX2;
+  if (functions::cpuSupportsSSE2())
+    return &scannerSSE2;
+#endif
+  return &scannerScalar;
+}
+
+} // namespace
+
+const startCodeScanner &getStartCodeScanner()
+{
+  static const startCodeScanner *scanner = selectScanner();
+  return *scanner;
+}
+
+const startCodeScanner &getStartCodeScannerScalar()
+{
+  return scannerScalar;
+}
@@ -0,0 +1,51 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// A function to find the next start code (the bytes 0x00 0x00 0x01) of an annex B bitstream in a buffer. Like the
+// conversion kernels, the fastest available implementation (AVX2, SSE2 or plain C++) is selected once at runtime.
+struct startCodeScanner
+{
+  // Find the first start code in the size bytes at data. Return the index of the first 0 byte of the start code or -1
+  // if there is no start code. For a 4 byte start code (0x00 0x00 0x00 0x01), the index of the second 0 is returned.
+  int64_t (*findStartCode)(const char *data, int64_t size);
+  // The name of the implementation ("AVX2", "SSE2" or "C++")
+  const char *name;
+};
+
+// Get the fastest implementation for the CPU that we are running on.
+const startCodeScanner &getStartCodeScanner();
+// Get the plain C++ implementation. This is the reference for the SIMD implementations.
+const startCodeScanner &getStartCodeScannerScalar();
@@ -32,7 +32,10 @@
 
 #include "parserAnnexB.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <climits>
+#include <QHash>
 #include <QProgressDialog>
 #include <QElapsedTimer>
 
@@ -84,7 +87,7 @@ int parserAnnexB::getClosestSeekableFrameNumberBefore(int frameIdx, int &codingO
   int bestSeekPOC = -1;
   for (int i=0; i<frameList.length(); i++)
   {
-    annexBFrame f = frameList[i];
+    const annexBFrame &f = frameList[i];
     if (f.randomAccessPoint)
     {
       if (bestSeekPOC == -1)
@@ -110,6 +113,38 @@ int parserAnnexB::getClosestSeekableFrameNumberBefore(int frameIdx, int &codingO
   return POCList.indexOf(bestSeekPOC);
 }
 
+QList<int> parserAnnexB::getClosestSeekableFrameNumbers() const
+{
+  // getClosestSeekableFrameNumberBefore takes the first random access point and then all following ones (in coding
+  // order) as long as their POC is not greater than the POC to seek to. So a random access point is used if the maximum
+  // POC of all random access points up to it is not greater. This maximum never decreases. (A random access point with
+  // a POC of -1 is not handled specially here as it is in getClosestSeekableFrameNumberBefore.)
+  QList<int> maxPOCs;
+  QList<int> seekPOCs;
+  for (const annexBFrame &f : frameList)
+  {
+    if (!f.randomAccessPoint)
+      continue;
+    maxPOCs.append(maxPOCs.isEmpty() ? INT_MIN : std::max(maxPOCs.last(), f.poc));
+    seekPOCs.append(f.poc);
+  }
+
+  // The first frame index in display order for each POC (like indexOf)
+  QHash<int, int> frameIdxForPOC;
+  for (int i = POCList.size() - 1; i >= 0; i--)
+    frameIdxForPOC.insert(POCList[i], i);
+
+  QList<int> seekFrames;
+  seekFrames.reserve(POCList.size());
+  for (int poc : POCList)
+  {
+    const int nrUsable = int(std::upper_bound(maxPOCs.begin(), maxPOCs.end(), poc) - maxPOCs.begin());
+    const int bestSeekPOC = (nrUsable > 0) ? seekPOCs[nrUsable - 1] : -1;
+    seekFrames.append(frameIdxForPOC.value(bestSeekPOC, -1));
+  }
+  return seekFrames;
+}
+
 QUint64Pair parserAnnexB::getFrameStartEndPos(int codingOrderFrameIdx)
 {
   if (codingOrderFrameIdx < 0 || codingOrderFrameIdx >= frameList.size())
@@ -83,6 +83,9 @@ public:
   // frameIdx: The frame index in display order that we want to seek to
   // codingOrderFrameIdx: The index of the frame in coding order (for use with getFrameStartEndPos).
   int getClosestSeekableFrameNumberBefore(int frameIdx, int &codingOrderFrameIdx) const;
+  // The same as getClosestSeekableFrameNumberBefore for all frames (in display order) at once. The random access
+  // points are only scanned once.
+  QList<int> getClosestSeekableFrameNumbers() const;
 
   // Get the parameters sets as extradata. The format of this depends on the underlying codec.
   virtual QByteArray getExtradata() = 0;
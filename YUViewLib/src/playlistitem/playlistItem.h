@@ -193,6 +193,11 @@ public:
   // Remove the frame with the given index from the cache.
   virtual void removeFrameFromCache(int idx) { Q_UNUSED(idx); }
   virtual void removeAllFramesFromCache() {};
+  // How expensive is it to load the given frame again after it was removed from the cache? The cost is relative to
+  // reading one raw frame from a file (1.0). The video cache removes frames that are cheap to reload first.
+  virtual double getFrameReloadCost(int idx) const { Q_UNUSED(idx); return 1.0; }
+  // When was the cached frame used last? This is a monotonic time in ms (0 if unknown).
+  virtual int64_t getFrameCacheAccessTime(int idx) const { Q_UNUSED(idx); return 0; }
 
   // ----- Detection of source/file change events -----
 
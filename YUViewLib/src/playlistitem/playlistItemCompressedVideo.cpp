@@ -32,9 +32,11 @@
 
 #include "playlistItemCompressedVideo.h"
 
+#include <QDir>
 #include <QThread>
 #include <QInputDialog>
 #include <QPlainTextEdit>
+#include <QSettings>
 
 #include <inttypes.h>
 
@@ -287,6 +289,8 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
   if (cachingEnabled)
     seekToPosition(0, 0, true);
 
+  updateSettings();
+
   // Connect signals for requesting data and statistics
   connect(video.data(), &videoHandler::signalRequestRawData, this, &playlistItemCompressedVideo::loadRawData, Qt::DirectConnection);
   connect(video.data(), &videoHandler::signalUpdateFrameLimits, this, &playlistItemCompressedVideo::slotUpdateFrameLimits);
@@ -484,6 +488,15 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
     return;
   }
 
+  // If the frame was decoded before, it may be in the disk cache. If the statistics are retrieved from the
+  // interactive decoder, the frame must be decoded.
+  if ((caching || !loadingDecoder->statisticsEnabled()) && diskCache.read(frameIdxInternal, video->rawData))
+  {
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData frame %d read from disk cache", frameIdxInternal);
+    video->rawData_frameIdx = frameIdxInternal;
+    return;
+  }
+
   // Get the right decoder
   decoderBase *dec = caching ? cachingDecoder.data() : loadingDecoder.data();
   int curFrameIdx = caching ? currentFrameIdx[1] : currentFrameIdx[0];
@@ -604,6 +617,7 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
         {
           video->rawData = dec->getRawFrameData();
           video->rawData_frameIdx = frameIdxInternal;
+          diskCache.write(frameIdxInternal, video->rawData);
         }
       }
     }
@@ -930,12 +944,45 @@ void playlistItemCompressedVideo::reloadItemSource()
 
   // Reset the videoHandlerYUV source. With the next draw event, the videoHandlerYUV will request to decode the frame again.
   video->invalidateAllBuffers();
+  diskCache.clear();
+  reloadSeekFrames.clear();
 
   // Load frame 0. This will decode the first frame in the sequence and set the
   // correct frame size/YUV format.
   loadRawData(0, false);
 }
 
+double playlistItemCompressedVideo::getFrameReloadCost(int idx) const
+{
+  const int frameIdxInternal = getFrameIdxInternal(idx);
+  if (diskCache.contains(frameIdxInternal))
+    return 1.0;
+
+  if (reloadSeekFrames.isEmpty())
+  {
+    if (isInputFormatTypeAnnexB(inputFormatType) && inputFileAnnexBParser)
+      reloadSeekFrames = inputFileAnnexBParser->getClosestSeekableFrameNumbers();
+    else if (isInputFormatTypeFFmpeg(inputFormatType) && inputFileFFmpegLoading)
+      reloadSeekFrames = inputFileFFmpegLoading->getClosestSeekableFrameIndices(getStartEndFrameLimits().second + 1);
+  }
+  const int seekToFrame = (frameIdxInternal >= 0 && frameIdxInternal < reloadSeekFrames.size()) ? reloadSeekFrames[frameIdxInternal] : -1;
+
+  // Decoding one frame is estimated to be about twice as expensive as reading a raw frame
+  const int nrFramesToDecode = (seekToFrame >= 0 && seekToFrame <= frameIdxInternal) ? frameIdxInternal - seekToFrame + 1 : 1;
+  return 2.0 * nrFramesToDecode;
+}
+
+void playlistItemCompressedVideo::updateSettings()
+{
+  QSettings settings;
+  settings.beginGroup("VideoCache");
+  int64_t diskCacheMax = 0;
+  if (settings.value("DiskCacheEnabled", false).toBool())
+    diskCacheMax = (int64_t)settings.value("DiskCacheMB", 4000).toUInt() * 1000 * 1000;
+  diskCache.setLimits(settings.value("DiskCacheDirectory", QDir::tempPath()).toString(), diskCacheMax);
+  settings.endGroup();
+}
+
 void playlistItemCompressedVideo::cacheFrame(int frameIdx, bool testMode)
 {
   if (!cachingEnabled)
@@ -1014,6 +1061,7 @@ void playlistItemCompressedVideo::displaySignalComboBoxChanged(int idx)
     videoHandlerYUV *yuvVideo = dynamic_cast<videoHandlerYUV*>(video.data());
     yuvVideo->showPixelValuesAsDiff = loadingDecoder->isSignalDifference(idx);
     yuvVideo->invalidateAllBuffers();
+    diskCache.clear();
 
     emit signalItemChanged(true, RECACHE_CLEAR);
   }
@@ -1033,6 +1081,7 @@ void playlistItemCompressedVideo::decoderComboxBoxChanged(int idx)
     if (loadingDecoder)
       yuvVideo->showPixelValuesAsDiff = loadingDecoder->isSignalDifference(idx);
     yuvVideo->invalidateAllBuffers();
+    diskCache.clear();
 
     // Reset the decoded frame indices so that decoding of the current frame is triggered
     currentFrameIdx[0] = -1;
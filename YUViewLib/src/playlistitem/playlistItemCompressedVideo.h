@@ -37,6 +37,7 @@
 #include "parser/parserAnnexB.h"
 #include "playlistItemWithVideo.h"
 #include "statistics/statisticHandler.h"
+#include "video/diskFrameCache.h"
 #include "ui_playlistItemCompressedFile.h"
 
 class videoHandler;
@@ -87,7 +88,7 @@ public:
   // ----- Detection of source/file change events -----
   virtual bool isSourceChanged()        Q_DECL_OVERRIDE { /* TODO */ return false; }
   virtual void reloadItemSource()       Q_DECL_OVERRIDE;
-  virtual void updateSettings()         Q_DECL_OVERRIDE { /* TODO loadingDecoder->updateFileWatchSetting(); statSource.updateSettings(); */ }
+  virtual void updateSettings()         Q_DECL_OVERRIDE;
 
   // Do we need to load the given frame first?
   virtual itemLoadingState needsLoading(int frameIdx, bool loadRawData) Q_DECL_OVERRIDE;
@@ -105,6 +106,9 @@ public:
   // This way, the frames will always be cached in the right order and no unnecessary decoding is performed.
   virtual int cachingThreadLimit() Q_DECL_OVERRIDE { return 1; }
 
+  // Reloading a frame requires decoding all frames from the previous random access point (unless it is in the disk cache)
+  virtual double getFrameReloadCost(int idx) const Q_DECL_OVERRIDE;
+
   YUView::inputFormat getInputFormat() const { return inputFormatType; }
   
 protected:
@@ -147,6 +151,13 @@ protected:
   bool isFrameLoading { false };
   bool isFrameLoadingDoubleBuffer { false };
 
+  // Decoded frames can be stored on disk (settings group "VideoCache"). Reading a frame from the disk is much faster than
+  // seeking to the previous random access point and decoding all frames up to the requested frame again.
+  diskFrameCache diskCache;
+  // For each frame, the frame from which decoding has to start to get it (see getFrameReloadCost). The video cache
+  // asks for the cost of all cached frames when it sorts them, so this is only built once.
+  mutable QList<int> reloadSeekFrames;
+
   // Only cache one frame at a time. Caching should also always be done in display order of the frames.
   // TODO: Could we somehow make shure that caching is always performed in display order?
   QMutex cachingMutex;
@@ -50,6 +50,12 @@ using namespace YUV_Internals;
 #define DEBUG_RAWFILE(fmt,...) ((void)0)
 #endif
 
+// During playback, read ahead the frames of this many seconds of the video (at the frame rate of the item)
+#define READ_AHEAD_SECONDS 0.5
+// The limits for the number of frames and the number of bytes to read ahead
+#define READ_AHEAD_MAX_FRAMES 16
+#define READ_AHEAD_MAX_BYTES (256 * 1024 * 1024)
+
 playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize &frameSize, const QString &sourcePixelFormat, const QString &fmt)
   : playlistItemWithVideo(rawFilePath, playlistItem_Indexed)
 {
@@ -63,6 +69,8 @@ playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize
   setFlags(flags() | Qt::ItemIsDropEnabled);
 
   dataSource.openFile(rawFilePath);
+  dataSource.updateDirectIOSetting();
+  dataSource.updateMemoryMappingSetting();
 
   if (!dataSource.isOk())
   {
@@ -464,24 +472,70 @@ playlistItemRawFile *playlistItemRawFile::newplaylistItemRawFile(const YUViewDom
   return newFile;
 }
 
-void playlistItemRawFile::loadRawData(int frameIdxInternal)
+void playlistItemRawFile::getFrameFileRange(int frameIdxInternal, int64_t &fileStartPos, int64_t &nrBytes) const
 {
-  if (!video->isFormatValid())
-    return;
-
-  // Load the raw data for the given frameIdx from file and set it in the video
-  int64_t fileStartPos;
   if (isY4MFile)
     fileStartPos = y4mFrameIndices.at(frameIdxInternal);
   else
     fileStartPos = frameIdxInternal * getBytesPerFrame();
-  int64_t nrBytes = getBytesPerFrame();
+  nrBytes = getBytesPerFrame();
+}
+
+void playlistItemRawFile::readAheadFrames(int frameIdxInternal)
+{
+  // Only read ahead if the frames are loaded in sequence (with the sampling of the item) in either direction
+  const int step = frameIdxInternal - readAheadLastFrameIdx;
+  readAheadLastFrameIdx = frameIdxInternal;
+  if (step == 0 || qAbs(step) > getSampling())
+  {
+    readAheadEndFrameIdx = -1;
+    return;
+  }
+
+  const int64_t nrBytesPerFrame = getBytesPerFrame();
+  if (nrBytesPerFrame <= 0)
+    return;
+  const int nrFramesRate = int(getFrameRate() * READ_AHEAD_SECONDS + 0.5);
+  const int nrFramesBytes = int(qMax(int64_t(1), READ_AHEAD_MAX_BYTES / nrBytesPerFrame));
+  const int nrFrames = qMin(qBound(1, nrFramesRate, READ_AHEAD_MAX_FRAMES), nrFramesBytes);
+
+  // Start after the frames that were read ahead already
+  const indexRange range = getStartEndFrameLimits();
+  int k = 1;
+  if (readAheadEndFrameIdx != -1 && (readAheadEndFrameIdx - frameIdxInternal) * step > 0)
+    k = (readAheadEndFrameIdx - frameIdxInternal) / step + 1;
+  for (; k <= nrFrames; k++)
+  {
+    const int frameIdx = frameIdxInternal + k * step;
+    if (frameIdx < range.first || frameIdx > range.second)
+      break;
+    int64_t fileStartPos, nrBytes;
+    getFrameFileRange(frameIdx, fileStartPos, nrBytes);
+    DEBUG_RAWFILE("playlistItemRawFile::readAheadFrames frame %d", frameIdx);
+    dataSource.readAhead(fileStartPos, nrBytes);
+    readAheadEndFrameIdx = frameIdx;
+  }
+}
+
+void playlistItemRawFile::loadRawData(int frameIdxInternal, bool caching)
+{
+  if (!video->isFormatValid())
+    return;
+
+  // Load the raw data for the given frameIdx from file and set it in the video
+  int64_t fileStartPos, nrBytes;
+  getFrameFileRange(frameIdxInternal, fileStartPos, nrBytes);
 
   DEBUG_RAWFILE("playlistItemRawFile::loadRawData frame %d bytes %d", frameIdxInternal, int(nrBytes));
-  if (dataSource.readBytes(video->rawData, fileStartPos, nrBytes) < nrBytes)
+  // If the file is memory mapped, the video handler converts the frame directly from the mapped file
+  if (!dataSource.getMappedView(video->rawData, fileStartPos, nrBytes) && dataSource.readBytes(video->rawData, fileStartPos, nrBytes) < nrBytes)
     return; // Error
   video->rawData_frameIdx = frameIdxInternal;
 
+  // The caching workers load their frames in parallel. The order of these requests says nothing about the playback.
+  if (!caching)
+    readAheadFrames(frameIdxInternal);
+
   DEBUG_RAWFILE("playlistItemRawFile::loadRawData %d Done", frameIdxInternal);
 }
 
@@ -524,6 +578,10 @@ void playlistItemRawFile::reloadItemSource()
   if (!dataSource.isOk())
     // Opening the file failed.
     return;
+  dataSource.updateDirectIOSetting();
+  dataSource.updateMemoryMappingSetting();
+  readAheadLastFrameIdx = -1;
+  readAheadEndFrameIdx = -1;
 
   video->invalidateAllBuffers();
 
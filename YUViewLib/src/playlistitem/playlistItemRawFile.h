@@ -73,7 +73,7 @@ public:
   // ----- Detection of source/file change events -----
   virtual bool isSourceChanged()  Q_DECL_OVERRIDE { return dataSource.isFileChanged(); }
   virtual void reloadItemSource() Q_DECL_OVERRIDE;
-  virtual void updateSettings()   Q_DECL_OVERRIDE { dataSource.updateFileWatchSetting(); }
+  virtual void updateSettings()   Q_DECL_OVERRIDE { dataSource.updateFileWatchSetting(); dataSource.updateDirectIOSetting(); dataSource.updateMemoryMappingSetting(); }
 
   // Cache the given frame
   virtual void cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE { if (testMode) dataSource.clearFileCache(); playlistItemWithVideo::cacheFrame(idx, testMode); }
@@ -81,7 +81,7 @@ public:
 private slots:
   // Load the raw data for the given frame index from file. This slot is called by the videoHandler if the frame that is
   // requested to be drawn has not been loaded yet.
-  void loadRawData(int frameIdxInternal);
+  void loadRawData(int frameIdxInternal, bool caching);
 
   void slotVideoPropertiesChanged();
 
@@ -113,4 +113,15 @@ private:
   QList<uint64_t> y4mFrameIndices;
 
   QString pixelFormatAfterLoading;
+
+  // --- Read ahead
+  // When frames are loaded one after another (playback), the next frames in the direction of the playback are read
+  // into the page cache in the background. So reading these frames does not have to wait for the disk and the disk
+  // reads overlap with the conversion of the current frame. Frames that are loaded for caching are not considered.
+  void readAheadFrames(int frameIdxInternal);
+  // Get the position and size of the frame in the file
+  void getFrameFileRange(int frameIdxInternal, int64_t &fileStartPos, int64_t &nrBytes) const;
+  int readAheadLastFrameIdx {-1};
+  // The last frame that was already requested to be read ahead
+  int readAheadEndFrameIdx {-1};
 };
@@ -35,8 +35,9 @@
 #include <cassert>
 #include <iostream>
 #include <QDebug>
-#include <QtConcurrent>
 #include <QTime>
+
+#include "common/taskPool.h"
 #include "statistics/statisticsExtensions.h"
 
 // The internal buffer for parsing the starting positions. The buffer must not be larger than 2GB
@@ -58,7 +59,7 @@ playlistItemStatisticsCSVFile::playlistItemStatisticsCSVFile(const QString &item
   // Run the parsing of the file in the background
   cancelBackgroundParser = false;
   timer.start(1000, this);
-  backgroundParserFuture = QtConcurrent::run(this, &playlistItemStatisticsCSVFile::readFrameAndTypePositionsFromFile);
+  backgroundParserFuture = taskPool::instance().submit([this]() { readFrameAndTypePositionsFromFile(); });
 
   connect(&statSource, &statisticHandler::updateItem, [this](bool redraw){ emit signalItemChanged(redraw, RECACHE_NONE); });
   connect(&statSource, &statisticHandler::requestStatisticsLoading, this, &playlistItemStatisticsCSVFile::loadStatisticToCache, Qt::DirectConnection);
@@ -584,7 +585,7 @@ void playlistItemStatisticsCSVFile::reloadItemSource()
   // Run the parsing of the file in the background
   cancelBackgroundParser = false;
   timer.start(1000, this);
-  backgroundParserFuture = QtConcurrent::run(this, &playlistItemStatisticsCSVFile::readFrameAndTypePositionsFromFile);
+  backgroundParserFuture = taskPool::instance().submit([this]() { readFrameAndTypePositionsFromFile(); });
 }
 
 
@@ -33,7 +33,6 @@
 #pragma once
 
 #include <QBasicTimer>
-#include <QFuture>
 #include "filesource/fileSource.h"
 #include "playlistItemStatisticsFile.h"
 #include "statistics/statisticHandler.h"
@@ -83,6 +82,6 @@ private:
 
   // --------------- background parsing ---------------
   //! Parser the whole file and get the positions where a new POC/type starts. Save this position in p_pocTypeStartList.
-  //! This is performed in the background using a QFuture.
+  //! This is performed in the background as a task of the taskPool.
   void readFrameAndTypePositionsFromFile();
 };
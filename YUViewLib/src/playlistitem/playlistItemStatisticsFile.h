@@ -33,7 +33,7 @@
 #pragma once
 
 #include <QBasicTimer>
-#include <QFuture>
+#include "common/taskPool.h"
 #include "filesource/fileSource.h"
 #include "playlistItem.h"
 #include "statistics/statisticHandler.h"
@@ -100,7 +100,8 @@ protected:
   // Is the loadFrame function currently loading?
   bool isStatisticsLoading;
 
-  QFuture<void> backgroundParserFuture;
+  // The parser runs in the background lane of the taskPool
+  taskPool::taskHandle backgroundParserFuture;
   double backgroundParserProgress;
   bool cancelBackgroundParser;
   // A timer is used to frequently update the status of the background process (every second)
@@ -35,9 +35,9 @@
 #include <cassert>
 #include <iostream>
 #include <QDebug>
-#include <QtConcurrent>
 #include <QTime>
 
+#include "common/taskPool.h"
 #include "statistics/statisticsExtensions.h"
 
 // The internal buffer for parsing the starting positions. The buffer must not be larger than 2GB
@@ -59,7 +59,7 @@ playlistItemStatisticsVTMBMSFile::playlistItemStatisticsVTMBMSFile(const QString
   // Run the parsing of the file in the background
   cancelBackgroundParser = false;
   timer.start(1000, this);
-  backgroundParserFuture = QtConcurrent::run(this, &playlistItemStatisticsVTMBMSFile::readFramePositionsFromFile);
+  backgroundParserFuture = taskPool::instance().submit([this]() { readFramePositionsFromFile(); });
 
   connect(&statSource, &statisticHandler::updateItem, [this](bool redraw){ emit signalItemChanged(redraw, RECACHE_NONE); });
   connect(&statSource, &statisticHandler::requestStatisticsLoading, this, &playlistItemStatisticsVTMBMSFile::loadStatisticToCache, Qt::DirectConnection);
@@ -651,6 +651,6 @@ void playlistItemStatisticsVTMBMSFile::reloadItemSource()
   // Run the parsing of the file in the background
   cancelBackgroundParser = false;
   timer.start(1000, this);
-  backgroundParserFuture = QtConcurrent::run(this, &playlistItemStatisticsVTMBMSFile::readFramePositionsFromFile);
+  backgroundParserFuture = taskPool::instance().submit([this]() { readFramePositionsFromFile(); });
 }
 
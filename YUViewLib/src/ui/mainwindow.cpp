@@ -45,6 +45,7 @@
 #include "playlistitem/playlistItems.h"
 #include "settingsDialog.h"
 #include "ui/playlistTreeWidget.h"
+#include "video/videoHandler.h"
 
 MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindow(parent)
 {
@@ -622,6 +623,7 @@ void MainWindow::updateSettings()
   ui.playlistTreeWidget->updateSettings();
   cache->updateSettings();
   ui.playbackController->updateSettings();
+  videoHandler::updateConversionSettings();
 }
 
 void MainWindow::saveScreenshot()
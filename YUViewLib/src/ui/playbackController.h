@@ -110,6 +110,9 @@ signals:
   // The playback is now going to start
   void signalPlaybackStarting();
 
+  // The current frame changed (by playback or by the user)
+  void signalCurrentFrameChanged(int frameIdx);
+
 public slots:
   // The video cache calls this if caching of the item is finished
   void itemCachingFinished(playlistItem *item);
@@ -37,6 +37,7 @@
 #include <QMessageBox>
 #include <QSettings>
 #include <QTextStream>
+#include <QThread>
 
 #include "common/functions.h"
 #include "common/typedef.h"
@@ -56,12 +57,20 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
   // Set the minimum and maximum values for memory
   ui.labelMaxMb->setText(QString("%1 MB").arg(functions::systemMemorySizeInMB()));
   ui.labelMinMB->setText(QString("%1 MB").arg(functions::systemMemorySizeInMB() / 100));
+#ifndef Q_OS_LINUX
+  // The free memory is only monitored on Linux
+  ui.checkBoxAdaptiveCacheSize->setVisible(false);
+  // Direct I/O is only supported on Linux
+  ui.checkBoxDirectIO->setVisible(false);
+#endif
 
   // --- Load the current settings from the QSettings ---
   QSettings settings;
 
   // "Generals" tab
   ui.checkBoxWatchFiles->setChecked(settings.value("WatchFiles", true).toBool());
+  ui.checkBoxMemoryMapFiles->setChecked(settings.value("MemoryMapFiles", false).toBool());
+  ui.checkBoxDirectIO->setChecked(settings.value("DirectIORawFiles", false).toBool());
   ui.checkBoxAskToSave->setChecked(settings.value("AskToSaveOnExit", true).toBool());
   ui.checkBoxContinuePlaybackNewSelection->setChecked(settings.value("ContinuePlaybackOnSequenceSelection", false).toBool());
   ui.checkBoxSavePositionPerItem->setChecked(settings.value("SavePositionAndZoomPerItem", false).toBool());
@@ -120,6 +129,15 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
   else
     ui.spinBoxNrThreads->setValue(functions::getOptimalThreadCount());
   ui.spinBoxNrThreads->setEnabled(ui.checkBoxNrThreads->isChecked());
+  ui.checkBoxAdaptiveCacheSize->setChecked(settings.value("AdaptiveCacheSize", false).toBool());
+  ui.checkBoxCacheRawData->setChecked(settings.value("CacheRawData", false).toBool());
+  ui.checkBoxCompressedCache->setChecked(settings.value("CompressedCacheEnabled", false).toBool());
+  ui.spinBoxCompressedCacheMB->setValue(settings.value("CompressedCacheMB", 1000).toInt());
+  ui.spinBoxCompressedCacheMB->setEnabled(ui.checkBoxCompressedCache->isChecked());
+  ui.checkBoxDiskCache->setChecked(settings.value("DiskCacheEnabled", false).toBool());
+  ui.spinBoxDiskCacheMB->setValue(settings.value("DiskCacheMB", 4000).toInt());
+  ui.lineEditDiskCacheDirectory->setText(settings.value("DiskCacheDirectory", QDir::tempPath()).toString());
+  on_checkBoxDiskCache_stateChanged(ui.checkBoxDiskCache->checkState());
   // Playback
   ui.checkBoxPausPlaybackForCaching->setChecked(settings.value("PlaybackPauseCaching", true).toBool());
   bool playbackCaching = settings.value("PlaybackCachingEnabled", false).toBool();
@@ -127,6 +145,16 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
   ui.spinBoxThreadLimit->setValue(settings.value("PlaybackCachingThreadLimit", 1).toInt());
   ui.spinBoxThreadLimit->setEnabled(playbackCaching);
   settings.endGroup();
+  // Conversion settings
+  settings.beginGroup("Conversion");
+  ui.checkBoxNrConversionThreads->setChecked(settings.value("SetNrThreads", false).toBool());
+  if (ui.checkBoxNrConversionThreads->isChecked())
+    ui.spinBoxNrConversionThreads->setValue(settings.value("NrThreads", QThread::idealThreadCount()).toInt());
+  else
+    ui.spinBoxNrConversionThreads->setValue(QThread::idealThreadCount());
+  ui.spinBoxNrConversionThreads->setEnabled(ui.checkBoxNrConversionThreads->isChecked());
+  ui.checkBoxHighBitDepthOutput->setChecked(settings.value("HighBitDepthOutput", false).toBool());
+  settings.endGroup();
 
   // "Decoders" tab
   settings.beginGroup("Decoders");
@@ -164,12 +192,46 @@ void SettingsDialog::on_checkBoxNrThreads_stateChanged(int newState)
     ui.spinBoxNrThreads->setValue(functions::getOptimalThreadCount());
 }
 
+void SettingsDialog::on_checkBoxNrConversionThreads_stateChanged(int newState)
+{
+  ui.spinBoxNrConversionThreads->setEnabled(newState);
+  if (newState == Qt::Unchecked)
+    ui.spinBoxNrConversionThreads->setValue(QThread::idealThreadCount());
+}
+
 void SettingsDialog::on_checkBoxEnablePlaybackCaching_stateChanged(int state)
 {
   // Enable/disable the spinBoxThreadLimit
   ui.spinBoxThreadLimit->setEnabled(state != Qt::Unchecked);
 }
 
+void SettingsDialog::on_checkBoxCompressedCache_stateChanged(int state)
+{
+  ui.spinBoxCompressedCacheMB->setEnabled(state != Qt::Unchecked);
+}
+
+void SettingsDialog::on_checkBoxDiskCache_stateChanged(int state)
+{
+  ui.spinBoxDiskCacheMB->setEnabled(state != Qt::Unchecked);
+  ui.lineEditDiskCacheDirectory->setEnabled(state != Qt::Unchecked);
+  ui.pushButtonDiskCacheSelectDirectory->setEnabled(state != Qt::Unchecked);
+}
+
+void SettingsDialog::on_pushButtonDiskCacheSelectDirectory_clicked()
+{
+  auto curDir = QDir(ui.lineEditDiskCacheDirectory->text());
+  if (!curDir.exists())
+    curDir = QDir::temp();
+
+  QFileDialog pathDialog(this);
+  pathDialog.setDirectory(curDir);
+  pathDialog.setFileMode(QFileDialog::Directory);
+  pathDialog.setOption(QFileDialog::ShowDirsOnly);
+
+  if (pathDialog.exec())
+    ui.lineEditDiskCacheDirectory->setText(pathDialog.selectedFiles()[0]);
+}
+
 void SettingsDialog::on_pushButtonEditBackgroundColor_clicked()
 {
   QColor currentColor = ui.frameBackgroundColor->getPlainColor();
@@ -347,6 +409,8 @@ void SettingsDialog::on_pushButtonSave_clicked()
 
   // "General" tab
   settings.setValue("WatchFiles", ui.checkBoxWatchFiles->isChecked());
+  settings.setValue("MemoryMapFiles", ui.checkBoxMemoryMapFiles->isChecked());
+  settings.setValue("DirectIORawFiles", ui.checkBoxDirectIO->isChecked());
   settings.setValue("AskToSaveOnExit", ui.checkBoxAskToSave->isChecked());
   settings.setValue("ContinuePlaybackOnSequenceSelection", ui.checkBoxContinuePlaybackNewSelection->isChecked());
   settings.setValue("SavePositionAndZoomPerItem", ui.checkBoxSavePositionPerItem->isChecked());
@@ -378,10 +442,22 @@ void SettingsDialog::on_pushButtonSave_clicked()
   settings.setValue("ThresholdValueMB", getCacheSizeInMB());
   settings.setValue("SetNrThreads", ui.checkBoxNrThreads->isChecked());
   settings.setValue("NrThreads", ui.spinBoxNrThreads->value());
+  settings.setValue("AdaptiveCacheSize", ui.checkBoxAdaptiveCacheSize->isChecked());
+  settings.setValue("CacheRawData", ui.checkBoxCacheRawData->isChecked());
+  settings.setValue("CompressedCacheEnabled", ui.checkBoxCompressedCache->isChecked());
+  settings.setValue("CompressedCacheMB", ui.spinBoxCompressedCacheMB->value());
+  settings.setValue("DiskCacheEnabled", ui.checkBoxDiskCache->isChecked());
+  settings.setValue("DiskCacheMB", ui.spinBoxDiskCacheMB->value());
+  settings.setValue("DiskCacheDirectory", ui.lineEditDiskCacheDirectory->text());
   settings.setValue("PlaybackPauseCaching", ui.checkBoxPausPlaybackForCaching->isChecked());
   settings.setValue("PlaybackCachingEnabled", ui.checkBoxEnablePlaybackCaching->isChecked());
   settings.setValue("PlaybackCachingThreadLimit", ui.spinBoxThreadLimit->value());
   settings.endGroup();
+  settings.beginGroup("Conversion");
+  settings.setValue("SetNrThreads", ui.checkBoxNrConversionThreads->isChecked());
+  settings.setValue("NrThreads", ui.spinBoxNrConversionThreads->value());
+  settings.setValue("HighBitDepthOutput", ui.checkBoxHighBitDepthOutput->isChecked());
+  settings.endGroup();
 
   // "Decoders" tab
   settings.beginGroup("Decoders");
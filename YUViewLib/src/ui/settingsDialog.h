@@ -53,6 +53,11 @@ private slots:
   // Caching threads check box
   void on_checkBoxNrThreads_stateChanged(int newState);
   void on_checkBoxEnablePlaybackCaching_stateChanged(int state);
+  void on_checkBoxCompressedCache_stateChanged(int state);
+  void on_checkBoxDiskCache_stateChanged(int state);
+  void on_pushButtonDiskCacheSelectDirectory_clicked();
+  // Conversion threads check box
+  void on_checkBoxNrConversionThreads_stateChanged(int newState);
 
   // Colors buttons
   void on_pushButtonEditBackgroundColor_clicked();
@@ -34,7 +34,6 @@
 
 #include <QGroupBox>
 #include <QPainter>
-#include <QSettings>
 
 #define VIDEOCACHEINFOWIDGET_DEBUG_OUTPUT 0
 #if VIDEOCACHEINFOWIDGET_DEBUG_OUTPUT && !NDEBUG
@@ -92,17 +91,15 @@ void videoCacheStatusWidget::paintEvent(QPaintEvent *event)
   painter.drawRect(0, 0, width-1, height-1);
 }
 
-void videoCacheStatusWidget::updateStatus(PlaylistTreeWidget *playlist, unsigned int cacheRate)
+void videoCacheStatusWidget::updateStatus(PlaylistTreeWidget *playlist, unsigned int cacheRate, int64_t cacheLevelMax)
 {
   // Get all items from the playlist
   QList<playlistItem*> allItems = playlist->getAllPlaylistItems();
 
-  // Get if caching is enabled and how much memory we can use for the cache
-  QSettings settings;
-  settings.beginGroup("VideoCache");
-  cacheLevelMaxMB = settings.value("ThresholdValueMB", 49).toUInt();
-  const int64_t cacheLevelMax = cacheLevelMaxMB * 1000 * 1000;
-  settings.endGroup();
+  // The current budget of the cache. This is the threshold from the settings unless the cache adapts to the free memory.
+  cacheLevelMaxMB = cacheLevelMax / 1000000;
+  if (cacheLevelMax <= 0)
+    cacheLevelMax = 1;
 
   // Clear the old percent values
   relativeValsEnd.clear();
@@ -176,7 +173,8 @@ void VideoCacheInfoWidget::onUpdateCacheStatus()
   playlist->updateCachingStatus();
 
   DEBUG_CACHINGINFO("VideoCacheInfoWidget::updateCacheStatus");
-  statusWidget->updateStatus(playlist, cacheRateInBytesPerMs);
+  statusWidget->updateStatus(playlist, cacheRateInBytesPerMs, cache->getCacheLevelMax());
+  statusWidget->setToolTip(QString("Cache budget: %1").arg(cache->getCacheBudgetReason()));
 
   QStringList statusText = cache->getCacheStatusText();
   cachingInfoLabel->setText(statusText.join("\n"));
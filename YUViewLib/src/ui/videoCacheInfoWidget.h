@@ -47,7 +47,7 @@ namespace videoCacheStatusWidgetNamespace
     videoCacheStatusWidget(QWidget *parent) : QWidget(parent), cacheLevelMB(0), cacheRateInBytesPerMs(0), cacheLevelMaxMB(0) {}
     // Override the paint event
     virtual void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
-    void updateStatus(PlaylistTreeWidget *playlistWidget, unsigned int cacheRate);
+    void updateStatus(PlaylistTreeWidget *playlistWidget, unsigned int cacheRate, int64_t cacheLevelMax);
     private:
     // The floating point values (0 to 1) of the end positions of the blocks to draw
     QList<float> relativeValsEnd;
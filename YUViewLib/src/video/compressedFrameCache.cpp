@@ -0,0 +1,290 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "compressedFrameCache.h"
+
+#include <algorithm>
+#include <QMutexLocker>
+
+#include "common/taskPool.h"
+
+// Activate this if you want to know when frames are added to or taken from the compressed cache.
+#define COMPRESSEDFRAMECACHE_DEBUG_OUTPUT 0
+#if COMPRESSEDFRAMECACHE_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_COMPRESSED qDebug
+#else
+#define DEBUG_COMPRESSED(fmt,...) ((void)0)
+#endif
+
+compressedFrameCache &compressedFrameCache::instance()
+{
+  static compressedFrameCache cache;
+  return cache;
+}
+
+void compressedFrameCache::setMaxSize(int64_t newMaxBytes)
+{
+  QMutexLocker lock(&mutex);
+  maxBytes = std::max(newMaxBytes, int64_t(0));
+  stats.maxBytes = maxBytes;
+  removeOldestFrames();
+}
+
+bool compressedFrameCache::isEnabled() const
+{
+  QMutexLocker lock(&mutex);
+  return maxBytes > 0;
+}
+
+void compressedFrameCache::insert(const videoHandler *handler, int frameIdx, const QImage &image)
+{
+  if (image.isNull())
+    return;
+
+  QMutexLocker lock(&mutex);
+  if (maxBytes == 0)
+    return;
+  const frameKey key(handler, frameIdx);
+  const int generation = handlerGeneration.value(handler);
+  lock.unlock();
+
+  // The image is implicitly shared. It is not copied as long as the handler does not modify it.
+  taskPool::instance().submit([this, key, generation, image]()
+  {
+    frameEntry entry;
+    entry.uncompressedSize = int(image.sizeInBytes());
+    entry.predictionStride = image.depth() / 8;
+    entry.compressed = compressData(image.constBits(), entry.uncompressedSize, entry.predictionStride);
+    entry.imageSize = image.size();
+    entry.imageFormat = image.format();
+    insertEntry(key, generation, entry);
+  });
+}
+
+void compressedFrameCache::insert(const videoHandler *handler, int frameIdx, const QByteArray &rawData, int bytesPerSample)
+{
+  if (rawData.isEmpty())
+    return;
+
+  QMutexLocker lock(&mutex);
+  if (maxBytes == 0)
+    return;
+  const frameKey key(handler, frameIdx);
+  const int generation = handlerGeneration.value(handler);
+  lock.unlock();
+
+  taskPool::instance().submit([this, key, generation, rawData, bytesPerSample]()
+  {
+    frameEntry entry;
+    entry.uncompressedSize = rawData.size();
+    entry.predictionStride = bytesPerSample;
+    entry.compressed = compressData((const unsigned char*)rawData.constData(), rawData.size(), bytesPerSample);
+    insertEntry(key, generation, entry);
+  });
+}
+
+void compressedFrameCache::insertEntry(const frameKey &key, int generation, const frameEntry &entry)
+{
+  QMutexLocker lock(&mutex);
+  // Discard the frame if the frames of the handler were removed in the meantime or the cache was disabled
+  if (maxBytes == 0 || handlerGeneration.value(key.first) != generation || entry.compressed.isEmpty())
+    return;
+
+  if (frames.contains(key))
+  {
+    const frameEntry &oldEntry = frames[key];
+    stats.compressedBytes -= oldEntry.compressed.size();
+    stats.uncompressedBytes -= oldEntry.uncompressedSize;
+    frameOrder.removeOne(key);
+  }
+  frames.insert(key, entry);
+  frameOrder.append(key);
+  stats.compressedBytes += entry.compressed.size();
+  stats.uncompressedBytes += entry.uncompressedSize;
+  stats.nrFrames = frames.size();
+  DEBUG_COMPRESSED("compressedFrameCache::insertEntry frame %d compressed from %d to %d bytes", key.second, entry.uncompressedSize, entry.compressed.size());
+
+  removeOldestFrames();
+}
+
+bool compressedFrameCache::getEntry(const frameKey &key, bool imageEntry, frameEntry &entry)
+{
+  QMutexLocker lock(&mutex);
+  if (maxBytes == 0)
+    return false;
+  const bool found = frames.contains(key) && frames[key].imageSize.isValid() == imageEntry;
+  if (found)
+  {
+    entry = frames[key];
+    stats.compressedHits++;
+  }
+  else
+    stats.compressedMisses++;
+  return found;
+}
+
+bool compressedFrameCache::getImage(const videoHandler *handler, int frameIdx, QImage &image)
+{
+  // The decompression is done without holding the lock
+  frameEntry entry;
+  if (!getEntry(frameKey(handler, frameIdx), true, entry))
+    return false;
+
+  QImage newImage(entry.imageSize, entry.imageFormat);
+  if (int(newImage.sizeInBytes()) != entry.uncompressedSize || !decompressData(entry.compressed, newImage.bits(), entry.uncompressedSize, entry.predictionStride))
+    return false;
+  DEBUG_COMPRESSED("compressedFrameCache::getImage frame %d", frameIdx);
+  image = newImage;
+  return true;
+}
+
+bool compressedFrameCache::getRawData(const videoHandler *handler, int frameIdx, QByteArray &rawData)
+{
+  frameEntry entry;
+  if (!getEntry(frameKey(handler, frameIdx), false, entry))
+    return false;
+
+  QByteArray newData;
+  newData.resize(entry.uncompressedSize);
+  if (!decompressData(entry.compressed, (unsigned char*)newData.data(), entry.uncompressedSize, entry.predictionStride))
+    return false;
+  DEBUG_COMPRESSED("compressedFrameCache::getRawData frame %d", frameIdx);
+  rawData = newData;
+  return true;
+}
+
+bool compressedFrameCache::contains(const videoHandler *handler, int frameIdx) const
+{
+  QMutexLocker lock(&mutex);
+  return frames.contains(frameKey(handler, frameIdx));
+}
+
+void compressedFrameCache::remove(const videoHandler *handler, int frameIdx)
+{
+  QMutexLocker lock(&mutex);
+  const frameKey key(handler, frameIdx);
+  auto it = frames.find(key);
+  if (it == frames.end())
+    return;
+  stats.compressedBytes -= it->compressed.size();
+  stats.uncompressedBytes -= it->uncompressedSize;
+  frames.erase(it);
+  frameOrder.removeOne(key);
+  stats.nrFrames = frames.size();
+}
+
+void compressedFrameCache::removeAll(const videoHandler *handler)
+{
+  QMutexLocker lock(&mutex);
+  handlerGeneration[handler]++;
+  for (auto it = frames.begin(); it != frames.end();)
+  {
+    if (it.key().first == handler)
+    {
+      stats.compressedBytes -= it->compressed.size();
+      stats.uncompressedBytes -= it->uncompressedSize;
+      it = frames.erase(it);
+    }
+    else
+      ++it;
+  }
+  frameOrder.erase(std::remove_if(frameOrder.begin(), frameOrder.end(), [handler](const frameKey &key) { return key.first == handler; }), frameOrder.end());
+  stats.nrFrames = frames.size();
+}
+
+void compressedFrameCache::removeOldestFrames()
+{
+  while (!frameOrder.isEmpty() && stats.compressedBytes > maxBytes)
+  {
+    const frameKey key = frameOrder.takeFirst();
+    auto it = frames.find(key);
+    if (it != frames.end())
+    {
+      stats.compressedBytes -= it->compressed.size();
+      stats.uncompressedBytes -= it->uncompressedSize;
+      frames.erase(it);
+    }
+  }
+  stats.nrFrames = frames.size();
+}
+
+compressedFrameCache::statistics compressedFrameCache::getStatistics() const
+{
+  QMutexLocker lock(&mutex);
+  return stats;
+}
+
+void compressedFrameCache::countHotTierAccess(bool hit)
+{
+  QMutexLocker lock(&mutex);
+  if (hit)
+    stats.hotHits++;
+  else
+    stats.hotMisses++;
+}
+
+QByteArray compressedFrameCache::compressData(const unsigned char *data, int size, int predictionStride)
+{
+  if (size <= 0)
+    return QByteArray();
+
+  // Predict every value from the value to the left. For natural images most residuals are close to 0 which deflate
+  // compresses much better than the values themselves.
+  const int stride = std::max(1, std::min(predictionStride, size));
+  QByteArray residuals;
+  residuals.resize(size);
+  auto res = (unsigned char*)residuals.data();
+  for (int i = 0; i < stride; i++)
+    res[i] = data[i];
+  for (int i = stride; i < size; i++)
+    res[i] = (unsigned char)(data[i] - data[i - stride]);
+
+  // The fastest compression level. The compression has to keep up with the caching.
+  return qCompress(residuals, 1);
+}
+
+bool compressedFrameCache::decompressData(const QByteArray &compressed, unsigned char *dst, int size, int predictionStride)
+{
+  const QByteArray residuals = qUncompress(compressed);
+  if (residuals.size() != size)
+    return false;
+
+  const int stride = std::max(1, std::min(predictionStride, size));
+  auto res = (const unsigned char*)residuals.constData();
+  for (int i = 0; i < stride; i++)
+    dst[i] = res[i];
+  for (int i = stride; i < size; i++)
+    dst[i] = (unsigned char)(res[i] + dst[i - stride]);
+  return true;
+}
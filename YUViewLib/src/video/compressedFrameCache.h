@@ -0,0 +1,126 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+
+class videoHandler;
+
+/* The second tier of the video cache. Frames that are removed from the cache of a video handler (the hot tier with the
+ * converted images or the raw data) can be kept here in a losslessly compressed form. If such a frame is needed again, it
+ * is decompressed in the thread that loads the frame instead of loading (and decoding) it again.
+ * The compression uses a left neighbor prediction of the samples followed by deflate. The compression of evicted frames is
+ * performed in the background lane of the shared taskPool. All video handlers share one compressed cache which has its
+ * own size limit. If it is full, the oldest frames are removed first.
+ * All functions are thread-safe.
+ */
+class compressedFrameCache
+{
+public:
+  static compressedFrameCache &instance();
+
+  // Set the maximum size of the compressed frames in bytes. 0 disables the compressed cache.
+  void setMaxSize(int64_t maxBytes);
+  bool isEnabled() const;
+
+  // Compress the given image or raw data (in the background) and add it to the cache. For raw data, the number of bytes
+  // per sample is used for the prediction.
+  void insert(const videoHandler *handler, int frameIdx, const QImage &image);
+  void insert(const videoHandler *handler, int frameIdx, const QByteArray &rawData, int bytesPerSample);
+
+  // Get and decompress a frame. Returns false if the frame is not in the cache (or it is not an image/raw data).
+  bool getImage(const videoHandler *handler, int frameIdx, QImage &image);
+  bool getRawData(const videoHandler *handler, int frameIdx, QByteArray &rawData);
+  bool contains(const videoHandler *handler, int frameIdx) const;
+
+  void remove(const videoHandler *handler, int frameIdx);
+  // Remove all frames of the handler. Frames of the handler which are currently compressed are discarded.
+  void removeAll(const videoHandler *handler);
+
+  // The hit/miss statistics of both tiers. The hot tier is counted when a frame is drawn (in the cache or not).
+  // The compressed tier is counted when a frame that is not in the hot tier is loaded.
+  struct statistics
+  {
+    int64_t hotHits {0};
+    int64_t hotMisses {0};
+    int64_t compressedHits {0};
+    int64_t compressedMisses {0};
+    int nrFrames {0};
+    int64_t compressedBytes {0};
+    int64_t uncompressedBytes {0};
+    int64_t maxBytes {0};
+  };
+  statistics getStatistics() const;
+  void countHotTierAccess(bool hit);
+
+  // The lossless codec. The data is predicted from the value predictionStride bytes to the left (e.g. 4 for BGRA,
+  // 2 for 16 bit samples) and the residuals are compressed with deflate.
+  static QByteArray compressData(const unsigned char *data, int size, int predictionStride);
+  // Decompress the data into dst which must have exactly the size of the uncompressed data. Returns false on an error.
+  static bool decompressData(const QByteArray &compressed, unsigned char *dst, int size, int predictionStride);
+
+private:
+  compressedFrameCache() {}
+
+  typedef QPair<const videoHandler*, int> frameKey;
+  struct frameEntry
+  {
+    QByteArray compressed;
+    int uncompressedSize {0};
+    int predictionStride {1};
+    // For images: The size and the format of the image. For raw data, the image size is invalid.
+    QSize imageSize;
+    QImage::Format imageFormat {QImage::Format_Invalid};
+  };
+
+  void insertEntry(const frameKey &key, int generation, const frameEntry &entry);
+  bool getEntry(const frameKey &key, bool imageEntry, frameEntry &entry);
+  // Remove the oldest frames until the size limit is met. The mutex must be locked.
+  void removeOldestFrames();
+
+  mutable QMutex mutex;
+  QHash<frameKey, frameEntry> frames;
+  // The order in which the frames were added (oldest first)
+  QList<frameKey> frameOrder;
+  // Frames that are added while the frames of a handler are removed (removeAll) are discarded
+  QHash<const videoHandler*, int> handlerGeneration;
+  int64_t maxBytes {0};
+  statistics stats;
+};
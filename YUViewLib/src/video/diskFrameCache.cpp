@@ -0,0 +1,185 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "diskFrameCache.h"
+
+#include <algorithm>
+#include <climits>
+#include <QDir>
+#include <QMutexLocker>
+
+// Activate this if you want to know when frames are written to or read from the disk
+#define DISKFRAMECACHE_DEBUG_OUTPUT 0
+#if DISKFRAMECACHE_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_DISKCACHE qDebug
+#else
+#define DEBUG_DISKCACHE(fmt,...) ((void)0)
+#endif
+
+void diskFrameCache::setLimits(const QString &newDirectory, int64_t newMaxBytes)
+{
+  QMutexLocker lock(&mutex);
+  newMaxBytes = std::max(newMaxBytes, int64_t(0));
+  if (newDirectory == directory && newMaxBytes == maxBytes)
+    return;
+
+  closeFile();
+  directory = newDirectory;
+  maxBytes = newMaxBytes;
+}
+
+bool diskFrameCache::isEnabled() const
+{
+  QMutexLocker lock(&mutex);
+  return !directory.isEmpty() && maxBytes > 0;
+}
+
+bool diskFrameCache::write(int frameIdx, const QByteArray &data)
+{
+  QMutexLocker lock(&mutex);
+  if (directory.isEmpty() || maxBytes == 0 || data.isEmpty())
+    return false;
+
+  if (!file || data.size() != slotSize)
+  {
+    // The first frame or the size of the frames changed
+    closeFile();
+    if (!openFile(data.size()))
+    {
+      // Don't try again until the settings change
+      DEBUG_DISKCACHE("diskFrameCache::write Creating the file in %s failed", directory.toLatin1().data());
+      maxBytes = 0;
+      return false;
+    }
+  }
+
+  if (frameSlot.contains(frameIdx))
+    // The frame is already stored
+    return true;
+
+  int slot;
+  if (!freeSlots.isEmpty())
+    slot = freeSlots.takeLast();
+  else
+  {
+    // Overwrite the least recently used frame
+    const int oldestFrame = frameOrder.takeFirst();
+    slot = frameSlot.take(oldestFrame);
+  }
+
+  // The frames are written with a normal write (and not through a memory mapping of the file). If the disk is full,
+  // the write fails instead of raising a signal.
+  if (!file->seek(slot * slotSize) || file->write(data) != slotSize)
+  {
+    // Don't try again until the settings change
+    DEBUG_DISKCACHE("diskFrameCache::write Writing frame %d failed. Disabling the store.", frameIdx);
+    closeFile();
+    maxBytes = 0;
+    return false;
+  }
+  frameSlot.insert(frameIdx, slot);
+  frameOrder.append(frameIdx);
+  DEBUG_DISKCACHE("diskFrameCache::write frame %d to slot %d", frameIdx, slot);
+  return true;
+}
+
+bool diskFrameCache::read(int frameIdx, QByteArray &data)
+{
+  QMutexLocker lock(&mutex);
+  auto it = frameSlot.find(frameIdx);
+  if (it == frameSlot.end())
+    return false;
+
+  QByteArray frameData;
+  frameData.resize(int(slotSize));
+  if (!file->seek(it.value() * slotSize) || file->read(frameData.data(), slotSize) != slotSize)
+  {
+    DEBUG_DISKCACHE("diskFrameCache::read Reading frame %d failed", frameIdx);
+    frameOrder.removeOne(frameIdx);
+    freeSlots.append(it.value());
+    frameSlot.erase(it);
+    return false;
+  }
+  data = frameData;
+
+  frameOrder.removeOne(frameIdx);
+  frameOrder.append(frameIdx);
+  DEBUG_DISKCACHE("diskFrameCache::read frame %d from slot %d", frameIdx, it.value());
+  return true;
+}
+
+bool diskFrameCache::contains(int frameIdx) const
+{
+  QMutexLocker lock(&mutex);
+  return frameSlot.contains(frameIdx);
+}
+
+void diskFrameCache::clear()
+{
+  QMutexLocker lock(&mutex);
+  closeFile();
+}
+
+bool diskFrameCache::openFile(int64_t newSlotSize)
+{
+  const int64_t nrSlots = maxBytes / newSlotSize;
+  if (nrSlots < 1 || nrSlots > INT_MAX)
+    return false;
+
+  if (!QDir().mkpath(directory))
+    return false;
+  // The file grows when the slots are written. Nothing is reserved up front.
+  file.reset(new QTemporaryFile(QDir(directory).filePath("YUViewFrameCache_XXXXXX")));
+  if (!file->open())
+  {
+    file.reset();
+    return false;
+  }
+
+  slotSize = newSlotSize;
+  for (int i = int(nrSlots) - 1; i >= 0; i--)
+    freeSlots.append(i);
+  DEBUG_DISKCACHE("diskFrameCache::openFile %s with %d slots of %d bytes", file->fileName().toLatin1().data(), int(nrSlots), int(slotSize));
+  return true;
+}
+
+void diskFrameCache::closeFile()
+{
+  // The temporary file is deleted
+  file.reset();
+  slotSize = 0;
+  frameSlot.clear();
+  frameOrder.clear();
+  freeSlots.clear();
+}
@@ -0,0 +1,90 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QString>
+#include <QTemporaryFile>
+
+/* A store for decoded frames on disk. Decoding a frame of a compressed item can require decoding all frames from the
+ * previous random access point. If the decoded frame is in this store, it can be read back instead.
+ * All frames are stored in one temporary file in the given directory. The file is split into slots of the size of one
+ * frame. The number of slots is limited by the maximum size. If all slots are used, the slot of the least recently
+ * used frame is overwritten. The file is created when the first frame is written and it is deleted when the store is
+ * cleared or destroyed. The slots are written and read with normal file I/O (not mapped), so a full disk is an error
+ * of the write and not a signal on access of a mapping. If writing fails, the store is disabled until the settings change.
+ * All functions are thread-safe.
+ */
+class diskFrameCache
+{
+public:
+  diskFrameCache() {}
+  ~diskFrameCache() { clear(); }
+
+  // Set the directory and the maximum size of the file. An empty directory or a size of 0 disables the store.
+  // If the settings change, all stored frames are removed.
+  void setLimits(const QString &directory, int64_t maxBytes);
+  bool isEnabled() const;
+
+  // Write the frame into the store. All frames must have the same size. If the size changes, all stored frames are removed.
+  bool write(int frameIdx, const QByteArray &data);
+  // Read the frame from the store. Returns false if the frame is not in the store.
+  bool read(int frameIdx, QByteArray &data);
+  bool contains(int frameIdx) const;
+
+  // Remove all frames and delete the file
+  void clear();
+
+private:
+  // Create the file with slots of the given size. The mutex must be locked.
+  bool openFile(int64_t newSlotSize);
+  void closeFile();
+
+  mutable QMutex mutex;
+  QString directory;
+  int64_t maxBytes {0};
+
+  QScopedPointer<QTemporaryFile> file;
+  int64_t slotSize {0};
+
+  // The slot of each stored frame and the order in which the frames were used (least recently used first)
+  QHash<int, int> frameSlot;
+  QList<int> frameOrder;
+  QList<int> freeSlots;
+};
@@ -0,0 +1,176 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "frameCacheIndex.h"
+
+frameCacheIndex::~frameCacheIndex()
+{
+  for (int t = 0; t < nrTables; t++)
+  {
+    table *tbl = tables[t].loadAcquire();
+    if (tbl == nullptr)
+      continue;
+    for (int p = 0; p < pagesPerTable; p++)
+      delete tbl->pages[p].loadAcquire();
+    delete tbl;
+  }
+}
+
+frameCacheIndex::page *frameCacheIndex::getPage(int frameIdx, bool create) const
+{
+  if (frameIdx < 0)
+    return nullptr;
+
+  const int pageIdx = frameIdx >> framesPerPageLog2;
+  auto &tablePtr = tables[pageIdx >> pagesPerTableLog2];
+  table *tbl = tablePtr.loadAcquire();
+  if (tbl == nullptr)
+  {
+    if (!create)
+      return nullptr;
+    tbl = new table;
+    tablePtr.storeRelease(tbl);
+  }
+
+  auto &pagePtr = tbl->pages[pageIdx & (pagesPerTable - 1)];
+  page *pg = pagePtr.loadAcquire();
+  if (pg == nullptr && create)
+  {
+    pg = new page;
+    pagePtr.storeRelease(pg);
+  }
+  return pg;
+}
+
+bool frameCacheIndex::contains(int frameIdx) const
+{
+  const page *pg = getPage(frameIdx, false);
+  if (pg == nullptr)
+    return false;
+  const int i = frameIdx & (framesPerPage - 1);
+  return (pg->bits[i / 64].loadAcquire() >> (i % 64)) & 1;
+}
+
+int64_t frameCacheIndex::getAccessTime(int frameIdx) const
+{
+  const page *pg = getPage(frameIdx, false);
+  if (pg == nullptr)
+    return 0;
+  return pg->accessTime[frameIdx & (framesPerPage - 1)].loadAcquire();
+}
+
+QList<int> frameCacheIndex::getFrames() const
+{
+  QList<int> frames;
+  const int n = count();
+  if (n == 0)
+    return frames;
+  frames.reserve(n);
+
+  for (int t = 0; t < nrTables; t++)
+  {
+    const table *tbl = tables[t].loadAcquire();
+    if (tbl == nullptr)
+      continue;
+    for (int p = 0; p < pagesPerTable; p++)
+    {
+      const page *pg = tbl->pages[p].loadAcquire();
+      if (pg == nullptr)
+        continue;
+      const int firstFrame = ((t << pagesPerTableLog2) + p) << framesPerPageLog2;
+      for (int w = 0; w < framesPerPage / 64; w++)
+      {
+        quint64 bits = pg->bits[w].loadAcquire();
+        for (int b = 0; bits != 0; b++, bits >>= 1)
+          if (bits & 1)
+            frames.append(firstFrame + w * 64 + b);
+      }
+    }
+  }
+  return frames;
+}
+
+void frameCacheIndex::insert(int frameIdx, int64_t accessTime)
+{
+  page *pg = getPage(frameIdx, true);
+  if (pg == nullptr)
+    return;
+  const int i = frameIdx & (framesPerPage - 1);
+  // The access time is set before the bit so that a reader that sees the bit also sees the time
+  pg->accessTime[i].storeRelease(accessTime);
+  const quint64 mask = quint64(1) << (i % 64);
+  if ((pg->bits[i / 64].fetchAndOrOrdered(mask) & mask) == 0)
+    nrFrames.fetchAndAddOrdered(1);
+}
+
+void frameCacheIndex::remove(int frameIdx)
+{
+  page *pg = getPage(frameIdx, false);
+  if (pg == nullptr)
+    return;
+  const int i = frameIdx & (framesPerPage - 1);
+  const quint64 mask = quint64(1) << (i % 64);
+  if ((pg->bits[i / 64].fetchAndAndOrdered(~mask) & mask) != 0)
+    nrFrames.fetchAndSubOrdered(1);
+  pg->accessTime[i].storeRelease(0);
+}
+
+void frameCacheIndex::setAccessTime(int frameIdx, int64_t accessTime)
+{
+  page *pg = getPage(frameIdx, false);
+  if (pg != nullptr)
+    pg->accessTime[frameIdx & (framesPerPage - 1)].storeRelease(accessTime);
+}
+
+void frameCacheIndex::clear()
+{
+  if (nrFrames.loadAcquire() == 0)
+    return;
+  for (int t = 0; t < nrTables; t++)
+  {
+    table *tbl = tables[t].loadAcquire();
+    if (tbl == nullptr)
+      continue;
+    for (int p = 0; p < pagesPerTable; p++)
+    {
+      page *pg = tbl->pages[p].loadAcquire();
+      if (pg == nullptr)
+        continue;
+      for (auto &bits : pg->bits)
+        bits.storeRelease(0);
+      for (auto &time : pg->accessTime)
+        time.storeRelease(0);
+    }
+  }
+  nrFrames.storeRelease(0);
+}
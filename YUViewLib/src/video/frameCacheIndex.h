@@ -0,0 +1,94 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QList>
+
+/* The index of the frames in the cache of a video handler. For each frame there is one bit (is the frame cached?) and
+ * one slot with the last access time of the frame. The bits and slots are stored in pages of 4096 frames which are
+ * only allocated for the frame ranges that are actually cached. A directory of pages covers all non-negative frame
+ * indices.
+ * Reading (contains, count, getAccessTime, getFrames) is lock-free and does not allocate memory (except for the returned
+ * list of getFrames). So the video cache can query the state of many frames without waiting for a caching thread.
+ * Modifying the index (insert, remove, setAccessTime, clear) must be serialized by the owner of the index (the video
+ * handler does this with the mutex of its cache).
+ */
+class frameCacheIndex
+{
+public:
+  frameCacheIndex() {}
+  ~frameCacheIndex();
+
+  bool contains(int frameIdx) const;
+  int count() const { return nrFrames.loadAcquire(); }
+  // The last access time of the frame. 0 if the frame is not cached.
+  int64_t getAccessTime(int frameIdx) const;
+  // All cached frames in ascending order
+  QList<int> getFrames() const;
+
+  void insert(int frameIdx, int64_t accessTime);
+  void remove(int frameIdx);
+  void setAccessTime(int frameIdx, int64_t accessTime);
+  // Remove all frames. The pages are kept for the next frames.
+  void clear();
+
+private:
+  static const int framesPerPageLog2 = 12;
+  static const int framesPerPage = 1 << framesPerPageLog2;
+  static const int pagesPerTableLog2 = 10;
+  static const int pagesPerTable = 1 << pagesPerTableLog2;
+  // The directory has enough tables for all non-negative int frame indices
+  static const int nrTables = 1 << (31 - framesPerPageLog2 - pagesPerTableLog2);
+
+  struct page
+  {
+    QAtomicInteger<quint64> bits[framesPerPage / 64];
+    QAtomicInteger<qint64> accessTime[framesPerPage];
+  };
+  struct table
+  {
+    QAtomicPointer<page> pages[pagesPerTable];
+  };
+
+  // Get the page of the frame. If create is set, missing pages (and tables) are created.
+  page *getPage(int frameIdx, bool create) const;
+
+  mutable QAtomicPointer<table> tables[nrTables];
+  QAtomicInt nrFrames {0};
+
+  Q_DISABLE_COPY(frameCacheIndex)
+};
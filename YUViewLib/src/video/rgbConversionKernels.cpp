@@ -0,0 +1,312 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "rgbConversionKernels.h"
+
+#include "common/functions.h"
+#include "common/typedef.h"
+
+// SIMD_X86 is defined in typedef.h
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace RGB_Internals
+{
+
+RGBLineConversionParameters::RGBLineConversionParameters(int bitsPerValue, int valueStride, const int componentScale[3], const bool componentInvert[3], bool limitedRange) :
+  valueStride(valueStride), limitedRange(limitedRange)
+{
+  bytesPerValue = (bitsPerValue > 8) ? 2 : 1;
+  shift = (bitsPerValue > 8) ? bitsPerValue - 8 : 0;
+  for (int c = 0; c < 3; c++)
+  {
+    scale[c] = componentScale[c];
+    invertMask[c] = componentInvert[c] ? 255 : 0;
+  }
+}
+
+namespace
+{
+
+// ------------------ Scalar (C++) kernels ------------------
+
+inline int convertValue(const int value, const int c, const RGBLineConversionParameters &par)
+{
+  int val = (value * par.scale[c]) >> par.shift;
+  val = (val < 0) ? 0 : (val > 255) ? 255 : val;
+  val ^= par.invertMask[c];
+  if (par.limitedRange)
+    val = scaleLimitedToFullRange(val);
+  return val;
+}
+
+// The type of the values and the stride are template parameters so that the compiler can optimize the loop for each format
+template<typename T, int valueStride>
+void convertLineToBGRAScalarFormat(const unsigned char * const src[3], unsigned char *dst, int n, const RGBLineConversionParameters &par)
+{
+  const T *srcR = (const T*)src[0];
+  const T *srcG = (const T*)src[1];
+  const T *srcB = (const T*)src[2];
+  for (int i = 0; i < n; i++)
+  {
+    dst[i*4  ] = convertValue(srcB[i*valueStride], 2, par);
+    dst[i*4+1] = convertValue(srcG[i*valueStride], 1, par);
+    dst[i*4+2] = convertValue(srcR[i*valueStride], 0, par);
+    dst[i*4+3] = 255;
+  }
+}
+
+void convertLineToBGRAScalar(const unsigned char * const src[3], unsigned char *dst, int n, const RGBLineConversionParameters &par)
+{
+  if (par.bytesPerValue == 1)
+  {
+    if (par.valueStride == 1)
+      convertLineToBGRAScalarFormat<unsigned char, 1>(src, dst, n, par);
+    else if (par.valueStride == 3)
+      convertLineToBGRAScalarFormat<unsigned char, 3>(src, dst, n, par);
+    else if (par.valueStride == 4)
+      convertLineToBGRAScalarFormat<unsigned char, 4>(src, dst, n, par);
+  }
+  else
+  {
+    if (par.valueStride == 1)
+      convertLineToBGRAScalarFormat<unsigned short, 1>(src, dst, n, par);
+    else if (par.valueStride == 3)
+      convertLineToBGRAScalarFormat<unsigned short, 3>(src, dst, n, par);
+    else if (par.valueStride == 4)
+      convertLineToBGRAScalarFormat<unsigned short, 4>(src, dst, n, par);
+  }
+}
+
+// Convert the remaining pixels after the SIMD loop
+inline void convertLineTail(const unsigned char * const src[3], unsigned char *dst, int i, int n, const RGBLineConversionParameters &par)
+{
+  const int offset = i * par.valueStride * par.bytesPerValue;
+  const unsigned char * const srcTail[3] = {src[0] + offset, src[1] + offset, src[2] + offset};
+  convertLineToBGRAScalar(srcTail, dst + i * 4, n - i, par);
+}
+
+#if SIMD_X86
+
+// ------------------ SSE4.1 kernels ------------------
+
+// The values of 4 pixels are moved to the 4 32 bit lanes using a byte shuffle. The 4 pixels span up to 32 bytes in the
+// input (16 bit packed RGBA). maskLo selects the bytes from the first 16 bytes, maskHi from the second 16 bytes.
+// Returns the number of bytes that must be readable (16 or 32).
+SIMD_TARGET("sse4.1")
+int getShuffleMasks(const RGBLineConversionParameters &par, __m128i &maskLo, __m128i &maskHi)
+{
+  alignas(16) int8_t lo[16];
+  alignas(16) int8_t hi[16];
+  for (int k = 0; k < 4; k++)
+  {
+    for (int j = 0; j < 4; j++)
+    {
+      // Bytes with the highest bit set in the mask are set to 0
+      lo[k*4+j] = -128;
+      hi[k*4+j] = -128;
+      if (j >= par.bytesPerValue)
+        continue;
+      const int offset = k * par.valueStride * par.bytesPerValue + j;
+      if (offset < 16)
+        lo[k*4+j] = int8_t(offset);
+      else
+        hi[k*4+j] = int8_t(offset - 16);
+    }
+  }
+  maskLo = _mm_load_si128((const __m128i*)lo);
+  maskHi = _mm_load_si128((const __m128i*)hi);
+  return (4 * par.valueStride * par.bytesPerValue > 16) ? 32 : 16;
+}
+
+SIMD_TARGET("sse4.1")
+inline __m128i loadValuesSSE41(const unsigned char *src, const __m128i maskLo, const __m128i maskHi, const bool loadHi)
+{
+  const __m128i values = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), maskLo);
+  if (!loadHi)
+    return values;
+  return _mm_or_si128(values, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 16)), maskHi));
+}
+
+SIMD_TARGET("sse4.1")
+inline __m128i convertValuesSSE41(__m128i val, const __m128i scale, const __m128i shift, const __m128i invertMask, const bool limitedRange)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max  = _mm_set1_epi32(255);
+  val = _mm_sra_epi32(_mm_mullo_epi32(val, scale), shift);
+  val = _mm_min_epi32(_mm_max_epi32(val, zero), max);
+  val = _mm_xor_si128(val, invertMask);
+  if (limitedRange)
+  {
+    // See scaleLimitedToFullRange
+    val = _mm_mullo_epi32(_mm_sub_epi32(val, _mm_set1_epi32(16)), _mm_set1_epi32(76305));
+    val = _mm_srai_epi32(_mm_add_epi32(val, _mm_set1_epi32(885)), 16);
+    val = _mm_min_epi32(_mm_max_epi32(val, zero), max);
+  }
+  return val;
+}
+
+SIMD_TARGET("sse4.1")
+void convertLineToBGRASSE41(const unsigned char * const src[3], unsigned char *dst, int n, const RGBLineConversionParameters &par)
+{
+  __m128i maskLo, maskHi;
+  const int loadBytes = getShuffleMasks(par, maskLo, maskHi);
+  const bool loadHi = (loadBytes > 16);
+  const int pixelBytes = par.valueStride * par.bytesPerValue;
+  // The number of bytes that can be read starting at the first value of each component
+  const int readableBytes = ((n - 1) * par.valueStride + 1) * par.bytesPerValue;
+
+  const __m128i shift = _mm_cvtsi32_si128(par.shift);
+  __m128i scale[3], invertMask[3];
+  for (int c = 0; c < 3; c++)
+  {
+    scale[c] = _mm_set1_epi32(par.scale[c]);
+    invertMask[c] = _mm_set1_epi32(par.invertMask[c]);
+  }
+  const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+
+  int i = 0;
+  for (; i + 4 <= n && i * pixelBytes + loadBytes <= readableBytes; i += 4)
+  {
+    const int offset = i * pixelBytes;
+    const __m128i r = convertValuesSSE41(loadValuesSSE41(src[0] + offset, maskLo, maskHi, loadHi), scale[0], shift, invertMask[0], par.limitedRange);
+    const __m128i g = convertValuesSSE41(loadValuesSSE41(src[1] + offset, maskLo, maskHi, loadHi), scale[1], shift, invertMask[1], par.limitedRange);
+    const __m128i b = convertValuesSSE41(loadValuesSSE41(src[2] + offset, maskLo, maskHi, loadHi), scale[2], shift, invertMask[2], par.limitedRange);
+
+    // Each 32 bit value is one pixel. In memory (little endian) this is B, G, R, A.
+    const __m128i bgra = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), alpha));
+    _mm_storeu_si128((__m128i*)(dst + i * 4), bgra);
+  }
+  convertLineTail(src, dst, i, n, par);
+}
+
+// ------------------ AVX2 kernels ------------------
+
+SIMD_TARGET("avx2")
+inline __m256i loadValuesAVX2(const unsigned char *src, const int pixelBytes, const __m128i maskLo, const __m128i maskHi, const bool loadHi)
+{
+  // The byte shuffle of AVX2 does not cross the 128 bit lanes. Get 4 pixels for each lane.
+  __m128i first = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), maskLo);
+  __m128i second = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 4 * pixelBytes)), maskLo);
+  if (loadHi)
+  {
+    first = _mm_or_si128(first, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 16)), maskHi));
+    second = _mm_or_si128(second, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 4 * pixelBytes + 16)), maskHi));
+  }
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1);
+}
+
+SIMD_TARGET("avx2")
+inline __m256i convertValuesAVX2(__m256i val, const __m256i scale, const __m128i shift, const __m256i invertMask, const bool limitedRange)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max  = _mm256_set1_epi32(255);
+  val = _mm256_sra_epi32(_mm256_mullo_epi32(val, scale), shift);
+  val = _mm256_min_epi32(_mm256_max_epi32(val, zero), max);
+  val = _mm256_xor_si256(val, invertMask);
+  if (limitedRange)
+  {
+    // See scaleLimitedToFullRange
+    val = _mm256_mullo_epi32(_mm256_sub_epi32(val, _mm256_set1_epi32(16)), _mm256_set1_epi32(76305));
+    val = _mm256_srai_epi32(_mm256_add_epi32(val, _mm256_set1_epi32(885)), 16);
+    val = _mm256_min_epi32(_mm256_max_epi32(val, zero), max);
+  }
+  return val;
+}
+
+SIMD_TARGET("avx2")
+void convertLineToBGRAAVX2(const unsigned char * const src[3], unsigned char *dst, int n, const RGBLineConversionParameters &par)
+{
+  __m128i maskLo, maskHi;
+  const int loadBytes = getShuffleMasks(par, maskLo, maskHi);
+  const bool loadHi = (loadBytes > 16);
+  const int pixelBytes = par.valueStride * par.bytesPerValue;
+  const int readableBytes = ((n - 1) * par.valueStride + 1) * par.bytesPerValue;
+
+  const __m128i shift = _mm_cvtsi32_si128(par.shift);
+  __m256i scale[3], invertMask[3];
+  for (int c = 0; c < 3; c++)
+  {
+    scale[c] = _mm256_set1_epi32(par.scale[c]);
+    invertMask[c] = _mm256_set1_epi32(par.invertMask[c]);
+  }
+  const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+
+  int i = 0;
+  for (; i + 8 <= n && (i + 4) * pixelBytes + loadBytes <= readableBytes; i += 8)
+  {
+    const int offset = i * pixelBytes;
+    const __m256i r = convertValuesAVX2(loadValuesAVX2(src[0] + offset, pixelBytes, maskLo, maskHi, loadHi), scale[0], shift, invertMask[0], par.limitedRange);
+    const __m256i g = convertValuesAVX2(loadValuesAVX2(src[1] + offset, pixelBytes, maskLo, maskHi, loadHi), scale[1], shift, invertMask[1], par.limitedRange);
+    const __m256i b = convertValuesAVX2(loadValuesAVX2(src[2] + offset, pixelBytes, maskLo, maskHi, loadHi), scale[2], shift, invertMask[2], par.limitedRange);
+
+    const __m256i bgra = _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(r, 16), alpha));
+    _mm256_storeu_si256((__m256i*)(dst + i * 4), bgra);
+  }
+  convertLineTail(src, dst, i, n, par);
+}
+
+#endif // SIMD_X86
+
+const rgbConversionKernels kernelsScalar = {&convertLineToBGRAScalar, "C++"};
+#if SIMD_X86
+const rgbConversionKernels kernelsSSE41 = {&convertLineToBGRASSE41, "SSE4.1"};
+const rgbConversionKernels kernelsAVX2 = {&convertLineToBGRAAVX2, "AVX2"};
+#endif
+
+const rgbConversionKernels *selectKernels()
+{
+#if SIMD_X86
+  if (functions::cpuSupportsAVX2())
+    return &kernelsAVX2;
+  if (functions::cpuSupportsSSE41())
+    return &kernelsSSE41;
+#endif
+  return &kernelsScalar;
+}
+
+} // namespace
+
+const rgbConversionKernels &getRGBConversionKernels()
+{
+  static const rgbConversionKernels *kernels = selectKernels();
+  return *kernels;
+}
+
+const rgbConversionKernels &getRGBConversionKernelsScalar()
+{
+  return kernelsScalar;
+}
+
+} // namespace RGB_Internals
@@ -0,0 +1,83 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace RGB_Internals
+{
+
+// The parameters for the conversion of one line of RGB values (8 to 16 bit, planar or packed) to 8 bit BGRA values.
+// The calculation is identical for all kernels: Every component is scaled, shifted to 8 bit, clipped, optionally inverted and
+// optionally scaled from limited to full range (like videoHandler::convScaleLimitedRange). The alpha value is set to 255.
+struct RGBLineConversionParameters
+{
+  RGBLineConversionParameters(int bitsPerValue, int valueStride, const int componentScale[3], const bool componentInvert[3], bool limitedRange);
+
+  // The number of bytes per value (1 for 8 bit, 2 for 9 to 16 bit in the native byte order)
+  int bytesPerValue;
+  // The number of values from one pixel to the next (1 for planar formats, the number of channels for packed formats)
+  int valueStride;
+  // Per component (R, G, B): The scale factor and the value that the clipped 8 bit value is xored with (255 for inversion, else 0)
+  int scale[3];
+  int invertMask[3];
+  // The right shift after scaling to get to 8 bit
+  int shift;
+  bool limitedRange;
+};
+
+// A set of kernels for the conversion of RGB data to BGRA. Like for the YUV conversion (yuvConversionKernels), the fastest
+// available implementation (AVX2, SSE4.1 or plain C++) is selected once at runtime.
+struct rgbConversionKernels
+{
+  // Convert n pixels to BGRA. src points to the first value of the R, G and B component of the line. For a gray scale
+  // image of one component, all three pointers point to the same component (with the same scale and inversion for all).
+  void (*convertLineToBGRA)(const unsigned char * const src[3], unsigned char *dst, int n, const RGBLineConversionParameters &par);
+  // The name of the implementation ("AVX2", "SSE4.1" or "C++")
+  const char *name;
+};
+
+// Scale a limited range 8 bit value (16 to 235) to full range. The result is identical to videoHandler::convScaleLimitedRange.
+inline int scaleLimitedToFullRange(int value)
+{
+  const int val = ((value - 16) * 76305 + 885) >> 16;
+  return (val < 0) ? 0 : (val > 255) ? 255 : val;
+}
+
+// Get the fastest kernels for the CPU that we are running on.
+const rgbConversionKernels &getRGBConversionKernels();
+// Get the plain C++ kernels. These are the reference for all SIMD kernels.
+const rgbConversionKernels &getRGBConversionKernelsScalar();
+
+} // namespace RGB_Internals
@@ -33,15 +33,22 @@
 #include "videoCache.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <limits>
 #include <QMessageBox>
 #include <QPainter>
 #include <QScrollArea>
 #include <QSettings>
-#include <QThread>
+#include <QVector>
 
+#include "common/frameBufferPool.h"
 #include "common/functions.h"
+#include "common/systemMemory.h"
+#include "common/taskPool.h"
 #include "ui/playbackController.h"
 #include "playlistitem/playlistItem.h"
+#include "video/compressedFrameCache.h"
+#include "video/videoHandler.h"
 
 // This debug setting has two values:
 // 1: Basic operation is written to qDebug: If a new item is selected, what is the decision to cache/remove next?
@@ -61,6 +68,15 @@
 #define DEBUG_CACHING_DETAIL(fmt,...) ((void)0)
 #endif
 
+// The frames of the selected item are cached in a window around the current frame. The window ahead of the
+// current frame contains at least PREFETCH_MIN_FRAMES frames or the frames of the next PREFETCH_SECONDS seconds
+// at the current speed of the playhead. The window behind the current frame is a quarter of that.
+#define PREFETCH_MIN_FRAMES 16
+#define PREFETCH_SECONDS 2.0
+
+// A caching worker caches up to this many frames of a job before it reports back to the main thread
+#define CACHING_BATCH_FRAMES 4
+
 #define CACHING_THREAD_JOBS_OUTPUT 0
 #if CACHING_THREAD_JOBS_OUTPUT && !NDEBUG
 #include <QDebug>
@@ -69,126 +85,117 @@
 #define DEBUG_JOBS(fmt,...) ((void)0)
 #endif
 
-/// ------------------------ loadingWorker ------------------------
+/// ------------------------ videoCache::loadingWorker ------------------------
 
-class loadingWorker : public QObject
+// A worker does not have its own thread. Its jobs are run as tasks in the shared taskPool. The worker only holds the
+// state of the job and reports (with the loadingFinished signal which is received in the main thread) when it is done.
+// A caching job can contain several frames of an item. These are cached one after another without a round trip
+// through the main thread.
+class videoCache::loadingWorker : public QObject
 {
   Q_OBJECT
 public:
-  loadingWorker(QObject *parent) : QObject(parent) { currentCacheItem = nullptr; working = false; id = id_counter++; }
+  loadingWorker(QObject *parent, taskPriority priority) : QObject(parent), priority(priority) { id = id_counter++; }
+  ~loadingWorker()
+  {
+    // Nothing may call back into the cache from here on. A job that was not started yet is dropped instead of
+    // running it in this thread. A running job is waited for.
+    disconnect();
+    if (!task.cancel())
+      task.waitForFinished();
+  }
   playlistItem *getCacheItem() { return currentCacheItem; }
-  int getCacheFrame() { return currentFrame; }
-  void setJob(playlistItem *item, int frame, bool test=false);
+  int getCacheFrame() { return currentFrame.loadAcquire(); }
+  void setJob(playlistItem *item, int frame, bool test=false) { setJob(item, QList<int>() << frame, test); }
+  void setJob(playlistItem *item, const QList<int> &frames, bool test=false);
+  // The frames of the last job that were processed. Frames of items that were tagged for deletion are skipped.
+  QList<int> getFramesDone() { return framesDone; }
   void setWorking(bool state) { working = state; }
   bool isWorking() { return working; }
-  QString getStatus() { return QString("T%1: %2").arg(id).arg(working ? QString::number(currentFrame) : QString("-")); }
-  // Process the job in the thread that this worker was moved to. This function can be directly
-  // called from the main thread. It will still process the call in the separate thread.
+  QString getStatus() { return QString("T%1: %2").arg(id).arg(working ? QString::number(getCacheFrame()) : QString("-")); }
+  // Submit the job to the task pool. This function is called from the main thread.
   void processCacheJob();
   void processLoadingJob(bool playing, bool loadRawData);
 signals:
   void loadingFinished();
-private slots:
+private:
   void processCacheJobInternal();
   void processLoadingJobInternal(bool playing, bool loadRawData);
-private:
-  playlistItem *currentCacheItem;
-  int currentFrame;
-  bool working;
-  bool testMode;
-  int id;   // A static ID of the thread. Only used in getStatus().
+  const taskPriority priority;
+  taskPool::taskHandle task;
+  playlistItem *currentCacheItem {nullptr};
+  QList<int> currentFrames;
+  QList<int> framesDone;
+  QAtomicInt currentFrame {-1};
+  bool working {false};
+  bool testMode {false};
+  int id;   // A static ID of the worker. Only used in getStatus().
   static int id_counter;
 };
-// Initially this is 0. The threads will number themselves so that there are never two threads with the same id
-int loadingWorker::id_counter = 0;
+// Initially this is 0. The workers will number themselves so that there are never two workers with the same id
+int videoCache::loadingWorker::id_counter = 0;
 
-void loadingWorker::setJob(playlistItem *item, int frame, bool test)
+void videoCache::loadingWorker::setJob(playlistItem *item, const QList<int> &frames, bool test)
 {
   Q_ASSERT_X(item != nullptr, Q_FUNC_INFO, "Given item is nullptr");
-  Q_ASSERT_X(frame >= 0 || !item->isIndexedByFrame(), Q_FUNC_INFO, "Given frame index invalid");
+  Q_ASSERT_X(!frames.isEmpty(), Q_FUNC_INFO, "No frames given");
+  Q_ASSERT_X(frames.first() >= 0 || !item->isIndexedByFrame(), Q_FUNC_INFO, "Given frame index invalid");
   currentCacheItem = item;
-  currentFrame = frame;
+  currentFrames = frames;
+  currentFrame.storeRelease(frames.first());
+  framesDone.clear();
   testMode = test;
 }
 
-void loadingWorker::processCacheJob()
+void videoCache::loadingWorker::processCacheJob()
 {
-  DEBUG_JOBS("loadingWorker::processCacheJob invoke processCacheJobInternal");
-  QMetaObject::invokeMethod(this, "processCacheJobInternal"); 
+  DEBUG_JOBS("loadingWorker::processCacheJob submit processCacheJobInternal");
+  task = taskPool::instance().submit([this]() { processCacheJobInternal(); }, priority);
 }
 
-void loadingWorker::processLoadingJob(bool playing, bool loadRawData)
+void videoCache::loadingWorker::processLoadingJob(bool playing, bool loadRawData)
 {
-  DEBUG_JOBS("loadingWorker::processLoadingJob invoke processLoadingJobInternal");
-  QMetaObject::invokeMethod(this, "processLoadingJobInternal", Q_ARG(bool, playing), Q_ARG(bool, loadRawData)); 
+  DEBUG_JOBS("loadingWorker::processLoadingJob submit processLoadingJobInternal");
+  task = taskPool::instance().submit([this, playing, loadRawData]() { processLoadingJobInternal(playing, loadRawData); }, priority);
 }
 
-void loadingWorker::processCacheJobInternal()
+void videoCache::loadingWorker::processCacheJobInternal()
 {
   Q_ASSERT_X(currentCacheItem != nullptr, Q_FUNC_INFO, "Invalid Job - Item is nullptr");
-  Q_ASSERT_X(currentFrame >= 0 || !currentCacheItem->isIndexedByFrame(), Q_FUNC_INFO, "Given frame index invalid");
   DEBUG_JOBS("loadingWorker::processCacheJobInternal");
 
-  // Just cache the frame that was given to us.
-  // This is performed in the thread that this worker is currently placed in.
-  currentCacheItem->cacheFrame(currentFrame, testMode);
-  
+  // Cache the frames that were given to us. This is performed in a thread of the task pool.
+  QList<int> done;
+  for (int frame : currentFrames)
+  {
+    if (currentCacheItem->taggedForDeletion())
+      break;
+    currentFrame.storeRelease(frame);
+    currentCacheItem->cacheFrame(frame, testMode);
+    done.append(frame);
+  }
+  framesDone = done;
+
   currentCacheItem = nullptr;
   DEBUG_JOBS("loadingWorker::processCacheJobInternal emit loadingFinished");
   emit loadingFinished();
 }
 
-void loadingWorker::processLoadingJobInternal(bool playing, bool loadRawData)
+void videoCache::loadingWorker::processLoadingJobInternal(bool playing, bool loadRawData)
 {
   Q_ASSERT_X(currentCacheItem != nullptr, Q_FUNC_INFO, "The set job is nullptr");
-  Q_ASSERT_X((!currentCacheItem->isIndexedByFrame() || currentFrame >= 0), Q_FUNC_INFO, "The set frame index is invalid");
+  Q_ASSERT_X((!currentCacheItem->isIndexedByFrame() || getCacheFrame() >= 0), Q_FUNC_INFO, "The set frame index is invalid");
   Q_ASSERT_X(!currentCacheItem->taggedForDeletion(), Q_FUNC_INFO, "The set job was tagged for deletion");
   DEBUG_JOBS(Q_FUNC_INFO);
 
-  // Load the frame of the item that was given to us.
-  // This is performed in the thread (the loading thread with higher priority.
-  currentCacheItem->loadFrame(currentFrame, playing, loadRawData);
+  // Load the frame of the item that was given to us. This is performed in a thread of the task pool (interactive lane).
+  currentCacheItem->loadFrame(getCacheFrame(), playing, loadRawData);
 
   currentCacheItem = nullptr;
   emit loadingFinished();
   DEBUG_JOBS("loadingWorker::processLoadingJobInternal emit loadingFinished");
 }
 
-/// -------------------------- videoCache::loadingThread --------------------
-
-class videoCache::loadingThread : public QThread
-{
-  Q_OBJECT
-public:
-  loadingThread(QObject *parent) : QThread(parent)
-  {
-    // Create a new worker and move it to this thread
-    threadWorker.reset(new loadingWorker(nullptr));
-    threadWorker->moveToThread(this);
-    quitting = false;
-  }
-  void quitWhenDone()
-  {
-    quitting = true;
-    if (threadWorker->isWorking())
-    {
-      // We must wait until the worker is done.
-      DEBUG_CACHING("loadingThread::quitWhenDone waiting for worker to finish...");
-      connect(worker(), &loadingWorker::loadingFinished, this, [=]{DEBUG_CACHING("loadingThread::quitWhenDone worker done -> quit"); quit();});
-    }
-    else
-    {
-      DEBUG_CACHING("loadingThread::quitWhenDone quit now");
-      quit();
-    }
-  }
-  loadingWorker *worker() { return threadWorker.data(); }
-  bool isQuitting() { return quitting; }
-private:
-  QScopedPointer<loadingWorker> threadWorker;
-  bool quitting;  // Are er quitting the job? If yes, do not push new jobs to it.
-};
-
 /// ---------------------------------- videoCache ------------------------------
 
 videoCache::videoCache(PlaylistTreeWidget *playlistTreeWidget, PlaybackController *playbackController, splitViewWidget *view, QWidget *parent)
@@ -199,19 +206,18 @@ videoCache::videoCache(PlaylistTreeWidget *playlistTreeWidget, PlaybackControlle
   splitView = view;
   parentWidget = parent;
   
-  // Create the interactive threads
+  // Create the interactive workers. Their jobs run in the interactive lane of the task pool.
   for (int i=0; i<2; i++)
   {
-    interactiveThread[i] = new loadingThread(this);
-    interactiveThread[i]->start(QThread::HighPriority);
-    connect(interactiveThread[i]->worker(), &loadingWorker::loadingFinished, this, &videoCache::interactiveLoaderFinished);
+    interactiveWorker[i] = new loadingWorker(this, taskPriority::interactive);
+    connect(interactiveWorker[i], &loadingWorker::loadingFinished, this, &videoCache::interactiveLoaderFinished);
 
     // Clear the slots for queued jobs
     interactiveItemQueued[i] = nullptr;
     interactiveItemQueued_Idx[i] = -1;
   }
 
-  // Update some values from the QSettings. This will also create the correct number of threads.
+  // Update some values from the QSettings. This will also create the correct number of workers.
   updateSettings();
 
   connect(playlist.data(), &PlaylistTreeWidget::playlistChanged, this, &videoCache::scheduleCachingListUpdate);
@@ -219,58 +225,54 @@ videoCache::videoCache(PlaylistTreeWidget *playlistTreeWidget, PlaybackControlle
   connect(playlist.data(), &PlaylistTreeWidget::signalItemRecache, this, &videoCache::itemNeedsRecache);
   connect(playback.data(), &PlaybackController::waitForItemCaching, this, &videoCache::watchItemForCachingFinished);
   connect(playback.data(), &PlaybackController::signalPlaybackStarting, this, &videoCache::updateCacheQueue);
+  connect(playback.data(), &PlaybackController::signalCurrentFrameChanged, this, &videoCache::currentFrameChanged);
   connect(&statusUpdateTimer, &QTimer::timeout, this, [=]{ emit updateCacheStatus(); });
   connect(&testProgrssUpdateTimer, &QTimer::timeout, this, [=]{ updateTestProgress(); });
+  connect(&memoryBudgetTimer, &QTimer::timeout, this, [=]{
+    if (updateCacheBudget())
+    {
+      // While the workers are being stopped, the queue is updated the next time the budget is checked
+      if (workersState == workersIdle || workersState == workersRunning)
+        scheduleCachingListUpdate();
+      emit updateCacheStatus();
+    }
+  });
 }
 
 videoCache::~videoCache()
 {
-  DEBUG_CACHING("videoCache::~videoCache Terminate all workers and threads");
-
-  // Tell all threads to quit
-  for (loadingThread *t : cachingThreadList)
-    t->quitWhenDone();
-  interactiveThread[0]->quitWhenDone();
-  interactiveThread[1]->quitWhenDone();
-
-  // Wait for the threads to quit, otherwise terminate them
-  for (int i=0; i<2; i++)
-    if (!interactiveThread[i]->wait(3000))
-    {
-      interactiveThread[i]->terminate();
-      interactiveThread[i]->wait();
-    }
-  for (loadingThread *t : cachingThreadList)
-    if (!t->wait(3000))
-    {
-      t->terminate();
-      t->wait();
-    }
-
-  // Delete all threads
-  for (loadingThread *t : cachingThreadList)
-    t->deleteLater();
+  DEBUG_CACHING("videoCache::~videoCache Wait for all workers");
+
+  // The workers wait for their running task when they are deleted. Do this before the rest of the cache goes away.
+  // Take the workers out of the list first so that nothing can reach a deleted worker through it.
+  const QList<loadingWorker*> workers = cachingWorkerList;
+  cachingWorkerList.clear();
+  for (loadingWorker *w : workers)
+    delete w;
+  delete interactiveWorker[0];
+  delete interactiveWorker[1];
 }
 
-void videoCache::startWorkerThreads(int nrThreads)
+void videoCache::startCachingWorkers(int nrWorkers)
 {
-  for (int i = 0; i < nrThreads; i++)
+  for (int i = 0; i < nrWorkers; i++)
   {
-    loadingThread *newThread = new loadingThread(this);
-    cachingThreadList.append(newThread);
-
-    // Caching should run in the background without interrupting normal operation. Start with lowest priority.
-    newThread->start(QThread::LowestPriority);
+    // Caching runs in the background lane of the task pool without interrupting normal operation.
+    loadingWorker *newWorker = new loadingWorker(this, taskPriority::background);
+    cachingWorkerList.append(newWorker);
 
     // Connect the signals/slots to communicate with the cacheWorker.
-    connect(newThread->worker(), &loadingWorker::loadingFinished, this, &videoCache::threadCachingFinished);
+    connect(newWorker, &loadingWorker::loadingFinished, this, &videoCache::threadCachingFinished);
 
-    DEBUG_CACHING("videoCache::startWorkerThreads Started thread %p", newThread);
+    DEBUG_CACHING("videoCache::startCachingWorkers Started worker %p", newWorker);
 
     if (workersState == workersRunning)
       // Push the next job to the worker. Otherwise it will not start working if caching is currently running.
-      pushNextJobToCachingThread(newThread);
+      pushNextJobToCachingWorker(newWorker);
   }
+
+  // While all caching workers are busy, there must still be threads for the interactive workers
+  taskPool::instance().reserveThreads(cachingWorkerList.count() + 2);
 }
 
 void videoCache::updateSettings()
@@ -281,7 +283,29 @@ void videoCache::updateSettings()
   QSettings settings;
   settings.beginGroup("VideoCache");
   cachingEnabled = settings.value("Enabled", true).toBool();
-  cacheLevelMax = (int64_t)settings.value("ThresholdValueMB", 49).toUInt() * 1000 * 1000;
+  cacheLevelThreshold = (int64_t)settings.value("ThresholdValueMB", 49).toUInt() * 1000 * 1000;
+  adaptiveCacheSize = settings.value("AdaptiveCacheSize", false).toBool();
+  cacheLevelMax = cacheLevelThreshold;
+  updateCacheBudget();
+  if (adaptiveCacheSize && cachingEnabled)
+    memoryBudgetTimer.start(1000);
+  else
+    memoryBudgetTimer.stop();
+
+  // Cache the raw data instead of the converted images? If this changed, all cached frames have to be cached again.
+  const bool cacheRawData = settings.value("CacheRawData", false).toBool();
+  if (cacheRawData != videoHandler::isRawDataCachingEnabled())
+  {
+    videoHandler::setRawDataCachingEnabled(cacheRawData);
+    for (auto item : playlist->getAllPlaylistItems())
+      itemNeedsRecache(item, RECACHE_CLEAR);
+  }
+
+  // Frames that are removed from the cache can be kept in the compressed cache
+  int64_t compressedCacheMax = 0;
+  if (cachingEnabled && settings.value("CompressedCacheEnabled", false).toBool())
+    compressedCacheMax = (int64_t)settings.value("CompressedCacheMB", 1000).toUInt() * 1000 * 1000;
+  compressedFrameCache::instance().setMaxSize(compressedCacheMax);
 
   // See if the user changed the number of threads
   int targetNrThreads = functions::getOptimalThreadCount();
@@ -298,33 +322,32 @@ void videoCache::updateSettings()
   else
     nrThreadsPlayback = 0;
 
-  if (targetNrThreads > cachingThreadList.count())
-    // Create new threads
-    startWorkerThreads(targetNrThreads - cachingThreadList.count());
-  else if (targetNrThreads < cachingThreadList.count())
+  if (targetNrThreads > cachingWorkerList.count())
+    // Create new workers
+    startCachingWorkers(targetNrThreads - cachingWorkerList.count());
+  else if (targetNrThreads < cachingWorkerList.count())
   {
-    // Remove threads. We can only delete workers (and their threads) that are currently not working.
-    int nrThreadsToRemove = cachingThreadList.count() - targetNrThreads;
+    // Remove workers. We can only delete workers that are currently not working.
+    int nrWorkersToRemove = cachingWorkerList.count() - targetNrThreads;
 
-    for (int i = cachingThreadList.count()-1; i >= 0  && nrThreadsToRemove > 0; i--)
+    for (int i = cachingWorkerList.count()-1; i >= 0  && nrWorkersToRemove > 0; i--)
     {
-      if (!cachingThreadList[i]->worker()->isWorking())
+      if (!cachingWorkerList[i]->isWorking())
       {
         // Not working -> delete it now
-        QThread *t = cachingThreadList.takeAt(i);
-        t->exit();
-        t->deleteLater();
+        loadingWorker *w = cachingWorkerList.takeAt(i);
+        w->deleteLater();
 
-        DEBUG_CACHING("videoCache::updateSettings Deleting thread %p with worker %d", t, i);
-        nrThreadsToRemove--;
+        DEBUG_CACHING("videoCache::updateSettings Deleting worker %p (%d)", w, i);
+        nrWorkersToRemove--;
       }
     }
 
-    if (nrThreadsToRemove > 0)
+    if (nrWorkersToRemove > 0)
     {
-      // We need to remove more threads but the workers in these threads are still running. Do this when the workers finish.
-      DEBUG_CACHING("videoCache::updateSettings Deleting %d threads later", nrThreadsToRemove);
-      deleteNrThreads = nrThreadsToRemove;
+      // We need to remove more workers but they are still running. Do this when the workers finish.
+      DEBUG_CACHING("videoCache::updateSettings Deleting %d workers later", nrWorkersToRemove);
+      deleteNrWorkers = nrWorkersToRemove;
     }
   }
 
@@ -335,6 +358,36 @@ void videoCache::updateSettings()
   settings.endGroup();
 }
 
+bool videoCache::updateCacheBudget()
+{
+  if (!adaptiveCacheSize)
+  {
+    const bool changed = (cacheLevelMax != cacheLevelThreshold);
+    cacheLevelMax = cacheLevelThreshold;
+    cacheBudgetReason = "Threshold";
+    frameBufferPool::instance().setMaxSize(FRAME_BUFFER_POOL_DEFAULT_MAX_BYTES);
+    return changed;
+  }
+
+  const auto budget = systemMemory::getCacheBudget(systemMemory::readMemoryState(), cacheLevelCurrent, cacheLevelThreshold);
+  cacheBudgetReason = budget.reason;
+  // If memory is running low, the buffers of removed frames are freed instead of keeping them for reuse
+  frameBufferPool::instance().setMaxSize(budget.underPressure ? 0 : FRAME_BUFFER_POOL_DEFAULT_MAX_BYTES);
+  if (budget.bytes == cacheLevelMax)
+    return false;
+
+  // Shrinking below the current level means that frames have to be removed now. Growing is only worth an update
+  // of the queue if a noticeable amount of memory was added (the free memory changes slightly all the time).
+  const int64_t minChange = std::max(int64_t(16) * 1000 * 1000, cacheLevelMax / 50);
+  const bool update = (budget.bytes < cacheLevelCurrent) || (budget.bytes > cacheLevelMax + minChange);
+  if (update || budget.bytes < cacheLevelMax)
+  {
+    DEBUG_CACHING("videoCache::updateCacheBudget %lld MB (%s)", (long long)(budget.bytes / 1000000), budget.reason.toStdString().c_str());
+    cacheLevelMax = budget.bytes;
+  }
+  return update;
+}
+
 void videoCache::loadFrame(playlistItem * item, int frameIndex, int loadingSlot)
 {
   if (item == nullptr || item->taggedForDeletion() || (frameIndex < 0 && item->isIndexedByFrame()))
@@ -342,10 +395,10 @@ void videoCache::loadFrame(playlistItem * item, int frameIndex, int loadingSlot)
     return;
 
   assert(loadingSlot == 0 || loadingSlot == 1);
-  if (interactiveThread[loadingSlot]->worker()->isWorking())
+  if (interactiveWorker[loadingSlot]->isWorking())
   {
     // The interactive worker is currently busy ...
-    if (interactiveThread[loadingSlot]->worker()->getCacheItem() != item || interactiveThread[loadingSlot]->worker()->getCacheFrame() != frameIndex)
+    if (interactiveWorker[loadingSlot]->getCacheItem() != item || interactiveWorker[loadingSlot]->getCacheFrame() != frameIndex)
     {
       // ... and it is not working on the requested frame. Schedule this load request as the next one.
       DEBUG_CACHING_DETAIL("videoCache::loadFrame %d queued for later - slot %d", frameIndex, loadingSlot);
@@ -357,9 +410,9 @@ void videoCache::loadFrame(playlistItem * item, int frameIndex, int loadingSlot)
   {
     // Let the interactive worker work...
     bool loadRawData = splitView->showRawData() && !playback->playing();
-    interactiveThread[loadingSlot]->worker()->setJob(item, frameIndex);
-    interactiveThread[loadingSlot]->worker()->setWorking(true);
-    interactiveThread[loadingSlot]->worker()->processLoadingJob(playback->playing(), loadRawData);
+    interactiveWorker[loadingSlot]->setJob(item, frameIndex);
+    interactiveWorker[loadingSlot]->setWorking(true);
+    interactiveWorker[loadingSlot]->processLoadingJob(playback->playing(), loadRawData);
     DEBUG_CACHING_DETAIL("videoCache::loadFrame %d started - slot %d", frameIndex, loadingSlot);
 
     emit updateCacheStatus();
@@ -368,25 +421,25 @@ void videoCache::loadFrame(playlistItem * item, int frameIndex, int loadingSlot)
 
 void videoCache::interactiveLoaderFinished()
 {
-  // Get the thread that caused this call
+  // Get the worker that caused this call
   QObject *sender = QObject::sender();
   loadingWorker *worker = dynamic_cast<loadingWorker*>(sender);
-  int threadID = (interactiveThread[0]->worker() == worker) ? 0 : 1;
-  assert(worker == interactiveThread[0]->worker() || worker == interactiveThread[1]->worker());
+  int threadID = (interactiveWorker[0] == worker) ? 0 : 1;
+  assert(worker == interactiveWorker[0] || worker == interactiveWorker[1]);
 
   // Check the list of items that are scheduled for deletion. Because a loading thread finished, maybe now we can delete the item(s).
   for (auto it = itemsToDelete.begin(); it != itemsToDelete.end();)
   {
     // Is the item still being cached?
     bool itemCaching = false;
-    for (loadingThread *t : cachingThreadList)
-      if (t->worker()->getCacheItem() == *it)
+    for (loadingWorker *w : cachingWorkerList)
+      if (w->getCacheItem() == *it)
       {
         itemCaching = true;
         break;
       }
     // Is the item still being loaded?
-    bool loadingItem = (interactiveThread[0]->worker()->getCacheItem() == *it || interactiveThread[1]->worker()->getCacheItem() == *it);
+    bool loadingItem = (interactiveWorker[0]->getCacheItem() == *it || interactiveWorker[1]->getCacheItem() == *it);
 
     if (!itemCaching && !loadingItem)
     {
@@ -410,9 +463,9 @@ void videoCache::interactiveLoaderFinished()
   {
     // Let the interactive worker work on the queued request.
     bool loadRawData = splitView->showRawData() && !playback->playing();
-    interactiveThread[threadID]->worker()->setJob(interactiveItemQueued[threadID], interactiveItemQueued_Idx[threadID]);
-    interactiveThread[threadID]->worker()->setWorking(true);
-    interactiveThread[threadID]->worker()->processLoadingJob(playback->playing(), loadRawData);
+    interactiveWorker[threadID]->setJob(interactiveItemQueued[threadID], interactiveItemQueued_Idx[threadID]);
+    interactiveWorker[threadID]->setWorking(true);
+    interactiveWorker[threadID]->processLoadingJob(playback->playing(), loadRawData);
     DEBUG_CACHING_DETAIL("videoCache::interactiveLoaderFinished %d started - slot %d", interactiveItemQueued_Idx[threadID], threadID);
 
     // Clear the queue slot
@@ -421,7 +474,7 @@ void videoCache::interactiveLoaderFinished()
   }
   else
     // No scheduled job waiting
-    interactiveThread[threadID]->worker()->setWorking(false);
+    interactiveWorker[threadID]->setWorking(false);
 
   emit updateCacheStatus();
 }
@@ -431,9 +484,13 @@ void videoCache::scheduleCachingListUpdate()
   // The playlist changed. We have to rethink what to cache next.
   if (workersState == workersRunning)
   {
-    // First, the worker has to stop. Request a stop and an update of the queue.
-    workersState = workersIntReqRestart;
-    DEBUG_CACHING("videoCache::playlistChanged new state %d (workersIntReqRestart)", workersState);
+    // The jobs that are currently running are still valid. Update the queue now. The workers take their next job
+    // from the new queue. Workers that ran out of jobs get a new one right away.
+    updateCacheQueue();
+    for (loadingWorker *w : cachingWorkerList)
+      if (!w->isWorking())
+        pushNextJobToCachingWorker(w);
+    DEBUG_CACHING("videoCache::playlistChanged queue updated while running");
     return;
   }
   else if (workersState == workersIntReqRestart)
@@ -510,18 +567,26 @@ void videoCache::updateCacheQueue()
   // In combination with cacheLevelMax we also know how much space is free.
   // While we are iterating through the list, we will delete all cached frames from the cache that will 
   // never be cached (are outside of the items range of frames to show)
+  // The bits of the items are only synchronized if the cache of the item changed without the video cache noticing.
+  // Forget about items that are not in the playlist anymore.
+  for (auto it = itemCacheStates.begin(); it != itemCacheStates.end();)
+  {
+    if (allItems.contains(it.key()))
+      ++it;
+    else
+      it = itemCacheStates.erase(it);
+  }
   int64_t cacheLevel = 0;
   for (playlistItem *item : allItems)
   {
-    indexRange range = item->getFrameIdxRange();
-    QList<int> cached_frames = item->getCachedFrames();
-    for (int i : cached_frames)
-      if (i < range.first || i > range.second)
-        item->removeFrameFromCache(i);
-
     int64_t cachingFrameSize = item->getCachingFrameSize();
-    cacheLevel += item->getNumberCachedFrames() * cachingFrameSize;
+    cacheLevel += getNumberCachedFrames(item) * cachingFrameSize;
   }
+  // The frames that are currently being cached will also need space
+  for (const QList<plItemFrame> &frames : loadingFrames)
+    for (const plItemFrame &f : frames)
+      if (f.first)
+        cacheLevel += f.first->getCachingFrameSize();
   if (cacheLevel > cacheLevelMax)
   {
     // The cache is overflowing (maybe the user made the cache smaller).
@@ -532,11 +597,11 @@ void videoCache::updateCacheQueue()
     do
     {
       // Delete cached frames from this item until the cache is free enough
-      QList<int> cachedFrames = allItems[i]->getCachedFrames();
+      QList<int> cachedFrames = getCachedFrames(allItems[i]);
       unsigned int frameSize = allItems[i]->getCachingFrameSize();
       for (int f : cachedFrames)
       {
-        allItems[i]->removeFrameFromCache(f);
+        removeFrameFromCache(allItems[i], f);
         cacheLevel -= frameSize;
         if (cacheLevel < cacheLevelMax)
           break;
@@ -558,7 +623,7 @@ void videoCache::updateCacheQueue()
   indexRange range = selection[0]->getFrameIdxRange(); // These are the frames that we want to cache
   int64_t cachingFrameSize = selection[0]->getCachingFrameSize();
   int64_t itemSpaceNeeded = (range.second - range.first + 1) * cachingFrameSize;
-  int64_t alreadyCached = selection[0]->getNumberCachedFrames() * cachingFrameSize;
+  int64_t alreadyCached = getNumberCachedFrames(selection[0]) * cachingFrameSize;
   int64_t additionalItemSpaceNeeded = itemSpaceNeeded - alreadyCached;
 
   if (play)
@@ -585,7 +650,10 @@ void videoCache::updateCacheQueue()
           if (newCacheLevel + itemCacheSize <= cacheLevelMax)
           {
             // All frames of the item fit and there is even more space. We remain in "adding" mode.
-            enqueueCacheJob(allItems[i], itemRange);
+            if (allItems[i] == selection[0])
+              enqueuePrefetchJobs(allItems[i], itemRange);
+            else
+              enqueueCacheJob(allItems[i], itemRange);
             newCacheLevel += itemCacheSize;
           }
           else
@@ -594,12 +662,18 @@ void videoCache::updateCacheQueue()
             int64_t availableSpace = cacheLevelMax - newCacheLevel;
             int64_t nrFramesCachable = availableSpace / allItems[i]->getCachingFrameSize() + 1;
 
-            // These frames should be added...
+            // These frames should be added (for the selected item, the frames around the current frame) ...
             indexRange addFrames = indexRange(itemRange.first, itemRange.first + nrFramesCachable - 1);
-            enqueueCacheJob(allItems[i], addFrames);
+            if (allItems[i] == selection[0])
+            {
+              addFrames = getRangeAroundCurrentFrame(itemRange, nrFramesCachable);
+              enqueuePrefetchJobs(allItems[i], addFrames);
+            }
+            else
+              enqueueCacheJob(allItems[i], addFrames);
             newCacheLevel += nrFramesCachable * allItems[i]->getCachingFrameSize();
             // ... and the rest should be removed (if they are cached)
-            QList<int> cachedFrames = allItems[i]->getCachedFrames();
+            QList<int> cachedFrames = getCachedFrames(allItems[i]);
             for (int f : cachedFrames)
               if (f < addFrames.first || f > addFrames.second)
                 cacheDeQueue.enqueue(plItemFrame(allItems[i], f));
@@ -611,7 +685,7 @@ void videoCache::updateCacheQueue()
         else
         {
           // Enqueue all frames (that are cached) from the item as "can be deleted".
-          QList<int> cachedFrames = allItems[i]->getCachedFrames();
+          QList<int> cachedFrames = getCachedFrames(allItems[i]);
           for (int f : cachedFrames)
             cacheDeQueue.enqueue(plItemFrame(allItems[i], f));
         }
@@ -638,17 +712,17 @@ void videoCache::updateCacheQueue()
         if (item != selection[0])
         {
           // Mark all frames of this item as "can be removed if required"
-          QList<int> cachedFrames = item->getCachedFrames();
+          QList<int> cachedFrames = getCachedFrames(item);
           for (int f : cachedFrames)
             cacheDeQueue.enqueue(plItemFrame(item, f));
         }
       }
 
-      // Adjust the range so that only the number of frames are cached that will fit
+      // Adjust the range so that only the number of frames are cached that will fit (around the current frame)
       int64_t nrFramesCachable = cacheLevelMax / selection[0]->getCachingFrameSize();
-      range.second = range.first + nrFramesCachable - 1;
+      range = getRangeAroundCurrentFrame(range, nrFramesCachable);
 
-      enqueueCacheJob(selection[0], range);
+      enqueuePrefetchJobs(selection[0], range);
     }
     else if (selection[0]->isCachable() && additionalItemSpaceNeeded > (cacheLevelMax - cacheLevel) && additionalItemSpaceNeeded > 0)
     {
@@ -682,7 +756,7 @@ void videoCache::updateCacheQueue()
       }
 
       // Get the cache level without the current item (frames from the current item do not really occupy space in the cache. We want to cache them anyways)
-      int64_t cacheLevelWithoutCurrent = cacheLevel - selection[0]->getNumberCachedFrames() * int64_t(selection[0]->getCachingFrameSize());
+      int64_t cacheLevelWithoutCurrent = cacheLevel - getNumberCachedFrames(selection[0]) * int64_t(selection[0]->getCachingFrameSize());
       while ((itemSpaceNeeded + cacheLevelWithoutCurrent) > cacheLevelMax)
       {
         if (i == itemPos)
@@ -694,14 +768,14 @@ void videoCache::updateCacheQueue()
           // There is no previous item or the previous item is the first one in the list
           i = allItems.count() - 1;
         }
-        if (allItems[i]->getNumberCachedFrames() == 0)
+        if (getNumberCachedFrames(allItems[i]) == 0)
         {
           i--;
           continue;  // Nothing to delete for this item
         }
 
         // Which frames are cached for the item at position i?
-        QList<int> cachedFrames = allItems[i]->getCachedFrames();
+        QList<int> cachedFrames = getCachedFrames(allItems[i]);
         int64_t cachedFramesSize = cachedFrames.count() * int64_t(allItems[i]->getCachingFrameSize());
 
         if (additionalItemSpaceNeeded < cachedFramesSize)
@@ -723,7 +797,7 @@ void videoCache::updateCacheQueue()
         {
           // Deleting all frames from this item will not be enough.
           // Mark all frames of this item as "can be removed if required"
-          QList<int> cachedFrames = allItems[i]->getCachedFrames();
+          QList<int> cachedFrames = getCachedFrames(allItems[i]);
           for (int f : cachedFrames)
           {
             cacheDeQueue.enqueue(plItemFrame(allItems[i], f));
@@ -745,7 +819,7 @@ void videoCache::updateCacheQueue()
 
       // Enqueue the job. This is the only job.
       // We will not delete any frames from any other items to cache frames from other items.
-      enqueueCacheJob(selection[0], range);
+      enqueuePrefetchJobs(selection[0], range);
     }
     else
     {
@@ -755,7 +829,7 @@ void videoCache::updateCacheQueue()
         // All frames from the current item will fit and there is probably even space for more items.
         // In case of playback, we will continue with the next items and delete all frames that were already
         // played out. Otherwise, we don't delete any frames from the cache but we will cache as many items as possible.
-        enqueueCacheJob(selection[0], range);
+        enqueuePrefetchJobs(selection[0], range);
         cacheLevel = cacheLevel + additionalItemSpaceNeeded;
       }
 
@@ -786,7 +860,7 @@ void videoCache::updateCacheQueue()
         DEBUG_CACHING("videoCache::updateCacheQueue Attempt caching of next item %s.", allItems[i]->getName().toLatin1().data());
         // How much space is there in the cache (excluding what is cached from the current item)?
         // Get the cache level without the current item (frames from the current item do not really occupy space in the cache. We want to cache them anyways)
-        int64_t cacheLevelWithoutCurrent = cacheLevel - allItems[i]->getNumberCachedFrames() * int64_t(allItems[i]->getCachingFrameSize());
+        int64_t cacheLevelWithoutCurrent = cacheLevel - getNumberCachedFrames(allItems[i]) * int64_t(allItems[i]->getCachingFrameSize());
         // How much space do we need to cache the entire item?
         range = allItems[i]->getFrameIdxRange();
         int64_t itemCacheSize = (range.second - range.first + 1) * int64_t(allItems[i]->getCachingFrameSize());
@@ -818,6 +892,8 @@ void videoCache::updateCacheQueue()
     }
   }
 
+  sortCacheDeQueueByEvictionScore();
+
 #if CACHING_DEBUG_OUTPUT && !NDEBUG
   if (!cacheQueue.isEmpty())
   {
@@ -854,15 +930,288 @@ void videoCache::updateCacheQueue()
 #endif
 }
 
-void videoCache::enqueueCacheJob(playlistItem* item, indexRange range)
+void videoCache::sortCacheDeQueueByEvictionScore()
+{
+  const int nrFrames = cacheDeQueue.count();
+  if (nrFrames < 2)
+    return;
+
+  auto selection = playlist->getSelectedItems();
+  const int currentFrame = playback->getCurrentFrame();
+
+  QVector<int64_t> accessTimes(nrFrames);
+  int64_t oldestAccess = std::numeric_limits<int64_t>::max();
+  int64_t newestAccess = 0;
+  for (int i = 0; i < nrFrames; i++)
+  {
+    const plItemFrame &f = cacheDeQueue[i];
+    accessTimes[i] = f.first ? f.first->getFrameCacheAccessTime(f.second) : 0;
+    oldestAccess = std::min(oldestAccess, accessTimes[i]);
+    newestAccess = std::max(newestAccess, accessTimes[i]);
+  }
+
+  // Each term is in the range [0, 1]. A higher score means that the frame is removed earlier.
+  typedef QPair<double, plItemFrame> scoredFrame;
+  QVector<scoredFrame> scoredFrames;
+  scoredFrames.reserve(nrFrames);
+  for (int i = 0; i < nrFrames; i++)
+  {
+    const plItemFrame &f = cacheDeQueue[i];
+
+    // The order of the queue (items that are needed soon are at the end of the queue)
+    const double orderTerm = 1.0 - double(i) / nrFrames;
+    // Frames that were not used for a long time
+    const double ageTerm = (newestAccess > oldestAccess) ? double(newestAccess - accessTimes[i]) / (newestAccess - oldestAccess) : 0.0;
+    // Frames that are far away from the current frame (frames of other items are far away)
+    double distanceTerm = 1.0;
+    if (f.first && f.first == selection[0])
+    {
+      const indexRange range = f.first->getFrameIdxRange();
+      const int rangeLength = std::max(1, range.second - range.first);
+      distanceTerm = std::min(1.0, double(std::abs(f.second - currentFrame)) / rangeLength);
+    }
+    const double reloadCost = f.first ? std::max(1.0, f.first->getFrameReloadCost(f.second)) : 1.0;
+
+    scoredFrames.append(scoredFrame((orderTerm + ageTerm + distanceTerm) / reloadCost, f));
+  }
+
+  std::stable_sort(scoredFrames.begin(), scoredFrames.end(), [](const scoredFrame &a, const scoredFrame &b) { return a.first > b.first; });
+
+  cacheDeQueue.clear();
+  for (const scoredFrame &f : scoredFrames)
+    cacheDeQueue.enqueue(f.second);
+}
+
+void videoCache::enqueueCacheJob(playlistItem* item, indexRange range, bool reverse)
+{
+  // Only schedule frames for caching that were not yet cached (or are being cached right now).
+  while (range.first <= range.second && isFrameCachedOrLoading(item, range.first))
+    range.first++;
+  while (range.first <= range.second && isFrameCachedOrLoading(item, range.second))
+    range.second--;
+  if (range.first <= range.second)
+    cacheQueue.append(cacheJob(item, range, reverse));
+}
+
+videoCache::itemCacheState &videoCache::getItemCacheState(playlistItem *item)
+{
+  const indexRange range = item->getFrameIdxRange();
+  auto it = itemCacheStates.find(item);
+  if (it != itemCacheStates.end() && it->range == range && it->nrCachedFrames == item->getNumberCachedFrames())
+    return *it;
+
+  // Synchronize the bits with the frames in the cache of the item
+  DEBUG_CACHING_DETAIL("videoCache::getItemCacheState Synchronize %s", item->getName().toStdString().c_str());
+  itemCacheState state;
+  state.range = range;
+  state.cachedFrames.resize(std::max(0, range.second - range.first + 1));
+  for (int f : item->getCachedFrames())
+  {
+    if (f < range.first || f > range.second)
+      // This frame will never be shown. Remove it from the cache.
+      item->removeFrameFromCache(f);
+    else
+    {
+      state.cachedFrames.setBit(f - range.first);
+      state.nrCachedFrames++;
+    }
+  }
+  return *itemCacheStates.insert(item, state);
+}
+
+QList<int> videoCache::getCachedFrames(playlistItem *item)
+{
+  const itemCacheState &state = getItemCacheState(item);
+  QList<int> frames;
+  frames.reserve(state.nrCachedFrames);
+  for (int i = 0; i < state.cachedFrames.size() && frames.count() < state.nrCachedFrames; i++)
+    if (state.cachedFrames.testBit(i))
+      frames.append(state.range.first + i);
+  return frames;
+}
+
+int videoCache::getNumberCachedFrames(playlistItem *item)
+{
+  return getItemCacheState(item).nrCachedFrames;
+}
+
+bool videoCache::isFrameCachedOrLoading(playlistItem *item, int frameIdx)
+{
+  for (const QList<plItemFrame> &frames : loadingFrames)
+    for (const plItemFrame &f : frames)
+      if (f.first == item && f.second == frameIdx)
+        return true;
+
+  // This is called for many frames while the queue is built or a job is pushed. Only create missing bits here.
+  auto it = itemCacheStates.constFind(item);
+  const itemCacheState &state = (it != itemCacheStates.constEnd()) ? *it : getItemCacheState(item);
+  const int bit = frameIdx - state.range.first;
+  return bit >= 0 && bit < state.cachedFrames.size() && state.cachedFrames.testBit(bit);
+}
+
+void videoCache::setFrameCached(playlistItem *item, int frameIdx, bool cached)
+{
+  auto it = itemCacheStates.find(item);
+  if (it == itemCacheStates.end())
+    // There are no bits for this item yet. They will be created from the cache of the item when needed.
+    return;
+  const int bit = frameIdx - it->range.first;
+  if (bit < 0 || bit >= it->cachedFrames.size() || it->cachedFrames.testBit(bit) == cached)
+    return;
+  it->cachedFrames.setBit(bit, cached);
+  it->nrCachedFrames += cached ? 1 : -1;
+}
+
+void videoCache::removeFrameFromCache(playlistItem *item, int frameIdx)
+{
+  item->removeFrameFromCache(frameIdx);
+  setFrameCached(item, frameIdx, false);
+}
+
+void videoCache::removeAllFramesFromCache(playlistItem *item)
+{
+  item->removeAllFramesFromCache();
+  itemCacheStates.remove(item);
+}
+
+int videoCache::getPrefetchWindowAhead() const
+{
+  return std::max(PREFETCH_MIN_FRAMES, int(playheadSpeed * PREFETCH_SECONDS));
+}
+
+QList<videoCache::cacheJob> videoCache::getPrefetchJobs(playlistItem *item, QList<indexRange> ranges) const
+{
+  QList<cacheJob> jobs;
+  if (ranges.isEmpty())
+    return jobs;
+
+  // Merge overlapping and adjacent ranges
+  std::sort(ranges.begin(), ranges.end(), [](const indexRange &a, const indexRange &b) { return a.first < b.first; });
+  QList<indexRange> mergedRanges;
+  for (const indexRange &r : ranges)
+  {
+    if (!mergedRanges.isEmpty() && r.first <= mergedRanges.last().second + 1)
+      mergedRanges.last().second = std::max(mergedRanges.last().second, r.second);
+    else
+      mergedRanges.append(r);
+  }
+  const int firstFrame = mergedRanges.first().first;
+  const int lastFrame = mergedRanges.last().second;
+
+  // The segments around the current frame in the order in which they are cached. Together they cover all frames.
+  // Segments behind the playhead are cached in reverse so that the frames closest to the current frame come first.
+  const int current = playback->getCurrentFrame();
+  const int ahead = getPrefetchWindowAhead();
+  const int behind = std::max(1, ahead / 4);
+  typedef QPair<indexRange, bool> segment;
+  QList<segment> segments;
+  if (playheadDirection >= 0)
+  {
+    segments.append(segment(indexRange(current, current + ahead - 1), false));
+    segments.append(segment(indexRange(current - behind, current - 1), true));
+    segments.append(segment(indexRange(current + ahead, lastFrame), false));
+    segments.append(segment(indexRange(firstFrame, current - behind - 1), true));
+  }
+  else
+  {
+    segments.append(segment(indexRange(current - ahead + 1, current), true));
+    segments.append(segment(indexRange(current + 1, current + behind), false));
+    segments.append(segment(indexRange(firstFrame, current - ahead), true));
+    segments.append(segment(indexRange(current + behind + 1, lastFrame), false));
+  }
+
+  for (const segment &s : segments)
+  {
+    QList<cacheJob> segmentJobs;
+    for (const indexRange &r : mergedRanges)
+    {
+      indexRange intersection(std::max(r.first, s.first.first), std::min(r.second, s.first.second));
+      if (intersection.first <= intersection.second)
+      {
+        if (s.second)
+          segmentJobs.prepend(cacheJob(item, intersection, true));
+        else
+          segmentJobs.append(cacheJob(item, intersection, false));
+      }
+    }
+    jobs.append(segmentJobs);
+  }
+  return jobs;
+}
+
+void videoCache::enqueuePrefetchJobs(playlistItem *item, indexRange range)
+{
+  for (const cacheJob &job : getPrefetchJobs(item, QList<indexRange>() << range))
+    enqueueCacheJob(item, job.frameRange, job.reverse);
+}
+
+indexRange videoCache::getRangeAroundCurrentFrame(indexRange range, int64_t nrFrames) const
+{
+  if (nrFrames >= range.second - range.first + 1)
+    return range;
+  if (nrFrames <= 0)
+    return indexRange(range.first, range.first - 1);
+
+  // Most of the frames are ahead of the current frame (in the direction of the playhead)
+  const int nrFramesBehind = int(nrFrames / 5);
+  const int current = clip(playback->getCurrentFrame(), range.first, range.second);
+  int start = (playheadDirection >= 0) ? current - nrFramesBehind : current - int(nrFrames - 1 - nrFramesBehind);
+  start = clip(start, range.first, int(range.second - nrFrames + 1));
+  return indexRange(start, int(start + nrFrames - 1));
+}
+
+void videoCache::currentFrameChanged(int frameIdx)
+{
+  if (frameIdx < 0)
+    return;
+
+  // Update the direction and the speed of the playhead. Only steps that happen within a second count as movement.
+  const int64_t elapsedMs = playheadTimer.isValid() ? playheadTimer.restart() : -1;
+  if (!playheadTimer.isValid())
+    playheadTimer.start();
+  const int step = (lastPlayheadFrame >= 0) ? frameIdx - lastPlayheadFrame : 0;
+  lastPlayheadFrame = frameIdx;
+  if (step != 0)
+    playheadDirection = (step > 0) ? 1 : -1;
+  if (elapsedMs > 0 && elapsedMs < 1000)
+    playheadSpeed = 0.7 * playheadSpeed + 0.3 * (std::abs(step) * 1000.0 / elapsedMs);
+  else
+    playheadSpeed = 0.0;
+
+  reprioritizeCacheQueue();
+}
+
+void videoCache::reprioritizeCacheQueue()
 {
-  // Only schedule frames for caching that were not yet cached.
-  QList<int> cachedFrames = item->getCachedFrames();
-  int i = range.first;
-  while (cachedFrames.contains(i) && i < range.second)
-    range.first = ++i;
-  if (range.first != range.second)
-    cacheQueue.append(cacheJob(item, range));
+  if (!cachingEnabled || cacheQueue.isEmpty())
+    return;
+
+  auto selection = playlist->getSelectedItems();
+  playlistItem *item = selection[0];
+  if (item == nullptr || !item->isIndexedByFrame())
+    return;
+
+  // Take the jobs of the selected item out of the queue. The new jobs are inserted where the first job was.
+  int insertPos = -1;
+  QList<indexRange> ranges;
+  for (int i = 0; i < cacheQueue.count();)
+  {
+    if (cacheQueue[i].plItem == item)
+    {
+      if (insertPos == -1)
+        insertPos = i;
+      ranges.append(cacheQueue[i].frameRange);
+      cacheQueue.removeAt(i);
+    }
+    else
+      i++;
+  }
+  if (insertPos == -1)
+    return;
+
+  for (const cacheJob &job : getPrefetchJobs(item, ranges))
+    cacheQueue.insert(insertPos++, job);
+  DEBUG_CACHING_DETAIL("videoCache::reprioritizeCacheQueue frame %d direction %d speed %f", lastPlayheadFrame, playheadDirection, playheadSpeed);
 }
 
 void videoCache::startCaching()
@@ -877,8 +1226,8 @@ void videoCache::startCaching()
   {
     // Push a task to all the threads and start them.
     bool jobStarted = false;
-    for (int i = 0; i < cachingThreadList.count(); i++)
-      jobStarted |= pushNextJobToCachingThread(cachingThreadList[i]);
+    for (int i = 0; i < cachingWorkerList.count(); i++)
+      jobStarted |= pushNextJobToCachingWorker(cachingWorkerList[i]);
 
     workersState = jobStarted ? workersRunning : workersIdle;
   }
@@ -917,19 +1266,26 @@ void videoCache::watchItemForCachingFinished(playlistItem *item)
 // breaking the caching process.
 void videoCache::threadCachingFinished()
 {
-  // Get the thread that caused this call
+  // Get the worker that caused this call
   QObject *sender = QObject::sender();
   loadingWorker *worker = dynamic_cast<loadingWorker*>(sender);
   Q_ASSERT_X(worker->isWorking(), Q_FUNC_INFO, "The worker that just finished was not working?");
   worker->setWorking(false);
   DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished - state %d - worker %p", workersState, worker);
 
+  // The frames that the worker cached are now in the cache of the item
+  const QList<plItemFrame> framesLoaded = loadingFrames.take(worker);
+  const QList<int> framesDone = worker->getFramesDone();
+  for (const plItemFrame &frame : framesLoaded)
+    if (frame.first && !itemsToClearCache.contains(frame.first) && framesDone.contains(frame.second))
+      setFrameCached(frame.first, frame.second, true);
+
   // Check if all threads have stopped.
   bool jobsRunning = false;
-  for (loadingThread *t : cachingThreadList)
+  for (loadingWorker *w : cachingWorkerList)
   {
-    DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished WorkerList - worker %p - working %d", t, t->worker()->isWorking());
-    if (t->worker()->isWorking())
+    DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished WorkerList - worker %p - working %d", w, w->isWorking());
+    if (w->isWorking())
       // A job is still running. Wait.
       jobsRunning = true;
   }
@@ -966,9 +1322,7 @@ void videoCache::threadCachingFinished()
     {
       // The caching performance test is running. Just push another test job.
       DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished Test mode - start next job");
-      for (loadingThread *t : cachingThreadList)
-        if (t->worker() == worker)
-          jobsRunning |= pushNextJobToCachingThread(t);
+      jobsRunning |= pushNextJobToCachingWorker(worker);
     }
     return;
   }
@@ -979,14 +1333,14 @@ void videoCache::threadCachingFinished()
   {
     // Is the item still being cached?
     bool itemCaching = false;
-    for (loadingThread *t : cachingThreadList)
-      if (t->worker()->getCacheItem() == *it)
+    for (loadingWorker *w : cachingWorkerList)
+      if (w->getCacheItem() == *it)
       {
         itemCaching = true;
         break;
       }
     // Is the item still being loaded?
-    bool loadingItem = (interactiveThread[0]->worker()->getCacheItem() == *it || interactiveThread[1]->worker()->getCacheItem() == *it);
+    bool loadingItem = (interactiveWorker[0]->getCacheItem() == *it || interactiveWorker[1]->getCacheItem() == *it);
 
     if (!itemCaching && !loadingItem)
     {
@@ -1017,8 +1371,8 @@ void videoCache::threadCachingFinished()
   for (auto it = itemsToClearCache.begin(); it != itemsToClearCache.end();)
   {
     bool itemCaching = false;
-    for (loadingThread *t : cachingThreadList)
-    if (t->worker()->getCacheItem() == *it)
+    for (loadingWorker *w : cachingWorkerList)
+    if (w->getCacheItem() == *it)
     {
       itemCaching = true;
       break;
@@ -1027,7 +1381,7 @@ void videoCache::threadCachingFinished()
     if (!itemCaching)
     {
       // No job is caching the item anymore. Clear the cache now.
-      (*it)->removeAllFramesFromCache();
+      removeAllFramesFromCache(*it);
       it = itemsToClearCache.erase(it);
     }
     else
@@ -1055,27 +1409,21 @@ void videoCache::threadCachingFinished()
   }
 
   // Also check if the worker is in the cachingWorkerList. If not, do not push a new job to it.
-  if (deleteNrThreads > 0)
+  if (deleteNrWorkers > 0)
   {
-    // We need to delete some threads. So this one has to go.
-    int idx = -1;
-    for (int i=0; i<cachingThreadList.count(); i++)
-      if (cachingThreadList[i]->worker() == worker)
-        idx = i;
-    Q_ASSERT_X(idx >= 0, Q_FUNC_INFO, "The thread that just finished was not found in the thread list.");
-    loadingThread *t = cachingThreadList.takeAt(idx);
-    t->exit();
-    t->deleteLater();
-
-    DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished Deleting thread %p", t);
-    deleteNrThreads--;
+    // We need to delete some workers. So this one has to go.
+    const bool removed = cachingWorkerList.removeOne(worker);
+    Q_ASSERT_X(removed, Q_FUNC_INFO, "The worker that just finished was not found in the worker list.");
+    Q_UNUSED(removed);
+    worker->deleteLater();
+
+    DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished Deleting worker %p", worker);
+    deleteNrWorkers--;
   }
   else if (workersState == workersRunning)
   {
-    // Get the thread of the worker and push the next cache job to it
-    for (loadingThread *t : cachingThreadList)
-      if (t->worker() == worker)
-        jobsRunning |= pushNextJobToCachingThread(t);
+    // Push the next cache job to the worker
+    jobsRunning |= pushNextJobToCachingWorker(worker);
   }
 
   if (!jobsRunning)
@@ -1105,10 +1453,10 @@ void videoCache::threadCachingFinished()
   DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished - new state %d", workersState);
 }
 
-bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
+bool videoCache::pushNextJobToCachingWorker(loadingWorker *worker)
 {
-  if ((cacheQueue.isEmpty() && !testMode) || thread->isQuitting())
-    // No more jobs in the cache queue or the thread does not accept new jobs.
+  if (cacheQueue.isEmpty() && !testMode)
+    // No more jobs in the cache queue
     return false;
 
   if (testMode)
@@ -1118,10 +1466,10 @@ bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
     int frameNr = clip((1000-testLoopCount) % (r.second - r.first) + r.first, r.first, r.second);
     if (frameNr < 0)
       frameNr = 0;
-    thread->worker()->setJob(testItem, frameNr, true);
-    thread->worker()->setWorking(true);
-    thread->worker()->processCacheJob();
-    DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingThread - %d of %s", frameNr, testItem->getName().toStdString().c_str());
+    worker->setJob(testItem, frameNr, true);
+    worker->setWorking(true);
+    worker->processCacheJob();
+    DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingWorker - %d of %s", frameNr, testItem->getName().toStdString().c_str());
     testLoopCount--;
     return true;
   }
@@ -1139,15 +1487,15 @@ bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
       if (nrThreadsPlayback == 0)
       {
         // No caching while playback is running
-        DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingThread no new job started nrThreadsPlayback=0");
+        DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingWorker no new job started nrThreadsPlayback=0");
         return false;
       }
 
       // Check if there is a limit on the number of threads to use while playback is running.
       int threadsWorking = 0;
-      for (loadingThread *t : cachingThreadList)
+      for (loadingWorker *w : cachingWorkerList)
       {
-        if (t->worker()->isWorking())
+        if (w->isWorking())
           threadsWorking++;
       }
 
@@ -1155,7 +1503,7 @@ bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
       {
         // The maximum number (or more) of threads are already working.
         // Do not start another one.
-        DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingThread no new job started nrThreadsPlayback=%d threadsWorking=%d", nrThreadsPlayback, threadsWorking);
+        DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingWorker no new job started nrThreadsPlayback=%d threadsWorking=%d", nrThreadsPlayback, threadsWorking);
         return false;
       }
     }
@@ -1163,14 +1511,29 @@ bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
 
   QMutableListIterator<cacheJob> j(cacheQueue);
   playlistItem *plItem = nullptr;
-  indexRange range;
+  bool reverse = false;
+  QList<int> framesToCache;
   while (j.hasNext())
   {
     cacheJob &job = j.next();
     if (!job.plItem->isCachable())
+    {
       // Remove the item from the list
       j.remove();
-    else 
+      continue;
+    }
+
+    // The queue is not rebuilt when a job finishes. Skip frames that were cached (or started caching) since.
+    while (job.frameRange.first <= job.frameRange.second && isFrameCachedOrLoading(job.plItem, job.reverse ? job.frameRange.second : job.frameRange.first))
+    {
+      if (job.reverse)
+        job.frameRange.second--;
+      else
+        job.frameRange.first++;
+    }
+    if (job.frameRange.first > job.frameRange.second)
+      j.remove();
+    else
     {
       // We might be able to cache from this item. Check if there is a thread limit for the item.
       int threadLimit = job.plItem->cachingThreadLimit();
@@ -1178,24 +1541,32 @@ bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
       {
         // How many threads are currently caching the given item?
         int nrThreadsForItem = 0;
-        for (loadingThread *t : cachingThreadList)
-          if (t->worker()->isWorking() && t->worker()->getCacheItem() == job.plItem)
+        for (loadingWorker *w : cachingWorkerList)
+          if (w->isWorking() && w->getCacheItem() == job.plItem)
             nrThreadsForItem++;
         if (nrThreadsForItem >= threadLimit)
           // Go to the next item. We can not add another thread to this one.
           continue;
       }
 
-      // We can start another thread for this item
+      // We can start another worker for this item. Take the next frames of the job.
       plItem = job.plItem;
-      range = job.frameRange;
+      reverse = job.reverse;
+      while (framesToCache.count() < CACHING_BATCH_FRAMES && job.frameRange.first <= job.frameRange.second)
+      {
+        const int frame = job.reverse ? job.frameRange.second : job.frameRange.first;
+        // Update the frame range of the head item in the cache queue
+        if (job.reverse)
+          job.frameRange.second--;
+        else
+          job.frameRange.first++;
+        if (!isFrameCachedOrLoading(plItem, frame))
+          framesToCache.append(frame);
+      }
 
-      // Check if this is the last frame to cache in the item 
-      if (range.first == range.second)
+      // Check if these are the last frames to cache in the item
+      if (job.frameRange.first > job.frameRange.second)
         j.remove();
-      else
-        // Update the frame range of the head item in the cache queue
-        job.frameRange.first = range.first + 1;
 
       break;
     }
@@ -1204,40 +1575,53 @@ bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
     // No item found that we can start another caching thread for.
     return false;
 
-  // Get the size of one frame in bytes
-  unsigned int frameSize = plItem->getCachingFrameSize();
-
-  // We found an item that we can cache. Cache the first frame of it.
-  int frameToCache = range.first;
+  // Get the size of all frames in bytes
+  const int64_t frameSize = plItem->getCachingFrameSize() * int64_t(framesToCache.count());
 
-  // First check if we need to free up space to cache this frame.
+  // First check if we need to free up space to cache these frames.
   while (cacheLevelCurrent + frameSize >= cacheLevelMax && !cacheDeQueue.isEmpty())
   {
     plItemFrame frameToRemove = cacheDeQueue.dequeue();
+    if (!frameToRemove.first)
+      // The item was deleted
+      continue;
     unsigned int frameToRemoveSize = frameToRemove.first->getCachingFrameSize();
 
-    DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingThread Remove frame %d of %s", frameToRemove.second, frameToRemove.first->getName().toStdString().c_str());
-    frameToRemove.first->removeFrameFromCache(frameToRemove.second);
+    DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingWorker Remove frame %d of %s", frameToRemove.second, frameToRemove.first->getName().toStdString().c_str());
+    removeFrameFromCache(frameToRemove.first, frameToRemove.second);
     cacheLevelCurrent -= frameToRemoveSize;
   }
 
   if (cacheDeQueue.isEmpty() && cacheLevelCurrent + frameSize > cacheLevelMax)
   {
-    // There is still not enough space but there are no more frames that we can remove.
-    // The updateCacheQueue function should never create a situation where this is possible ...
-    // We are done here.
-    return false;
+    // There is not enough space for all frames but there are no more frames that we can remove.
+    // Only take the frames that fit and put the others back at the head of the queue.
+    const int64_t singleFrameSize = plItem->getCachingFrameSize();
+    const int nrFramesThatFit = (singleFrameSize > 0) ? int(std::max(int64_t(0), (cacheLevelMax - cacheLevelCurrent) / singleFrameSize)) : 0;
+    if (nrFramesThatFit < framesToCache.count())
+    {
+      const int first = framesToCache[nrFramesThatFit];
+      const int last = framesToCache.last();
+      cacheQueue.prepend(cacheJob(plItem, reverse ? indexRange(last, first) : indexRange(first, last), reverse));
+      framesToCache = framesToCache.mid(0, nrFramesThatFit);
+    }
+    if (framesToCache.isEmpty())
+      // The updateCacheQueue function should never create a situation where this is possible ...
+      // We are done here.
+      return false;
   }
 
-  // Push the job to the thread
-  Q_ASSERT_X(plItem != nullptr && frameToCache >= 0, Q_FUNC_INFO, "Invalid job.");
-  thread->worker()->setJob(plItem, frameToCache);
-  thread->worker()->setWorking(true);
-  thread->worker()->processCacheJob();
-  DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingThread - %d of %s", frameToCache, plItem->getName().toStdString().c_str());
+  // Push the job to the worker
+  Q_ASSERT_X(plItem != nullptr && !framesToCache.isEmpty() && framesToCache.first() >= 0, Q_FUNC_INFO, "Invalid job.");
+  worker->setJob(plItem, framesToCache);
+  worker->setWorking(true);
+  for (int frame : framesToCache)
+    loadingFrames[worker].append(plItemFrame(plItem, frame));
+  worker->processCacheJob();
+  DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingWorker - %d frames from %d of %s", framesToCache.count(), framesToCache.first(), plItem->getName().toStdString().c_str());
 
   // Update the cache level
-  cacheLevelCurrent += frameSize;
+  cacheLevelCurrent += plItem->getCachingFrameSize() * int64_t(framesToCache.count());
 
   return true;
 }
@@ -1248,19 +1632,28 @@ void videoCache::itemAboutToBeDeleted(playlistItem* item)
   // and then we can re-think our caching strategy.
 
   // Are we currently loading a frame from this item in one of the interactive loading threads?
-  bool loadingItem = (interactiveThread[0]->worker()->getCacheItem() == item || interactiveThread[1]->worker()->getCacheItem() == item);
+  bool loadingItem = (interactiveWorker[0]->getCacheItem() == item || interactiveWorker[1]->getCacheItem() == item);
   bool cachingItem = false;
 
   if (workersState != workersIdle)
   {
     // Are we currently caching a frame from this item?
-    for (loadingThread *t : cachingThreadList)
-      if (t->worker()->getCacheItem() == item)
+    for (loadingWorker *w : cachingWorkerList)
+      if (w->getCacheItem() == item)
         cachingItem = true;
 
-    // An item is about to be deleted. We need to rethink what to cache next.
-    workersState = workersIntReqRestart;
+    if (cachingItem)
+      // The running job became invalid. Wait for it before we rethink what to cache next.
+      workersState = workersIntReqRestart;
+    else if (workersState == workersRunning)
+    {
+      // The item is not in the playlist anymore. Remove its frames from the queues. The other workers continue.
+      itemCacheStates.remove(item);
+      updateCacheQueue();
+    }
   }
+  else
+    itemCacheStates.remove(item);
 
   if (cachingItem || loadingItem)
   {
@@ -1304,25 +1697,30 @@ void videoCache::itemNeedsRecache(playlistItem* item, recacheIndicator clearItem
     {
       // Are we currently caching a frame from this item?
       bool cachingItem = false;
-      for (loadingThread *t : cachingThreadList)
-      if (t->worker()->getCacheItem() == item)
+      for (loadingWorker *w : cachingWorkerList)
+      if (w->getCacheItem() == item)
         cachingItem = true;
 
       if (cachingItem)
       {
         // The cache of the item needs to be cleared when all threads working on this item finished.
+        // The running job of the item became invalid. Restart when all workers finished.
         if (!itemsToClearCache.contains(item))
           itemsToClearCache.append(item);
+        workersState = workersIntReqRestart;
       }
       else
-        // We can clear the cache now
-        item->removeAllFramesFromCache();
-      workersState = workersIntReqRestart;
+      {
+        // We can clear the cache now. The jobs that are running are not affected.
+        removeAllFramesFromCache(item);
+        if (workersState == workersRunning)
+          scheduleCachingListUpdate();
+      }
     }
     else
     {
       // The worker thread is idle. We can just clear the item cache now.
-      item->removeAllFramesFromCache();
+      removeAllFramesFromCache(item);
       // This also implies that we want to rethink what to cache
       scheduleCachingListUpdate();
     }
@@ -1370,11 +1768,31 @@ QStringList videoCache::getCacheStatusText()
 {
   QStringList txt;
   txt.append("Interactive:");
-  txt.append(interactiveThread[0]->worker()->getStatus());
-  txt.append(interactiveThread[1]->worker()->getStatus());
+  txt.append(interactiveWorker[0]->getStatus());
+  txt.append(interactiveWorker[1]->getStatus());
   txt.append("Caching:");
-  for (loadingThread *t : cachingThreadList)
-    txt.append(t->worker()->getStatus());
+  for (loadingWorker *w : cachingWorkerList)
+    txt.append(w->getStatus());
+
+  txt.append("Budget:");
+  txt.append(QString("%1 MB - %2").arg(cacheLevelMax / 1000000).arg(cacheBudgetReason));
+
+  const auto poolStats = frameBufferPool::instance().getStatistics();
+  const int64_t poolRequests = poolStats.hits + poolStats.misses;
+  txt.append("Buffer pool:");
+  txt.append(QString("%1 hits, %2 misses (%3% reused)").arg(poolStats.hits).arg(poolStats.misses).arg(poolRequests > 0 ? 100 * poolStats.hits / poolRequests : 0));
+  txt.append(QString("%1 buffers, %2/%3 MB").arg(poolStats.nrBuffers).arg(poolStats.nrBytes / 1000000).arg(poolStats.maxBytes / 1000000));
+
+  // The hit/miss statistics of the cache tiers
+  const auto stats = compressedFrameCache::instance().getStatistics();
+  txt.append("Tiers:");
+  txt.append(QString("Cache: %1 hits, %2 misses").arg(stats.hotHits).arg(stats.hotMisses));
+  if (stats.maxBytes > 0)
+  {
+    const double ratio = (stats.compressedBytes > 0) ? double(stats.uncompressedBytes) / stats.compressedBytes : 0.0;
+    txt.append(QString("Compressed: %1 frames, %2/%3 MB (ratio %4)").arg(stats.nrFrames).arg(stats.compressedBytes / 1000000).arg(stats.maxBytes / 1000000).arg(ratio, 0, 'f', 2));
+    txt.append(QString("Compressed: %1 hits, %2 misses").arg(stats.compressedHits).arg(stats.compressedMisses));
+  }
   return txt;
 }
 
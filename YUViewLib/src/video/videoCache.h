@@ -32,8 +32,11 @@
 
 #pragma once
 
+#include <QBitArray>
 #include <QDockWidget>
 #include <QElapsedTimer>
+#include <QHash>
+#include <QList>
 #include <QLabel>
 #include <QPointer>
 #include <QProgressDialog>
@@ -70,6 +73,11 @@ public:
 
   QStringList getCacheStatusText();
 
+  // The current memory budget of the cache and the reason for it (the threshold from the settings or, if the cache
+  // size adapts to the free memory, the lack of free memory)
+  int64_t getCacheLevelMax() const { return cacheLevelMax; }
+  QString getCacheBudgetReason() const { return cacheBudgetReason; }
+
 signals:
   // This will be emitted on a regular basis to update the videoCacheInfoWidget
   void updateCacheStatus();
@@ -78,7 +86,7 @@ private slots:
 
   // This signal is sent from the playlistTreeWidget if something changed (another item was selected ...)
   // The video Cache will then re-evaluate what to cache next and start the cache worker. If caching is
-  // currently running, the update will be performed when the currently running caching jobs are done.
+  // currently running, the queue is updated right away and the workers continue with the new queue.
   void scheduleCachingListUpdate();
 
   // The cacheThread finished. If we requested the interruption, update the cache queue and restart.
@@ -102,18 +110,28 @@ private slots:
   // Analyze the current situation and decide which items are to be cached next (in which order) and
   // which frames can be removed from the cache.
   void updateCacheQueue();
+
+  // The current frame of the playback controller changed. Update the speed and direction of the playhead and
+  // reorder the queued jobs of the selected item around the new frame (see reprioritizeCacheQueue).
+  void currentFrameChanged(int frameIdx);
  
 private:
   // A cache job. Has a pointer to a playlist item and a range of frames to be cached.
+  // If reverse is set, the frames are cached from the end of the range to the start.
   struct cacheJob
   {
     cacheJob() {}
-    cacheJob(playlistItem *item, indexRange range) { plItem = item; frameRange = range; }
+    cacheJob(playlistItem *item, indexRange range, bool reverse=false) { plItem = item; frameRange = range; this->reverse = reverse; }
     QPointer<playlistItem> plItem;
     indexRange frameRange;
+    bool reverse {false};
   };
   typedef QPair<QPointer<playlistItem>, int> plItemFrame;
 
+  // A simple QObject that gets a pointer to a playlist item and loads/caches frames of that item. The work is done
+  // by tasks in the shared taskPool.
+  class loadingWorker;
+
   // When the cache queue is updated, this function will start the background caching.
   void startCaching();
 
@@ -128,17 +146,78 @@ private:
   QQueue<cacheJob> cacheQueue;
   // The queue with a list of frames/items that can be removed from the queue if necessary
   QQueue<plItemFrame> cacheDeQueue;
+  // Sort the cacheDeQueue so that the frames which are the cheapest to lose are removed first. This considers the
+  // position in the queue (the priority of the item), the distance to the current frame, the time of the last access
+  // and the cost to reload the frame (e.g. decoding a GOP vs. reading a raw frame).
+  void sortCacheDeQueueByEvictionScore();
   // If a frame is removed can be determined by the following cache states:
   int64_t cacheLevelMax;
-  int64_t cacheLevelCurrent;
+  int64_t cacheLevelCurrent {0};
+
+  // --- Memory budget
+  // The threshold from the settings is the maximum size of the cache. If the cache size adapts to the free memory
+  // (Linux only), the free memory of the system and of the cgroup is checked periodically. If memory runs low,
+  // cacheLevelMax is reduced and frames are removed from the cache right away. When memory is available again, the
+  // budget grows back up to the threshold.
+  int64_t cacheLevelThreshold {0};
+  bool adaptiveCacheSize {false};
+  QString cacheBudgetReason;
+  QTimer memoryBudgetTimer;
+  // Update cacheLevelMax. Return true if it changed so much that the cache queue should be updated.
+  bool updateCacheBudget();
 
   // Enqueue the job in the queue. If all frames within the range are already cached in the item, do nothing.
-  void enqueueCacheJob(playlistItem* item, indexRange range);
-
-  // Start the given number of worker threads (if caching is running, also new jobs will be pushed to the workers)
-  void startWorkerThreads(int nrThreads);
-  // If this number is > 0, the indicated number of threads will be deleted when a worker finishes (threadCachingFinished() is called)
-  int deleteNrThreads {0};
+  void enqueueCacheJob(playlistItem* item, indexRange range, bool reverse=false);
+
+  // --- Cached frames of the items
+  // The planner keeps one bit per frame for each item instead of querying the list of cached frames of every item
+  // on each update of the queue. The bits are set when a worker finished caching a frame and cleared when the cache
+  // removes a frame. If the number of frames in the cache of the item does not match the bits (the item cleared its
+  // cache by itself or the frame range changed), the bits are synchronized with the item again.
+  struct itemCacheState
+  {
+    indexRange range;
+    QBitArray cachedFrames;
+    int nrCachedFrames {0};
+  };
+  QHash<playlistItem*, itemCacheState> itemCacheStates;
+  // Get the state of the item. Cached frames outside of the frame range of the item are removed when synchronizing.
+  itemCacheState &getItemCacheState(playlistItem *item);
+  QList<int> getCachedFrames(playlistItem *item);
+  int getNumberCachedFrames(playlistItem *item);
+  // Is the frame cached or currently being cached by one of the workers?
+  bool isFrameCachedOrLoading(playlistItem *item, int frameIdx);
+  void setFrameCached(playlistItem *item, int frameIdx, bool cached);
+  void removeFrameFromCache(playlistItem *item, int frameIdx);
+  void removeAllFramesFromCache(playlistItem *item);
+  // The frames that the caching workers are currently working on
+  QHash<loadingWorker*, QList<plItemFrame>> loadingFrames;
+
+  // --- Prefetch window
+  // The frames of the selected item are not cached from the first to the last frame. They are cached in a window
+  // around the current frame: First the frames ahead of the current frame (in the direction of the playhead), then a
+  // smaller window behind it, then the remaining frames ahead and behind (closest frames first).
+  // The size of the window ahead depends on the speed of the playhead.
+  int getPrefetchWindowAhead() const;
+  // Split the given ranges of frames of the item into jobs in the order of the prefetch window around the current frame
+  QList<cacheJob> getPrefetchJobs(playlistItem *item, QList<indexRange> ranges) const;
+  // Enqueue jobs for the given range of the selected item in the order of the prefetch window
+  void enqueuePrefetchJobs(playlistItem *item, indexRange range);
+  // Get nrFrames frames of the range around the current frame (more ahead of it than behind it)
+  indexRange getRangeAroundCurrentFrame(indexRange range, int64_t nrFrames) const;
+  // Reorder the jobs of the selected item in the queue for the current frame. Jobs of other items are not changed
+  // and the queue is not rebuilt.
+  void reprioritizeCacheQueue();
+  // The direction (1 or -1) and the speed (frames per second, smoothed) of the playhead
+  int playheadDirection {1};
+  double playheadSpeed {0.0};
+  int lastPlayheadFrame {-1};
+  QElapsedTimer playheadTimer;
+
+  // Start the given number of caching workers (if caching is running, also new jobs will be pushed to the workers)
+  void startCachingWorkers(int nrWorkers);
+  // If this number is > 0, the indicated number of workers will be deleted when a worker finishes (threadCachingFinished() is called)
+  int deleteNrWorkers {0};
   // How many threads are to be used when playback is running?
   int nrThreadsPlayback;
 
@@ -161,20 +240,18 @@ private:
   // The cache of these items will be cleared when caching has halted.
   QList<playlistItem*> itemsToClearCache;
 
-  // A simple QObject (to move to threads) that gets a pointer to a playlist item and loads a frame in that item.
-  class loadingThread;
 
-  // A list of caching threads that process caching of frames in parallel in the background
-  QList<loadingThread*> cachingThreadList;
+  // A list of caching workers that process caching of frames in parallel in the background
+  QList<loadingWorker*> cachingWorkerList;
 
-  // Two threads with a higher priority that performs interactive loading (if the user is the source of the request)
-  loadingThread *interactiveThread[2];
+  // Two workers in the interactive lane of the task pool that perform interactive loading (if the user is the source of the request)
+  loadingWorker *interactiveWorker[2];
   playlistItem  *interactiveItemQueued[2];
   int            interactiveItemQueued_Idx[2];
 
-  // Get the next item and frame to cache from the queue and push it to the given worker.
+  // Get the next item and frames to cache from the queue and push them to the given worker.
   // Return false if there are no more jobs to be pushed.
-  bool pushNextJobToCachingThread(loadingThread *thread);
+  bool pushNextJobToCachingWorker(loadingWorker *worker);
   
   bool updateCacheQueueAndRestartWorker;
 
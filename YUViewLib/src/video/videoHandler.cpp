@@ -32,9 +32,20 @@
 
 #include "videoHandler.h"
 
+#include <algorithm>
+#include <memory>
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QPainter>
+#include <QSettings>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
 
+#include "common/frameBufferPool.h"
 #include "common/functions.h"
+#include "common/taskPool.h"
+#include "video/compressedFrameCache.h"
 
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
 #define VIDEOHANDLER_DEBUG_LOADING 0
@@ -44,6 +55,84 @@
 #define DEBUG_VIDEO(fmt,...) ((void)0)
 #endif
 
+namespace
+{
+
+// The number of threads for the slice parallel conversion (0 means that the number of threads is chosen automatically)
+int getNrConversionThreadsFromSettings()
+{
+  QSettings settings;
+  settings.beginGroup("Conversion");
+  int nrThreads = 0;
+  if (settings.value("SetNrThreads", false).toBool())
+    nrThreads = settings.value("NrThreads", QThread::idealThreadCount()).toInt();
+  settings.endGroup();
+  return (nrThreads > 0) ? nrThreads : QThread::idealThreadCount();
+}
+
+bool getHighBitDepthOutputFromSettings()
+{
+  QSettings settings;
+  settings.beginGroup("Conversion");
+  const bool enabled = settings.value("HighBitDepthOutput", false).toBool();
+  settings.endGroup();
+  return enabled;
+}
+
+// Reading the settings for every converted frame is too slow. The value is read once and updated in updateConversionSettings.
+QAtomicInt highBitDepthOutput {-1};
+
+// Set by the video cache (see videoHandler::setRawDataCachingEnabled)
+QAtomicInt rawDataCaching {0};
+
+// The number of bands that a frame is split into. Read once and updated in updateConversionSettings.
+QAtomicInt nrConversionThreads {0};
+
+int getNrConversionThreads()
+{
+  int nrThreads = nrConversionThreads.loadAcquire();
+  if (nrThreads <= 0)
+  {
+    nrThreads = getNrConversionThreadsFromSettings();
+    nrConversionThreads.storeRelease(nrThreads);
+  }
+  return nrThreads;
+}
+
+// All bands of one frame. The job is shared between the calling thread and the tasks in the task pool.
+// A task that is started after all bands were processed by other threads just returns.
+struct bandConversionJob
+{
+  std::function<void(int, int)> convertBand;
+  QVector<QPair<int, int>> bands;
+  QAtomicInt nextBand {0};
+  int bandsDone {0};
+  QMutex mutex;
+  QWaitCondition allBandsDone;
+
+  void processBands()
+  {
+    int idx;
+    while ((idx = nextBand.fetchAndAddOrdered(1)) < bands.size())
+    {
+      convertBand(bands[idx].first, bands[idx].second);
+
+      QMutexLocker locker(&mutex);
+      if (++bandsDone == bands.size())
+        allBandsDone.wakeAll();
+    }
+  }
+};
+
+// A monotonic time in ms which is used for the last access time of cached frames
+int64_t getCacheAccessTimestamp()
+{
+  static const QElapsedTimer timer = []() { QElapsedTimer t; t.start(); return t; }();
+  return timer.elapsed();
+}
+
+} // namespace
+
 videoHandler::videoHandler()
 {
   // Initialize variables
@@ -55,6 +144,11 @@ videoHandler::videoHandler()
   rawData_frameIdx = -1;
 }
 
+videoHandler::~videoHandler()
+{
+  compressedFrameCache::instance().removeAll(this);
+}
+
 void videoHandler::slotVideoControlChanged()
 {
   // Update the controls and get the new selected size
@@ -84,6 +178,7 @@ void videoHandler::setFrameSize(const QSize &size)
   {
     currentFrameRawData_frameIdx = -1;
     currentImageIdx = -1;
+    clearTileCache();
   }
 
   frameHandler::setFrameSize(size);
@@ -103,15 +198,16 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
   // Lock the mutex for checking the cache
   QMutexLocker lock(&imageCacheAccess);
 
-  // The raw values are not needed. 
-  if (frameIdx == currentImageIdx)
+  // The raw values are not needed. If only a part of the frame is visible and the raw data is loaded,
+  // the visible tiles are converted when drawing. This is also not counted as loading.
+  if (frameIdx == currentImageIdx || (useRegionConversion() && canConvertFrameRegion(frameIdx)))
   {
     if (doubleBufferImageFrameIdx == frameIdx + 1)
     {
       DEBUG_VIDEO("videoHandler::needsLoading %d is current and %d found in double buffer", frameIdx, frameIdx+1);
       return LoadingNotNeeded;
     }
-    else if (cacheValid && imageCache.contains(frameIdx + 1))
+    else if (cacheValid && frameInCache(frameIdx + 1))
     {
       DEBUG_VIDEO("videoHandler::needsLoading %d is current and %d found in cache", frameIdx, frameIdx+1);
       return LoadingNotNeeded;
@@ -128,7 +224,7 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
   if (doubleBufferImageFrameIdx == frameIdx)
   {
     // The frame in question is in the double buffer...
-    if (cacheValid && imageCache.contains(frameIdx + 1))
+    if (cacheValid && frameInCache(frameIdx + 1))
     {
       // ... and the one after that is in the cache.
       DEBUG_VIDEO("videoHandler::needsLoading %d found in double buffer. Next frame in cache.", frameIdx);
@@ -145,7 +241,7 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
   }
 
   // Check the cache
-  if (cacheValid && imageCache.contains(frameIdx))
+  if (cacheValid && frameInCache(frameIdx))
   {
     // What about the next frame? Is it also in the cache or in the double buffer?
     if (doubleBufferImageFrameIdx == frameIdx + 1)
@@ -153,7 +249,7 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
       DEBUG_VIDEO("videoHandler::needsLoading %d in cache and %d found in double buffer", frameIdx, frameIdx+1);
       return LoadingNotNeeded;
     }
-    else if (cacheValid && imageCache.contains(frameIdx + 1))
+    else if (cacheValid && frameInCache(frameIdx + 1))
     {
       DEBUG_VIDEO("videoHandler::needsLoading %d in cache and %d found in cache", frameIdx, frameIdx+1);
       return LoadingNotNeeded;
@@ -173,6 +269,22 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
 
 void videoHandler::drawFrame(QPainter *painter, int frameIdx, double zoomFactor, bool drawRawValues)
 {
+  // If the decimation factor for the zoom factor changed, the current image and the double buffer are converted again.
+  // The cached images are always in full resolution so the cache is not affected.
+  if (supportsDecimatedConversion())
+  {
+    const int decimation = getDecimationForZoom(zoomFactor);
+    if (decimation != conversionDecimation)
+    {
+      DEBUG_VIDEO("videoHandler::drawFrame decimation changed from %d to %d", int(conversionDecimation), decimation);
+      conversionDecimation = decimation;
+      if (getImageDecimation(currentImage) != decimation)
+        currentImageIdx = -1;
+      if (getImageDecimation(doubleBufferImage) != decimation)
+        doubleBufferImageFrameIdx = -1;
+    }
+  }
+
   // Check if the frameIdx changed and if we have to load a new frame
   if (frameIdx != currentImageIdx)
   {
@@ -188,12 +300,33 @@ void videoHandler::drawFrame(QPainter *painter, int frameIdx, double zoomFactor,
     else
     {
       QMutexLocker lock(&imageCacheAccess);
+      const bool cacheHit = cacheValid && frameInCache(frameIdx);
+      compressedFrameCache::instance().countHotTierAccess(cacheHit);
+      if (cacheHit)
+        cacheIndex.setAccessTime(frameIdx, getCacheAccessTimestamp());
       if (cacheValid && imageCache.contains(frameIdx))
       {
         currentImage = imageCache[frameIdx];
         currentImageIdx = frameIdx;
         DEBUG_VIDEO("videoHandler::drawFrame %d loaded from cache", frameIdx);
       }
+      else if (cacheValid && rawDataCache.contains(frameIdx))
+      {
+        // Set the cached raw data as the current raw data. It is converted below (the whole frame or only the visible tiles).
+        // Don't wait if raw data is currently being loaded. The item will be redrawn when loading is done.
+        const QByteArray cachedRawData = rawDataCache[frameIdx];
+        lock.unlock();
+        if (requestDataMutex.tryLock())
+        {
+          currentFrameRawData = cachedRawData;
+          currentFrameRawData_frameIdx = frameIdx;
+          requestDataMutex.unlock();
+          DEBUG_VIDEO("videoHandler::drawFrame %d raw data loaded from cache", frameIdx);
+          // The tiles can only be converted from planar data. Otherwise convert the whole frame now.
+          if (!canConvertFrameRegion(frameIdx))
+            convertCurrentImageFromRawData(frameIdx, conversionDecimation);
+        }
+      }
     }
   }
 
@@ -202,10 +335,36 @@ void videoHandler::drawFrame(QPainter *painter, int frameIdx, double zoomFactor,
   videoRect.setSize(frameSize * zoomFactor);
   videoRect.moveCenter(QPoint(0,0));
 
-  // Draw the current image (currentImage)
-  currentImageSetMutex.lock();
-  painter->drawImage(videoRect, currentImage);
-  currentImageSetMutex.unlock();
+  // Get the part of the frame which is visible (in pixels of the frame)
+  const QRectF paintRect = painter->hasClipping() ? painter->clipBoundingRect() : painter->worldTransform().inverted().mapRect(QRectF(painter->window()));
+  const QRectF visibleRectF = QRectF((paintRect.topLeft() - videoRect.topLeft()) / zoomFactor, paintRect.size() / zoomFactor);
+  tileCacheAccess.lock();
+  visibleRegion = visibleRectF.toAlignedRect() & QRect(QPoint(0, 0), frameSize);
+  tileCacheAccess.unlock();
+
+  // If the frame is not the current image (and not cached), the frame may be converted from the raw data.
+  // If only a small part is visible, only the visible tiles are converted.
+  bool drawTiles = false;
+  if (frameIdx != currentImageIdx && canConvertFrameRegion(frameIdx))
+  {
+    if (useRegionConversion())
+      drawTiles = true;
+    else
+      convertCurrentImageFromRawData(frameIdx, conversionDecimation);
+  }
+
+  // Draw the current image (currentImage) or the visible tiles of the frame. The current image may have a lower
+  // resolution than the frame. If the tiles are drawn, the current image belongs to another frame and is not drawn
+  // underneath. Only the visible part of the frame is painted then.
+  tileFrameIdx = drawTiles ? frameIdx : -1;
+  if (drawTiles)
+    drawVisibleTiles(painter, frameIdx, videoRect, zoomFactor);
+  else
+  {
+    currentImageSetMutex.lock();
+    painter->drawImage(videoRect, currentImage, getImageSourceRect(currentImage));
+    currentImageSetMutex.unlock();
+  }
 
   if (drawRawValues && zoomFactor >= SPLITVIEW_DRAW_VALUES_ZOOMFACTOR)
   {
@@ -223,28 +382,152 @@ QImage videoHandler::calculateDifference(frameHandler *item2, const int frameIdx
     // The item2 is not a videoItem but this one is.
     if (currentImageIdx != frameIdxItem0)
       loadFrame(frameIdxItem0);
+    if (currentImageIdx != frameIdxItem0 || currentImage.size() != frameSize)
+      convertCurrentImageFromRawData(frameIdxItem0);
     // Call the frameHandler implementation to calculate the difference
     return frameHandler::calculateDifference(item2, frameIdxItem0, frameIdxItem1, differenceInfoList, amplificationFactor, markDifference);
   }
 
-  // Load the right images, if not already loaded)
+  // Load the right images, if not already loaded). If only the visible tiles were converted or the image has a lower
+  // resolution, convert the whole frame in full resolution.
   if (currentImageIdx != frameIdxItem0)
     loadFrame(frameIdxItem0);
+  if (currentImageIdx != frameIdxItem0 || currentImage.size() != frameSize)
+    convertCurrentImageFromRawData(frameIdxItem0);
   if (videoItem2->currentImageIdx != frameIdxItem1)
     videoItem2->loadFrame(frameIdxItem1);
+  if (videoItem2->currentImageIdx != frameIdxItem1 || videoItem2->currentImage.size() != videoItem2->frameSize)
+    videoItem2->convertCurrentImageFromRawData(frameIdxItem1);
 
   return frameHandler::calculateDifference(item2, frameIdxItem0, frameIdxItem1, differenceInfoList, amplificationFactor, markDifference);
 }
 
 QRgb videoHandler::getPixelVal(int x, int y)
 {
-  return currentImage.pixel(x, y);
+  if (tileFrameIdx != -1)
+  {
+    // The frame was drawn using tiles. Get the value from the tile.
+    const int nrTilesX = (frameSize.width() + tileSize - 1) / tileSize;
+    const auto key = qMakePair(tileFrameIdx, (y / tileSize) * nrTilesX + x / tileSize);
+    QMutexLocker lock(&tileCacheAccess);
+    if (tileCache.contains(key))
+      return tileCache[key].pixel(x % tileSize, y % tileSize);
+    return 0;
+  }
+
+  const int decimation = getImageDecimation(currentImage);
+  return currentImage.pixel(x / decimation, y / decimation);
+}
+
+bool videoHandler::useRegionConversion() const
+{
+  // Only convert the visible tiles if less than a quarter of the frame is visible
+  QMutexLocker lock(&tileCacheAccess);
+  const int64_t frameArea = int64_t(frameSize.width()) * frameSize.height();
+  const int64_t visibleArea = int64_t(visibleRegion.width()) * visibleRegion.height();
+  return conversionDecimation == 1 && !visibleRegion.isEmpty() && visibleArea * 4 <= frameArea;
+}
+
+void videoHandler::drawVisibleTiles(QPainter *painter, int frameIdx, const QRect &videoRect, double zoomFactor)
+{
+  tileCacheAccess.lock();
+  const QRect region = visibleRegion;
+  tileCacheAccess.unlock();
+  if (region.isEmpty())
+    return;
+
+  const int nrTilesX = (frameSize.width() + tileSize - 1) / tileSize;
+  for (int tileY = region.top() / tileSize; tileY <= region.bottom() / tileSize; tileY++)
+  {
+    for (int tileX = region.left() / tileSize; tileX <= region.right() / tileSize; tileX++)
+    {
+      const QRect tileRect = QRect(tileX * tileSize, tileY * tileSize, tileSize, tileSize) & QRect(QPoint(0, 0), frameSize);
+      const auto key = qMakePair(frameIdx, tileY * nrTilesX + tileX);
+
+      QMutexLocker lock(&tileCacheAccess);
+      QImage tile = tileCache.value(key);
+      lock.unlock();
+      if (tile.isNull())
+      {
+        tile = convertFrameRegion(frameIdx, tileRect);
+        if (tile.isNull())
+          continue;
+        DEBUG_VIDEO("videoHandler::drawVisibleTiles converted tile %d of frame %d", key.second, frameIdx);
+
+        lock.relock();
+        // Only keep a limited number of tiles. The tiles of other frames are removed first.
+        const int maxNrTiles = 256;
+        if (tileCache.size() >= maxNrTiles)
+        {
+          auto it = tileCache.begin();
+          while (it != tileCache.end())
+          {
+            if (it.key().first != frameIdx)
+              it = tileCache.erase(it);
+            else
+              ++it;
+          }
+          if (tileCache.size() >= maxNrTiles)
+            tileCache.clear();
+        }
+        tileCache.insert(key, tile);
+        lock.unlock();
+      }
+
+      const QRectF targetRect(QPointF(videoRect.topLeft()) + QPointF(tileRect.topLeft()) * zoomFactor, QSizeF(tileRect.size()) * zoomFactor);
+      painter->drawImage(targetRect, tile);
+    }
+  }
+}
+
+bool videoHandler::convertCurrentImageFromRawData(int frameIdx, int decimation)
+{
+  QImage newImage = convertFrameRegion(frameIdx, QRect(QPoint(0, 0), frameSize), decimation);
+  if (newImage.isNull())
+    return false;
+
+  DEBUG_VIDEO("videoHandler::convertCurrentImageFromRawData %d", frameIdx);
+  QMutexLocker imageLock(&currentImageSetMutex);
+  currentImage = newImage;
+  currentImageIdx = frameIdx;
+  return true;
+}
+
+int videoHandler::getDecimationForZoom(double zoomFactor)
+{
+  const int maxDecimation = 16;
+  int decimation = 1;
+  while (decimation < maxDecimation && zoomFactor * decimation * 2 <= 1.0)
+    decimation *= 2;
+  return decimation;
+}
+
+int videoHandler::getImageDecimation(const QImage &image) const
+{
+  // The size of a decimated image is rounded up (to a multiple of the subsampling)
+  int decimation = 1;
+  while (decimation < 64 && image.width() > 0 && image.width() * decimation < frameSize.width())
+    decimation *= 2;
+  return decimation;
+}
+
+QRectF videoHandler::getImageSourceRect(const QImage &image) const
+{
+  const int decimation = getImageDecimation(image);
+  if (decimation == 1)
+    return QRectF(image.rect());
+  return QRectF(0, 0, double(frameSize.width()) / decimation, double(frameSize.height()) / decimation);
+}
+
+void videoHandler::clearTileCache()
+{
+  QMutexLocker lock(&tileCacheAccess);
+  tileCache.clear();
 }
 
 int videoHandler::getNrFramesCached() const
 {
-  QMutexLocker lock(&imageCacheAccess);
-  return imageCache.size();
+  return cacheIndex.count();
 }
 
 // Put the frame into the cache (if it is not already in there)
@@ -259,6 +542,33 @@ void videoHandler::cacheFrame(int frameIdx, bool testMode)
     return;
   }
 
+  // If the frame was moved to the compressed cache, it is decompressed instead of loading it again
+  if (!testMode && restoreFrameFromCompressedCache(frameIdx))
+  {
+    DEBUG_VIDEO("videoHandler::cacheFrame frame %i restored from compressed cache", frameIdx);
+    return;
+  }
+
+  if (useRawDataCache())
+  {
+    // Only load the raw data. It is converted when the frame is drawn.
+    QByteArray cacheRawData;
+    loadRawDataForCaching(frameIdx, cacheRawData);
+    if (!cacheRawData.isEmpty())
+    {
+      DEBUG_VIDEO("videoHandler::cacheFrame insert raw data of frame %i into cache", frameIdx);
+      QMutexLocker imageCacheLock(&imageCacheAccess);
+      if (cacheValid && !testMode)
+      {
+        rawDataCache.insert(frameIdx, cacheRawData);
+        cacheIndex.insert(frameIdx, getCacheAccessTimestamp());
+      }
+    }
+    else
+      DEBUG_VIDEO("videoHandler::cacheFrame loading raw data of frame %i for caching failed", frameIdx);
+    return;
+  }
+
   // Load the frame. While this is happening in the background the frame size must not change.
   QImage cacheImage;
   loadFrameForCaching(frameIdx, cacheImage);
@@ -269,7 +579,10 @@ void videoHandler::cacheFrame(int frameIdx, bool testMode)
     DEBUG_VIDEO("videoHandler::cacheFrame insert frame %i into cache", frameIdx);
     QMutexLocker imageCacheLock(&imageCacheAccess);
     if (cacheValid && !testMode)
+    {
       imageCache.insert(frameIdx, cacheImage);
+      cacheIndex.insert(frameIdx, getCacheAccessTimestamp());
+    }
   }
   else
     DEBUG_VIDEO("videoHandler::cacheFrame loading frame %i for caching failed", frameIdx);
@@ -277,34 +590,118 @@ void videoHandler::cacheFrame(int frameIdx, bool testMode)
 
 unsigned int videoHandler::getCachingFrameSize() const
 {
-  auto bytes = functions::bytesPerPixel(functions::platformImageFormat());
+  if (useRawDataCache() && getBytesPerFrame() > 0)
+    return (unsigned int)getBytesPerFrame();
+  auto bytes = functions::bytesPerPixel(getOutputImageFormat());
   return frameSize.width() * frameSize.height() * bytes;
 }
 
 QList<int> videoHandler::getCachedFrames() const
 {
-  QMutexLocker lock(&imageCacheAccess);
-  return imageCache.keys();
+  return cacheIndex.getFrames();
 }
 
 int videoHandler::getNumberCachedFrames() const
 {
-  QMutexLocker lock(&imageCacheAccess);
-  return imageCache.size();
+  return cacheIndex.count();
 }
 
 bool videoHandler::isInCache(int idx) const
+{
+  return cacheIndex.contains(idx);
+}
+
+bool videoHandler::getRawDataFromCache(int frameIdx, QByteArray &cachedRawData) const
 {
   QMutexLocker lock(&imageCacheAccess);
-  return imageCache.contains(idx);
+  if (!cacheValid)
+    return false;
+  if (rawDataCache.contains(frameIdx))
+  {
+    cachedRawData = rawDataCache[frameIdx];
+    return true;
+  }
+  lock.unlock();
+
+  // The frame may have been moved to the compressed cache
+  return useRawDataCache() && compressedFrameCache::instance().getRawData(this, frameIdx, cachedRawData);
+}
+
+bool videoHandler::restoreFrameFromCompressedCache(int frameIdx)
+{
+  auto &compressedCache = compressedFrameCache::instance();
+  if (!compressedCache.isEnabled())
+    return false;
+
+  QByteArray restoredRawData;
+  QImage restoredImage;
+  const bool rawMode = useRawDataCache();
+  if (rawMode ? !compressedCache.getRawData(this, frameIdx, restoredRawData) : !compressedCache.getImage(this, frameIdx, restoredImage))
+    return false;
+  compressedCache.remove(this, frameIdx);
+
+  QMutexLocker lock(&imageCacheAccess);
+  if (cacheValid)
+  {
+    if (rawMode)
+      rawDataCache.insert(frameIdx, restoredRawData);
+    else
+      imageCache.insert(frameIdx, restoredImage);
+    cacheIndex.insert(frameIdx, getCacheAccessTimestamp());
+  }
+  return true;
+}
+
+bool videoHandler::loadFrameFromCompressedCache(int frameIndex, bool loadToDoubleBuffer)
+{
+  // If the frame is already the current image, the raw data of the frame is needed (e.g. to draw the values)
+  if ((!loadToDoubleBuffer && currentImageIdx == frameIndex) || useRawDataCache())
+    return false;
+
+  QImage image;
+  if (!compressedFrameCache::instance().getImage(this, frameIndex, image))
+    return false;
+  DEBUG_VIDEO("videoHandler::loadFrame %d from compressed cache", frameIndex);
+  if (loadToDoubleBuffer)
+  {
+    doubleBufferImage = image;
+    doubleBufferImageFrameIdx = frameIndex;
+  }
+  else
+  {
+    QMutexLocker imageLock(&currentImageSetMutex);
+    currentImage = image;
+    currentImageIdx = frameIndex;
+  }
+  return true;
 }
 
 void videoHandler::removeFrameFromCache(int frameIdx)
 {
   DEBUG_VIDEO("removeFrameFromCache %d", frameIdx);
   QMutexLocker lock(&imageCacheAccess);
-  imageCache.remove(frameIdx);
+  // Keep the frame in the compressed cache (if enabled). The compression is performed in the background.
+  auto &compressedCache = compressedFrameCache::instance();
+  if (cacheValid && compressedCache.isEnabled())
+  {
+    if (imageCache.contains(frameIdx))
+      compressedCache.insert(this, frameIdx, imageCache[frameIdx]);
+    else if (rawDataCache.contains(frameIdx))
+      compressedCache.insert(this, frameIdx, rawDataCache[frameIdx], getRawDataBytesPerSample());
+  }
+  QImage image = imageCache.take(frameIdx);
+  QByteArray rawData = rawDataCache.take(frameIdx);
+  cacheIndex.remove(frameIdx);
   lock.unlock();
+
+  // The memory of the frame is reused for the next frame that is loaded (if the frame is not used anywhere else)
+  frameBufferPool::instance().release(image);
+  frameBufferPool::instance().release(rawData);
+}
+
+int64_t videoHandler::getCacheAccessTime(int frameIdx) const
+{
+  return cacheIndex.getAccessTime(frameIdx);
 }
 
 void videoHandler::removeAllFrameFromCache()
@@ -312,14 +709,20 @@ void videoHandler::removeAllFrameFromCache()
   DEBUG_VIDEO("removeAllFrameFromCache");
   QMutexLocker lock(&imageCacheAccess);
   imageCache.clear();
+  rawDataCache.clear();
+  cacheIndex.clear();
   cacheValid = true;
   lock.unlock();
+  compressedFrameCache::instance().removeAll(this);
 }
 
 void videoHandler::loadFrame(int frameIndex, bool loadToDoubleBuffer)
 {
   DEBUG_VIDEO("videoHandler::loadFrame %d %s\n", frameIndex, (loadToDoubleBuffer) ? "toDoubleBuffer" : "");
 
+  if (loadFrameFromCompressedCache(frameIndex, loadToDoubleBuffer))
+    return;
+
   if (requestedFrame_idx != frameIndex)
   {
     // Lock the mutex for requesting raw data (we share the requestedFrame buffer with the caching function)
@@ -381,7 +784,11 @@ void videoHandler::invalidateAllBuffers()
   requestedFrame_idx = -1;
 
   imageCache.clear();
+  rawDataCache.clear();
+  cacheIndex.clear();
   cacheValid = true;
+  clearTileCache();
+  compressedFrameCache::instance().removeAll(this);
 }
 
 void videoHandler::activateDoubleBuffer()
@@ -394,6 +801,67 @@ void videoHandler::activateDoubleBuffer()
   }
 }
 
+void videoHandler::updateConversionSettings()
+{
+  const int nrThreads = getNrConversionThreadsFromSettings();
+  nrConversionThreads.storeRelease(nrThreads);
+  taskPool::instance().reserveThreads(nrThreads);
+  highBitDepthOutput.storeRelease(getHighBitDepthOutputFromSettings() ? 1 : 0);
+}
+
+bool videoHandler::isRawDataCachingEnabled()
+{
+  return rawDataCaching.loadAcquire() == 1;
+}
+
+void videoHandler::setRawDataCachingEnabled(bool enabled)
+{
+  rawDataCaching.storeRelease(enabled ? 1 : 0);
+}
+
+bool videoHandler::isHighBitDepthOutputEnabled()
+{
+  int enabled = highBitDepthOutput.loadAcquire();
+  if (enabled < 0)
+  {
+    enabled = getHighBitDepthOutputFromSettings() ? 1 : 0;
+    highBitDepthOutput.storeRelease(enabled);
+  }
+  return enabled == 1;
+}
+
+void videoHandler::convertInBands(int height, int lineAlignment, const std::function<void(int yStart, int yEnd)> &convertBand)
+{
+  // Bands should not get too small. The overhead would be bigger than the gain.
+  const int minBandHeight = 32;
+  const int nrThreads = getNrConversionThreads();
+  const int nrBands = std::min(nrThreads, height / minBandHeight);
+  if (nrBands <= 1 || lineAlignment <= 0)
+  {
+    convertBand(0, height);
+    return;
+  }
+
+  auto job = std::make_shared<bandConversionJob>();
+  job->convertBand = convertBand;
+  // The band height is rounded up to a multiple of the line alignment (e.g. the vertical chroma subsampling)
+  int bandHeight = (height + nrBands - 1) / nrBands;
+  bandHeight = ((bandHeight + lineAlignment - 1) / lineAlignment) * lineAlignment;
+  for (int yStart = 0; yStart < height; yStart += bandHeight)
+    job->bands.append(QPair<int, int>(yStart, std::min(yStart + bandHeight, height)));
+
+  // The calling thread processes bands as well. So we only need help for the remaining bands. The bands are submitted
+  // with the priority of the caller, so a frame that is converted for drawing does not wait behind the caching.
+  const taskPriority priority = taskPool::getCurrentPriority();
+  for (int i = 0; i < job->bands.size() - 1; i++)
+    taskPool::instance().submit([job]() { job->processBands(); }, priority);
+  job->processBands();
+
+  QMutexLocker locker(&job->mutex);
+  while (job->bandsDone < job->bands.size())
+    job->allBandsDone.wait(&job->mutex);
+}
+
 int videoHandler::convScaleLimitedRange(int value)
 {
   assert(value >= 0 && value <= 255);
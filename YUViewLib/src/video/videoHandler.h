@@ -32,10 +32,16 @@
 
 #pragma once
 
+#include <functional>
+#include <QAtomicInt>
 #include <QBasicTimer>
 #include <QFileInfo>
+#include <QHash>
 #include <QMutex>
+#include <QPair>
 
+#include "common/functions.h"
+#include "video/frameCacheIndex.h"
 #include "video/frameHandler.h"
 
 /* TODO
@@ -49,13 +55,15 @@ public:
   /*
   */
   videoHandler();
+  ~videoHandler();
   
   // Draw the frame with the given frame index and zoom factor. If onLoadShowLasFrame is set, show the last frame
   // if the frame with the current frame index is loaded in the background.
   virtual void drawFrame(QPainter *painter, int frameIdx, double zoomFactor, bool drawRawValues);
 
   // --- Caching ----
-  // These methods are all thread-safe and can be invoked from any thread.
+  // These methods are all thread-safe and can be invoked from any thread. The queries (which frames are cached, when
+  // were they accessed) do not lock the cache and are constant time (except getCachedFrames).
   int getNrFramesCached() const;
   void cacheFrame(int frameIdx, bool testMode);
   unsigned int getCachingFrameSize() const; // How much bytes will be used when caching one frame?
@@ -64,6 +72,18 @@ public:
   bool isInCache(int idx) const;
   virtual void removeFrameFromCache(int frameIdx);
   virtual void removeAllFrameFromCache();
+  // When was the cached frame used last (drawn or put into the cache)? This is a monotonic time in ms (0 if the frame is not cached).
+  int64_t getCacheAccessTime(int frameIdx) const;
+
+  // --- Raw data caching ---
+  // Instead of the converted images, a handler that supports it can cache the raw data of the frames (e.g. the YUV data).
+  // This needs much less memory (e.g. 1.5 instead of 4 bytes per pixel for 4:2:0 8 bit). The cached frames are converted
+  // when they are drawn. The mode is set by the video cache from the settings (group "VideoCache").
+  virtual bool supportsRawDataCaching() const { return false; }
+  // The number of bytes of one sample in the raw data. This is used to compress the raw data (see compressedFrameCache).
+  virtual int getRawDataBytesPerSample() const { return 1; }
+  static bool isRawDataCachingEnabled();
+  static void setRawDataCachingEnabled(bool enabled);
 
   // Get the number of bytes for one frame (RGB or YUV) with the current format (if this video handler uses raw data)
   virtual int64_t getBytesPerFrame() const { return -1; }
@@ -126,6 +146,41 @@ public:
 
   // Scale a value with limited mpeg range (16 ... 245) to the full range (0 ... 255) for output.
   static int convScaleLimitedRange(int value);
+
+  // --- Conversion of a region of a frame ---
+  // If only a small part of a big frame is visible (e.g. when zoomed in), only the visible tiles of the frame
+  // are converted and drawn. The converted tiles are cached (key: frame index and tile index) so that panning
+  // only converts the newly visible tiles. Frames are split into tiles of tileSize x tileSize pixels.
+  static const int tileSize = 256;
+  // Convert the given region of the frame to an image. This is only possible if canConvertFrameRegion returns true.
+  // If decimation is greater 1 (only supported for the whole frame), the image is downscaled by that factor (see supportsDecimatedConversion).
+  // Returns a null image if the region could not be converted. The default implementation does not support this.
+  virtual QImage convertFrameRegion(int frameIdx, const QRect &region, int decimation=1) { Q_UNUSED(frameIdx); Q_UNUSED(region); Q_UNUSED(decimation); return QImage(); }
+  // Can convertFrameRegion be used for the given frame right now (without loading anything)?
+  virtual bool canConvertFrameRegion(int frameIdx) const { Q_UNUSED(frameIdx); return false; }
+
+  // --- Decimated conversion ---
+  // If the frame is drawn zoomed out, the handler may convert the frames directly at a lower resolution.
+  // The decimation factor is a power of 2 so that the converted image still has at least the resolution on screen.
+  // Only the current image and the double buffer are decimated. The cached images are always in full resolution so
+  // that the cache stays valid if the zoom factor changes.
+  virtual bool supportsDecimatedConversion() const { return false; }
+  static int getDecimationForZoom(double zoomFactor);
+
+  // --- Output format ---
+  // The format of the converted images. This is the platform image format (8 bit per color) unless the handler
+  // can convert to a format with more bits per color (e.g. RGB30 for high bit depth YUV, see isHighBitDepthOutputEnabled).
+  virtual QImage::Format getOutputImageFormat() const { return functions::platformImageFormat(); }
+  // Is the conversion to more than 8 bit per color enabled in the settings (group "Conversion")?
+  static bool isHighBitDepthOutputEnabled();
+
+  // --- Slice parallel conversion ---
+  // All video handlers share one thread pool for the conversion of frames. A frame is split into horizontal bands
+  // which are converted in parallel. The number of threads is read from the settings (group "Conversion").
+  static void updateConversionSettings();
+  // Split the lines [0, height) into bands (the start of each band is a multiple of lineAlignment) and call
+  // convertBand(yStart, yEnd) for each band. The calling thread also converts bands. Returns when all bands are done.
+  static void convertInBands(int height, int lineAlignment, const std::function<void(int yStart, int yEnd)> &convertBand);
   
 signals:
 
@@ -162,6 +217,9 @@ protected:
   // the requested frame. No other internal state of the specific video format handler should be changed.
   // currentFrame/currentFrameIdx is still the frame on screen. This is called from a background thread.
   virtual void loadFrameForCaching(int frameIndex, QImage &frameToCache);
+  // The same for raw data caching (see supportsRawDataCaching). After the operation rawDataToCache should contain
+  // the raw data of the requested frame.
+  virtual void loadRawDataForCaching(int frameIndex, QByteArray &rawDataToCache) { Q_UNUSED(frameIndex); Q_UNUSED(rawDataToCache); }
     
   // Only one thread at a time should request something to be loaded. 
   QMutex requestDataMutex;
@@ -176,12 +234,51 @@ protected:
   QImage doubleBufferImage;
   int    doubleBufferImageFrameIdx;
 
-  // Set the cache to be invalid until a call to removefromCache(-1) clears it.
-  void setCacheInvalid() { cacheValid = false; }
+  // Set the cache to be invalid until a call to removefromCache(-1) clears it. The converted tiles are also invalid.
+  void setCacheInvalid() { cacheValid = false; clearTileCache(); }
+
+  // --- Conversion of a region of a frame
+  // The visible region of the frame (in pixels of the frame) when the frame was drawn the last time.
+  QRect visibleRegion;
+  // Is only a small part of the frame visible so that only the visible tiles should be converted?
+  bool useRegionConversion() const;
+  // Draw the tiles of the given frame that intersect the visible region. Missing tiles are converted.
+  void drawVisibleTiles(QPainter *painter, int frameIdx, const QRect &videoRect, double zoomFactor);
+  // Convert the whole frame from the raw data (if possible) and set it as the current image.
+  bool convertCurrentImageFromRawData(int frameIdx, int decimation=1);
+  void clearTileCache();
+  mutable QMutex tileCacheAccess;
+  QHash<QPair<int, int>, QImage> tileCache;
+  // The frame that was drawn last using the tiles (-1 if the current image was drawn)
+  int tileFrameIdx {-1};
+
+  // --- Decimated conversion
+  // The current decimation factor for the conversion of the current image and the double buffer (1 if they are
+  // converted in full resolution)
+  QAtomicInt conversionDecimation {1};
+  // Get the decimation factor of the given image (compared to the frame size) and the part of the image that contains the frame
+  int getImageDecimation(const QImage &image) const;
+  QRectF getImageSourceRect(const QImage &image) const;
 
   // --- Caching
   QMutex mutable     imageCacheAccess;
   QMap<int, QImage>  imageCache;
+  // The cached raw data if raw data caching is used (also protected by imageCacheAccess)
+  QMap<int, QByteArray> rawDataCache;
+  // Are the raw frames cached instead of the converted images?
+  bool useRawDataCache() const { return supportsRawDataCaching() && isRawDataCachingEnabled(); }
+  // Get the raw data of the given frame from the cache. Returns false if the frame is not in the raw data cache.
+  bool getRawDataFromCache(int frameIdx, QByteArray &cachedRawData) const;
+  // Frames that are removed from the cache may be kept in the compressed cache (see compressedFrameCache).
+  // Move the frame from the compressed cache back into the cache. Returns false if it is not in the compressed cache.
+  bool restoreFrameFromCompressedCache(int frameIdx);
+  // Set the image of the frame from the compressed cache as the current image (or the double buffer). This is done
+  // in loadFrame() before the frame is loaded. Returns false if the frame is not in the compressed cache.
+  bool loadFrameFromCompressedCache(int frameIndex, bool loadToDoubleBuffer);
+  // Which frames are in one of the caches and when were they accessed last (see getCacheAccessTime)? This can be read
+  // without locking. It is modified together with the caches while imageCacheAccess is locked.
+  frameCacheIndex cacheIndex;
+  bool frameInCache(int frameIdx) const { return cacheIndex.contains(frameIdx); }
   // Is the cache valid? The cache can be ivalid in the following scenario:
   // Somethign about how an item is shown changes (e.g. the resolution) but caching of the item is currently performed.
   // If we just cleared the cache, the wrong (currently being cached) frames would still end up in the cache. So we emit
@@ -36,6 +36,8 @@
 
 #include "common/functions.h"
 #include "common/fileInfo.h"
+#include "common/frameBufferPool.h"
+#include "rgbConversionKernels.h"
 #include "videoHandlerRGBCustomFormatDialog.h"
 
 using namespace RGB_Internals;
@@ -357,6 +359,9 @@ void videoHandlerRGB::loadFrame(int frameIndex, bool loadToDoubleBuffer)
     return;
   }
 
+  if (loadFrameFromCompressedCache(frameIndex, loadToDoubleBuffer))
+    return;
+
   // Does the data in currentFrameRawData need to be updated?
   if (!loadRawRGBData(frameIndex))
   {
@@ -460,20 +465,17 @@ void videoHandlerRGB::convertRGBToImage(const QByteArray &sourceBuffer, QImage &
   // In both cases, we will set the alpha channel to 255. The format of the raw buffer is: BGRA (each 8 bit).
   // Internally, this is how QImage allocates the number of bytes per line (with depth = 32):
   // const int bytes_per_line = ((width * depth + 31) >> 5) << 2; // bytes per scanline (must be multiple of 4)
+  // The image is taken from the frame buffer pool (the images of frames that were removed from the cache are reused).
+  QImage::Format outputFormat = QImage::Format_RGB32;
   if (is_Q_OS_WIN)
-    outputImage = QImage(curFrameSize, QImage::Format_ARGB32_Premultiplied);
-  else if (is_Q_OS_MAC)
-    outputImage = QImage(curFrameSize, QImage::Format_RGB32);
+    outputFormat = QImage::Format_ARGB32_Premultiplied;
   else if (is_Q_OS_LINUX)
   {
     QImage::Format f = functions::platformImageFormat();
-    if (f == QImage::Format_ARGB32_Premultiplied)
-      outputImage = QImage(curFrameSize, QImage::Format_ARGB32_Premultiplied);
-    if (f == QImage::Format_ARGB32)
-      outputImage = QImage(curFrameSize, QImage::Format_ARGB32);
-    else
-      outputImage = QImage(curFrameSize, QImage::Format_RGB32);
+    if (f == QImage::Format_ARGB32_Premultiplied || f == QImage::Format_ARGB32)
+      outputFormat = f;
   }
+  outputImage = frameBufferPool::instance().getImage(curFrameSize, outputFormat);
 
   // Check the image buffer size before we write to it
   assert(outputImage.sizeInBytes() >= curFrameSize.width() * curFrameSize.height() * 4);
@@ -499,219 +501,72 @@ void videoHandlerRGB::setSrcPixelFormat(const RGB_Internals::rgbPixelFormat &new
 
 // Convert the data in "sourceBuffer" from the format "srcPixelFormat" to RGB 888. While doing so, apply the
 // scaling factors, inversions and only convert the selected color components.
+// The conversion is performed line by line (in parallel bands) using the fastest kernel that the CPU supports (see rgbConversionKernels).
 void videoHandlerRGB::convertSourceToRGBA32Bit(const QByteArray &sourceBuffer, unsigned char *targetBuffer)
 {
   // Check if the source buffer is of the correct size
   Q_ASSERT_X(sourceBuffer.size() >= getBytesPerFrame(), Q_FUNC_INFO, "The source buffer does not hold enough data.");
 
-  // Get the raw data pointer to the output array
-  unsigned char * restrict dst = targetBuffer;
+  const auto format = srcPixelFormat;
+  const int w = frameSize.width();
+  const int h = frameSize.height();
+  if (format.bitsPerValue < 8 || format.bitsPerValue > 16)
+  {
+    Q_ASSERT_X(false, Q_FUNC_INFO, "No RGB format with less than 8 or more than 16 bits supported yet.");
+    return;
+  }
 
+  // In case of 8 bits this is 1 byte per value, for 9 to 16 bits it is 2 bytes per value.
+  const int bytesPerValue = (format.bitsPerValue > 8) ? 2 : 1;
   // How many values do we have to skip in src to get to the next input value?
-  // In case of 8 or less bits this is 1 byte per value, for 9 to 16 bits it is 2 bytes per value.
-  int offsetToNextValue = srcPixelFormat.nrChannels();
-  if (srcPixelFormat.planar)
-    offsetToNextValue = 1;
-
+  const int offsetToNextValue = format.planar ? 1 : format.nrChannels();
+  // Get the offset (in values) to the first value of the component at the given position
+  auto getComponentOffset = [&](int pos) { return format.planar ? pos * w * h : pos; };
+
+  // The offsets, scales and inversions of the R, G and B output values
+  int offset[3];
+  int scale[3];
+  bool invert[3];
   if (componentDisplayMode != DisplayAll)
   {
     // Only convert one of the components to a gray-scale image.
     // Consider inversion and scale of that component
-
-    // Which component of the source do we need?
-    int displayComponentOffset = srcPixelFormat.posR;
-    if (componentDisplayMode == DisplayG)
-      displayComponentOffset = srcPixelFormat.posG;
-    else if (componentDisplayMode == DisplayG)
-      displayComponentOffset = srcPixelFormat.posB;
-
-    // Get the scale/inversion for the displayed component
     const int displayIndex = (componentDisplayMode == DisplayR) ? 0 : (componentDisplayMode == DisplayG) ? 1 : 2;
-    const int scale = componentScale[displayIndex];
-    const bool invert = componentInvert[displayIndex];
-
-    if (srcPixelFormat.bitsPerValue > 8 && srcPixelFormat.bitsPerValue <= 16)
+    const int pos = (displayIndex == 0) ? format.posR : (displayIndex == 1) ? format.posG : format.posB;
+    for (int c = 0; c < 3; c++)
     {
-      // 9 to 16 bits per component. We assume two bytes per value.
-
-      // The source values have to be shifted left by this many bits to get 8 bit output
-      const int rightShift = srcPixelFormat.bitsPerValue - 8;
-
-      // First get the pointer to the first value that we will need.
-      unsigned short* src = (unsigned short*)sourceBuffer.data();
-      if (srcPixelFormat.planar)
-        src += displayComponentOffset * frameSize.width() * frameSize.height();
-      else
-        src += displayComponentOffset;
-
-      // Now we just have to iterate over all values and always skip "offsetToNextValue" values in src and write 3 values in dst.
-      for (int i = 0; i < frameSize.width() * frameSize.height(); i++)
-      {
-        int val = (((int)src[0]) * scale) >> rightShift;
-        val = clip(val, 0, 255);
-        if (invert)
-          val = 255 - val;
-        if (limitedRange)
-          val = videoHandler::convScaleLimitedRange(val);
-        dst[0] = val;
-        dst[1] = val;
-        dst[2] = val;
-        dst[3] = 255;
-
-        src += offsetToNextValue;
-        dst += 4;
-      }
+      offset[c] = getComponentOffset(pos);
+      scale[c] = componentScale[displayIndex];
+      invert[c] = componentInvert[displayIndex];
     }
-    else if (srcPixelFormat.bitsPerValue == 8)
-    {
-      // First get the pointer to the first value that we will need.
-      unsigned char* src = (unsigned char*)sourceBuffer.data();
-      if (srcPixelFormat.planar)
-        src += displayComponentOffset * frameSize.width() * frameSize.height();
-      else
-        src += displayComponentOffset;
-
-      // Now we just have to iterate over all values and always skip "offsetToNextValue" values in src and write 3 values in dst.
-      for (int i = 0; i < frameSize.width() * frameSize.height(); i++)
-      {
-        int val = ((int)src[0]) * scale;
-        val = clip(val, 0, 255);
-        if (invert)
-          val = 255 - val;
-        if (limitedRange)
-          val = videoHandler::convScaleLimitedRange(val);
-        dst[0] = val;
-        dst[1] = val;
-        dst[2] = val;
-        dst[3] = 255;
-
-        src += offsetToNextValue;
-        dst += 4;
-      }
-    }
-    else
-      Q_ASSERT_X(false, Q_FUNC_INFO, "No RGB format with less than 8 or more than 16 bits supported yet.");
   }
-  else if (componentDisplayMode == DisplayAll)
+  else
   {
     // Convert all components from the source RGB format to an RGB 888 array
-
-    if (srcPixelFormat.bitsPerValue > 8 && srcPixelFormat.bitsPerValue <= 16)
+    const int pos[3] = {format.posR, format.posG, format.posB};
+    for (int c = 0; c < 3; c++)
     {
-      // 9 to 16 bits per component. We assume two bytes per value.
-
-      // The source values have to be shifted left by this many bits to get 8 bit output
-      const int rightShift = srcPixelFormat.bitsPerValue - 8;
-
-      // First get the pointer to the first value of each channel.
-      unsigned short *srcR, *srcG, *srcB;
-      if (srcPixelFormat.planar)
-      {
-        srcR = (unsigned short*)sourceBuffer.data() + (srcPixelFormat.posR * frameSize.width() * frameSize.height());
-        srcG = (unsigned short*)sourceBuffer.data() + (srcPixelFormat.posG * frameSize.width() * frameSize.height());
-        srcB = (unsigned short*)sourceBuffer.data() + (srcPixelFormat.posB * frameSize.width() * frameSize.height());
-      }
-      else
-      {
-        srcR = (unsigned short*)sourceBuffer.data() + srcPixelFormat.posR;
-        srcG = (unsigned short*)sourceBuffer.data() + srcPixelFormat.posG;
-        srcB = (unsigned short*)sourceBuffer.data() + srcPixelFormat.posB;
-      }
-
-      // Now we just have to iterate over all values and always skip "offsetToNextValue" values in the sources and write 3 values in dst.
-      for (int i = 0; i < frameSize.width() * frameSize.height(); i++)
-      {
-        int valR = (((int)srcR[0]) * componentScale[0]) >> rightShift;
-        valR = clip(valR, 0, 255);
-        if (componentInvert[0])
-          valR = 255 - valR;
-        
-        int valG = (((int)srcG[0]) * componentScale[1]) >> rightShift;
-        valG = clip(valG, 0, 255);
-        if (componentInvert[1])
-          valG = 255 - valG;
-
-        int valB = (((int)srcB[0]) * componentScale[2]) >> rightShift;
-        valB = clip(valB, 0, 255);
-        if (componentInvert[2])
-          valB = 255 - valB;
-
-        if (limitedRange)
-        {
-          valR = videoHandler::convScaleLimitedRange(valR);
-          valG = videoHandler::convScaleLimitedRange(valG);
-          valB = videoHandler::convScaleLimitedRange(valB);
-        }
-
-        srcR += offsetToNextValue;
-        srcG += offsetToNextValue;
-        srcB += offsetToNextValue;
-
-        dst[0] = valB;
-        dst[1] = valG;
-        dst[2] = valR;
-        dst[3] = 255;
-        dst += 4;
-      }
+      offset[c] = getComponentOffset(pos[c]);
+      scale[c] = componentScale[c];
+      invert[c] = componentInvert[c];
     }
-    else if (srcPixelFormat.bitsPerValue == 8)
-    {
-      // First get the pointer to the first value of each channel.
-      unsigned char *srcR, *srcG, *srcB;
-      if (srcPixelFormat.planar)
-      {
-        srcR = (unsigned char*)sourceBuffer.data() + (srcPixelFormat.posR * frameSize.width() * frameSize.height());
-        srcG = (unsigned char*)sourceBuffer.data() + (srcPixelFormat.posG * frameSize.width() * frameSize.height());
-        srcB = (unsigned char*)sourceBuffer.data() + (srcPixelFormat.posB * frameSize.width() * frameSize.height());
-      }
-      else
-      {
-        srcR = (unsigned char*)sourceBuffer.data() + srcPixelFormat.posR;
-        srcG = (unsigned char*)sourceBuffer.data() + srcPixelFormat.posG;
-        srcB = (unsigned char*)sourceBuffer.data() + srcPixelFormat.posB;
-      }
-
-      // Now we just have to iterate over all values and always skip "offsetToNextValue" values in the sources and write 3 values in dst.
-      for (int i = 0; i < frameSize.width() * frameSize.height(); i++)
-      {
-        int valR = ((int)srcR[0]) * componentScale[0];
-        valR = clip(valR, 0, 255);
-        if (componentInvert[0])
-          valR = 255 - valR;
-
-        int valG = ((int)srcG[0]) * componentScale[1];
-        valG = clip(valG, 0, 255);
-        if (componentInvert[1])
-          valG = 255 - valG;
-
-        int valB = ((int)srcB[0]) * componentScale[2];
-        valB = clip(valB, 0, 255);
-        if (componentInvert[2])
-          valB = 255 - valB;
-
-        if (limitedRange)
-        {
-          valR = videoHandler::convScaleLimitedRange(valR);
-          valG = videoHandler::convScaleLimitedRange(valG);
-          valB = videoHandler::convScaleLimitedRange(valB);
-        }
+  }
 
-        srcR += offsetToNextValue;
-        srcG += offsetToNextValue;
-        srcB += offsetToNextValue;
+  const RGBLineConversionParameters par(format.bitsPerValue, offsetToNextValue, scale, invert, limitedRange);
+  const auto &kernels = getRGBConversionKernels();
+  const unsigned char *src = (const unsigned char*)sourceBuffer.constData();
+  const int bytesPerLine = w * offsetToNextValue * bytesPerValue;
 
-        dst[0] = valB;
-        dst[1] = valG;
-        dst[2] = valR;
-        dst[3] = 255;
-        dst += 4;
-      }
+  videoHandler::convertInBands(h, 1, [&](int yStart, int yEnd)
+  {
+    for (int y = yStart; y < yEnd; y++)
+    {
+      const unsigned char * const srcLine[3] = {src + offset[0] * bytesPerValue + y * bytesPerLine,
+                                                src + offset[1] * bytesPerValue + y * bytesPerLine,
+                                                src + offset[2] * bytesPerValue + y * bytesPerLine};
+      kernels.convertLineToBGRA(srcLine, targetBuffer + y * w * 4, w, par);
     }
-    else
-      Q_ASSERT_X(false, Q_FUNC_INFO, "No RGB format with less than 8 or more than 16 bits supported yet.");
-  }
-  else
-    Q_ASSERT_X(false, Q_FUNC_INFO, "Unsupported display mode.");
+  });
 }
 
 videoHandlerRGB::rgba_t videoHandlerRGB::getPixelValue(const QPoint &pixelPos) const
@@ -34,15 +34,17 @@
 
 #include <algorithm>
 #include <cstdio>
-#if SSE_CONVERSION_420_ALT
-#include <xmmintrin.h>
-#endif
+#include <cstring>
+#include <vector>
 #include <QDir>
 #include <QPainter>
+#include <QThread>
 
 #include "videoHandlerYUVCustomFormatDialog.h"
+#include "yuvConversionKernels.h"
 #include "yuvPixelFormatGuess.h"
 #include "common/fileInfo.h"
+#include "common/frameBufferPool.h"
 #include "common/functions.h"
 
 using namespace YUV_Internals;
@@ -144,148 +146,6 @@ void videoHandlerYUV::drawFrame(QPainter *painter, int frameIdx, double zoomFact
 
 /// --- Convert from the current YUV input format to YUV 444
 
-#if SSE_CONVERSION_420_ALT
-void videoHandlerYUV::yuv420_to_argb8888(quint8 *yp, quint8 *up, quint8 *vp, quint32 sy, quint32 suv, int width, int height, quint8 *rgb, quint32 srgb)
-{
-  __m128i y0r0, y0r1, u0, v0;
-  __m128i y00r0, y01r0, y00r1, y01r1;
-  __m128i u00, u01, v00, v01;
-  __m128i rv00, rv01, gu00, gu01, gv00, gv01, bu00, bu01;
-  __m128i r00, r01, g00, g01, b00, b01;
-  __m128i rgb0123, rgb4567, rgb89ab, rgbcdef;
-  __m128i gbgb;
-  __m128i ysub, uvsub;
-  __m128i zero, facy, facrv, facgu, facgv, facbu;
-  __m128i *srcy128r0, *srcy128r1;
-  __m128i *dstrgb128r0, *dstrgb128r1;
-  __m64   *srcu64, *srcv64;
-
-
-  //    Implement the following conversion:
-  //    B = 1.164(Y - 16)                   + 2.018(U - 128)
-  //    G = 1.164(Y - 16) - 0.813(V - 128)  - 0.391(U - 128)
-  //    R = 1.164(Y - 16) + 1.596(V - 128)
-
-  int x, y;
-  // constants
-  ysub  = _mm_set1_epi32(0x00100010); // value 16 for subtraction
-  uvsub = _mm_set1_epi32(0x00800080); // value 128
-
-  // multiplication factors bit shifted by 6
-  facy  = _mm_set1_epi32(0x004a004a);
-  facrv = _mm_set1_epi32(0x00660066);
-  facgu = _mm_set1_epi32(0x00190019);
-  facgv = _mm_set1_epi32(0x00340034);
-  facbu = _mm_set1_epi32(0x00810081);
-
-  zero  = _mm_set1_epi32(0x00000000);
-
-  for(y = 0; y < height; y += 2)
-  {
-    srcy128r0 = (__m128i *)(yp + sy*y);
-    srcy128r1 = (__m128i *)(yp + sy*y + sy);
-    srcu64 = (__m64 *)(up + suv*(y/2));
-    srcv64 = (__m64 *)(vp + suv*(y/2));
-
-    // dst row 0 and row 1
-    dstrgb128r0 = (__m128i *)(rgb + srgb*y);
-    dstrgb128r1 = (__m128i *)(rgb + srgb*y + srgb);
-
-    for(x = 0; x < width; x += 16)
-    {
-      u0 = _mm_loadl_epi64((__m128i *)srcu64); srcu64++;
-      v0 = _mm_loadl_epi64((__m128i *)srcv64); srcv64++;
-
-      y0r0 = _mm_load_si128(srcy128r0++);
-      y0r1 = _mm_load_si128(srcy128r1++);
-
-      // expand to 16 bit, subtract and multiply constant y factors
-      y00r0 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y0r0, zero), ysub), facy);
-      y01r0 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y0r0, zero), ysub), facy);
-      y00r1 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y0r1, zero), ysub), facy);
-      y01r1 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y0r1, zero), ysub), facy);
-
-      // expand u and v so they're aligned with y values
-      u0  = _mm_unpacklo_epi8(u0,  zero);
-      u00 = _mm_sub_epi16(_mm_unpacklo_epi16(u0, u0), uvsub);
-      u01 = _mm_sub_epi16(_mm_unpackhi_epi16(u0, u0), uvsub);
-
-      v0  = _mm_unpacklo_epi8(v0,  zero);
-      v00 = _mm_sub_epi16(_mm_unpacklo_epi16(v0, v0), uvsub);
-      v01 = _mm_sub_epi16(_mm_unpackhi_epi16(v0, v0), uvsub);
-
-      // common factors on both rows.
-      rv00 = _mm_mullo_epi16(facrv, v00);
-      rv01 = _mm_mullo_epi16(facrv, v01);
-      gu00 = _mm_mullo_epi16(facgu, u00);
-      gu01 = _mm_mullo_epi16(facgu, u01);
-      gv00 = _mm_mullo_epi16(facgv, v00);
-      gv01 = _mm_mullo_epi16(facgv, v01);
-      bu00 = _mm_mullo_epi16(facbu, u00);
-      bu01 = _mm_mullo_epi16(facbu, u01);
-
-      // add together and bit shift to the right
-      r00 = _mm_srai_epi16(_mm_add_epi16(y00r0, rv00), 6);
-      r01 = _mm_srai_epi16(_mm_add_epi16(y01r0, rv01), 6);
-      g00 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(y00r0, gu00), gv00), 6);
-      g01 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(y01r0, gu01), gv01), 6);
-      b00 = _mm_srai_epi16(_mm_add_epi16(y00r0, bu00), 6);
-      b01 = _mm_srai_epi16(_mm_add_epi16(y01r0, bu01), 6);
-
-      r00 = _mm_packus_epi16(r00, r01);
-      g00 = _mm_packus_epi16(g00, g01);
-      b00 = _mm_packus_epi16(b00, b01);
-
-      // shuffle back together to lower 0rgb0rgb...
-      r01     = _mm_unpacklo_epi8(r00,  zero); // 0r0r...
-      gbgb    = _mm_unpacklo_epi8(b00,  g00);  // gbgb...
-      rgb0123 = _mm_unpacklo_epi16(gbgb, r01);  // lower 0rgb0rgb...
-      rgb4567 = _mm_unpackhi_epi16(gbgb, r01);  // upper 0rgb0rgb...
-
-      // shuffle back together to upper 0rgb0rgb...
-      r01     = _mm_unpackhi_epi8(r00,  zero);
-      gbgb    = _mm_unpackhi_epi8(b00,  g00);
-      rgb89ab = _mm_unpacklo_epi16(gbgb, r01);
-      rgbcdef = _mm_unpackhi_epi16(gbgb, r01);
-
-      // write to dst
-      _mm_store_si128(dstrgb128r0++, rgb0123);
-      _mm_store_si128(dstrgb128r0++, rgb4567);
-      _mm_store_si128(dstrgb128r0++, rgb89ab);
-      _mm_store_si128(dstrgb128r0++, rgbcdef);
-
-      // row 1
-      r00 = _mm_srai_epi16(_mm_add_epi16(y00r1, rv00), 6);
-      r01 = _mm_srai_epi16(_mm_add_epi16(y01r1, rv01), 6);
-      g00 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(y00r1, gu00), gv00), 6);
-      g01 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(y01r1, gu01), gv01), 6);
-      b00 = _mm_srai_epi16(_mm_add_epi16(y00r1, bu00), 6);
-      b01 = _mm_srai_epi16(_mm_add_epi16(y01r1, bu01), 6);
-
-      r00 = _mm_packus_epi16(r00, r01);
-      g00 = _mm_packus_epi16(g00, g01);
-      b00 = _mm_packus_epi16(b00, b01);
-
-      r01     = _mm_unpacklo_epi8(r00,  zero);
-      gbgb    = _mm_unpacklo_epi8(b00,  g00);
-      rgb0123 = _mm_unpacklo_epi16(gbgb, r01);
-      rgb4567 = _mm_unpackhi_epi16(gbgb, r01);
-
-      r01     = _mm_unpackhi_epi8(r00,  zero);
-      gbgb    = _mm_unpackhi_epi8(b00,  g00);
-      rgb89ab = _mm_unpacklo_epi16(gbgb, r01);
-      rgbcdef = _mm_unpackhi_epi16(gbgb, r01);
-
-      _mm_store_si128(dstrgb128r1++, rgb0123);
-      _mm_store_si128(dstrgb128r1++, rgb4567);
-      _mm_store_si128(dstrgb128r1++, rgb89ab);
-      _mm_store_si128(dstrgb128r1++, rgbcdef);
-
-    }
-  }
-}
-#endif
-
 QLayout *videoHandlerYUV::createVideoHandlerControls(bool isSizeFixed)
 {
   // Absolutely always only call this function once!
@@ -974,30 +834,107 @@ void videoHandlerYUV::loadFrame(int frameIndex, bool loadToDoubleBuffer)
     // We cannot load a frame if the format is not known
     return;
 
+  if (loadFrameFromCompressedCache(frameIndex, loadToDoubleBuffer))
+    return;
+
   // Does the data in currentFrameRawData need to be updated?
   if (!loadRawYUVData(frameIndex))
     // Loading failed or it is still being performed in the background
     return;
 
   // The data in currentFrameRawData is now up to date. If necessary
-  // convert the data to RGB.
+  // convert the data to RGB. If only a small part of the frame is visible, the visible tiles
+  // are converted when the frame is drawn.
+  if (!loadToDoubleBuffer && useRegionConversion() && canConvertFrameRegion(frameIndex))
+    return;
   if (loadToDoubleBuffer)
   {
     QImage newImage;
-    convertYUVToImage(currentFrameRawData, newImage, srcPixelFormat, frameSize);
+    convertYUVToImage(currentFrameRawData, newImage, srcPixelFormat, frameSize, conversionDecimation);
     doubleBufferImage = newImage;
     doubleBufferImageFrameIdx = frameIndex;
   }
   else if (currentImageIdx != frameIndex)
   {
     QImage newImage;
-    convertYUVToImage(currentFrameRawData, newImage, srcPixelFormat, frameSize);
+    convertYUVToImage(currentFrameRawData, newImage, srcPixelFormat, frameSize, conversionDecimation);
     QMutexLocker setLock(&currentImageSetMutex);    
     currentImage = newImage;
     currentImageIdx = frameIndex;
   }
 }
 
+bool videoHandlerYUV::canConvertFrameRegion(int frameIdx) const
+{
+  return currentFrameRawData_frameIdx == frameIdx && cacheValid && srcPixelFormat.planar && srcPixelFormat.canConvertToRGB(frameSize);
+}
+
+QImage videoHandlerYUV::convertFrameRegion(int frameIdx, const QRect &region, int decimation)
+{
+  // Don't wait if raw data is currently being loaded. The item will be redrawn when loading is done.
+  if (!requestDataMutex.tryLock())
+    return QImage();
+  const QByteArray rawYUVData = currentFrameRawData;
+  const bool rawDataValid = (currentFrameRawData_frameIdx == frameIdx);
+  requestDataMutex.unlock();
+
+  const yuvPixelFormat format = srcPixelFormat;
+  const QSize curFrameSize = frameSize;
+  const QRect frameRect = QRect(QPoint(0, 0), curFrameSize);
+  if (!rawDataValid || !format.canConvertToRGB(curFrameSize) || !frameRect.contains(region))
+    return QImage();
+
+  // The whole frame can also be converted from packed data
+  if (region == frameRect)
+  {
+    QImage image;
+    convertYUVToImage(rawYUVData, image, format, curFrameSize, decimation);
+    return image;
+  }
+  if (decimation != 1 || !format.planar)
+    return QImage();
+
+  // Get a window around the region that is aligned to the chroma subsampling. We add one chroma sample on each side so that
+  // chroma interpolation and chroma offset resampling within the region give the same result as for the whole frame.
+  const int subH = (format.subsampling == Subsampling::YUV_400) ? 1 : format.getSubsamplingHor();
+  const int subV = (format.subsampling == Subsampling::YUV_400) ? 1 : format.getSubsamplingVer();
+  const int left   = std::max(region.left() / subH - 1, 0) * subH;
+  const int top    = std::max(region.top() / subV - 1, 0) * subV;
+  const int right  = std::min((region.right() / subH + 2) * subH, curFrameSize.width());
+  const int bottom = std::min((region.bottom() / subV + 2) * subV, curFrameSize.height());
+  const QRect window(left, top, right - left, bottom - top);
+
+  // Copy the window from all planes (the alpha plane is not needed for the conversion)
+  const int bytesPerSample = (format.bitsPerSample > 8) ? 2 : 1;
+  const int nrChromaPlanes = (format.subsampling == Subsampling::YUV_400) ? 0 : format.uvInterleaved ? 1 : 2;
+  const int valuesPerChromaSample = format.uvInterleaved ? ((format.planeOrder == PlaneOrder::YUV || format.planeOrder == PlaneOrder::YVU) ? 2 : 3) : 1;
+  const int wC = curFrameSize.width() / subH;
+  const int hC = curFrameSize.height() / subV;
+
+  const int lumaLineBytes = window.width() * bytesPerSample;
+  const int chromaLineBytes = window.width() / subH * bytesPerSample * valuesPerChromaSample;
+  const int nrChromaLines = window.height() / subV;
+  QByteArray windowData;
+  windowData.resize(lumaLineBytes * window.height() + chromaLineBytes * nrChromaLines * nrChromaPlanes);
+  char *dst = windowData.data();
+  const char *src = rawYUVData.constData();
+  for (int y = window.top(); y <= window.bottom(); y++, dst += lumaLineBytes)
+    memcpy(dst, src + (y * curFrameSize.width() + window.left()) * bytesPerSample, lumaLineBytes);
+  src += curFrameSize.width() * curFrameSize.height() * bytesPerSample;
+  for (int c = 0; c < nrChromaPlanes; c++)
+  {
+    for (int y = window.top() / subV; y < window.top() / subV + nrChromaLines; y++, dst += chromaLineBytes)
+      memcpy(dst, src + (y * wC + window.left() / subH) * bytesPerSample * valuesPerChromaSample, chromaLineBytes);
+    src += wC * hC * bytesPerSample * valuesPerChromaSample;
+  }
+
+  QImage windowImage;
+  convertYUVToImage(windowData, windowImage, format, window.size());
+  if (windowImage.isNull())
+    return QImage();
+  return windowImage.copy(region.translated(-window.topLeft()));
+}
+
 void videoHandlerYUV::loadFrameForCaching(int frameIndex, QImage &frameToCache)
 {
   DEBUG_YUV("videoHandlerYUV::loadFrameForCaching " << frameIndex);
@@ -1018,10 +955,24 @@ void videoHandlerYUV::loadFrameForCaching(int frameIndex, QImage &frameToCache)
     return;
   }
 
-  // Convert YUV to image. This can then be cached.
+  // Convert YUV to image. This can then be cached. Cached images are always in full resolution (no decimation).
   convertYUVToImage(tmpBufferRawYUVDataCaching, frameToCache, yuvFormat, curFrameSize);
 }
 
+void videoHandlerYUV::loadRawDataForCaching(int frameIndex, QByteArray &rawDataToCache)
+{
+  DEBUG_YUV("videoHandlerYUV::loadRawDataForCaching " << frameIndex);
+
+  requestDataMutex.lock();
+  emit signalRequestRawData(frameIndex, true);
+  if (frameIndex == rawData_frameIdx)
+    rawDataToCache = rawData;
+  requestDataMutex.unlock();
+
+  // The raw data may be a view of a memory mapped file. The cache must have its own copy.
+  frameBufferPool::instance().makeOwned(rawDataToCache);
+}
+
 // Load the raw YUV data for the given frame index into currentFrameRawData.
 bool videoHandlerYUV::loadRawYUVData(int frameIndex)
 {
@@ -1031,6 +982,17 @@ bool videoHandlerYUV::loadRawYUVData(int frameIndex)
 
   DEBUG_YUV("videoHandlerYUV::loadRawYUVData " << frameIndex);
 
+  QByteArray cachedRawData;
+  if (getRawDataFromCache(frameIndex, cachedRawData))
+  {
+    // The raw data is in the cache. No need to load it.
+    QMutexLocker lock(&requestDataMutex);
+    currentFrameRawData = cachedRawData;
+    currentFrameRawData_frameIdx = frameIndex;
+    DEBUG_YUV("videoHandlerYUV::loadRawYUVData " << frameIndex << " from cache");
+    return true;
+  }
+
   // The function loadFrameForCaching also uses the signalRequesRawYUVData to request raw data.
   // However, only one thread can use this at a time.
   requestDataMutex.lock();
@@ -1082,47 +1044,6 @@ inline int transformYUV(const bool invert, const int scale, const int offset, co
   return newValue;
 }
 
-inline void convertYUVToRGB8Bit(const unsigned int valY, const unsigned int valU, const unsigned int valV, int &valR, int &valG, int &valB, const int RGBConv[5], const bool fullRange, const int bps)
-{
-  if (bps > 14)
-  {
-    // The bit depth of an int (32) is not enough to perform a YUV -> RGB conversion for a bit depth > 14 bits.
-    // We could use 64 bit values but for what? We are clipping the result to 8 bit anyways so let's just
-    // get rid of 2 of the bits for the YUV values.
-    const int yOffset = (fullRange ? 0 : 16<<(bps-10));
-    const int cZero = 128<<(bps-10);
-
-    const int Y_tmp = ((valY >> 2) - yOffset) * RGBConv[0];
-    const int U_tmp = (valU >> 2) - cZero;
-    const int V_tmp = (valV >> 2) - cZero;
-
-    const int R_tmp = (Y_tmp                      + V_tmp * RGBConv[1]) >> (16 + bps - 10); //32 to 16 bit conversion by right shifting
-    const int G_tmp = (Y_tmp + U_tmp * RGBConv[2] + V_tmp * RGBConv[3]) >> (16 + bps - 10);
-    const int B_tmp = (Y_tmp + U_tmp * RGBConv[4]                     ) >> (16 + bps - 10);
-
-    valR = (R_tmp < 0) ? 0 : (R_tmp > 255) ? 255 : R_tmp;
-    valG = (G_tmp < 0) ? 0 : (G_tmp > 255) ? 255 : G_tmp;
-    valB = (B_tmp < 0) ? 0 : (B_tmp > 255) ? 255 : B_tmp;
-  }
-  else
-  {
-    const int yOffset = (fullRange ? 0 : 16<<(bps-8));
-    const int cZero = 128<<(bps-8);
-
-    const int Y_tmp = (valY - yOffset) * RGBConv[0];
-    const int U_tmp = valU - cZero;
-    const int V_tmp = valV - cZero;
-
-    const int R_tmp = (Y_tmp                      + V_tmp * RGBConv[1]) >> (16 + bps - 8); //32 to 16 bit conversion by right shifting
-    const int G_tmp = (Y_tmp + U_tmp * RGBConv[2] + V_tmp * RGBConv[3]) >> (16 + bps - 8);
-    const int B_tmp = (Y_tmp + U_tmp * RGBConv[4]                     ) >> (16 + bps - 8);
-
-    valR = (R_tmp < 0) ? 0 : (R_tmp > 255) ? 255 : R_tmp;
-    valG = (G_tmp < 0) ? 0 : (G_tmp > 255) ? 255 : G_tmp;
-    valB = (B_tmp < 0) ? 0 : (B_tmp > 255) ? 255 : B_tmp;
-  }
-}
-
 inline int getValueFromSource(const unsigned char * restrict src, const int idx, const int bps, const bool bigEndian)
 {
   if (bps > 8)
@@ -1491,681 +1412,380 @@ inline void UVPlaneResamplingChromaOffset(const yuvPixelFormat format, const int
   }
 }
 
-inline void YUVPlaneToRGB_444(const int componentSize, const MathParameters mathY, const MathParameters mathC,
-                              const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const int bps, const bool bigEndian, const int inValSkip)
+// Apply the YUV math to one line of n samples. The invert flag is a template parameter so that the loop does not branch.
+template<bool invert>
+inline void transformYUVLine(int32_t * restrict line, const int n, const int scale, const int offset, const int clipMax)
 {
-  const bool applyMathLuma = mathY.mathRequired();
-  const bool applyMathChroma = mathC.mathRequired();
-
-  for (int i = 0; i < componentSize; ++i)
-  {
-    unsigned int valY = getValueFromSource(srcY, i, bps, bigEndian);
-    unsigned int valU = getValueFromSource(srcU, i*inValSkip, bps, bigEndian);
-    unsigned int valV = getValueFromSource(srcV, i*inValSkip, bps, bigEndian);
-
-    if (applyMathLuma)
-      valY = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY, inMax);
-    if (applyMathChroma)
-    {
-      valU = transformYUV(mathC.invert, mathC.scale, mathC.offset, valU, inMax);
-      valV = transformYUV(mathC.invert, mathC.scale, mathC.offset, valV, inMax);
-    }
+  for (int i = 0; i < n; i++)
+    line[i] = transformYUV(invert, scale, offset, line[i], clipMax);
+}
 
-    // Get the RGB values for this sample
-    int valR, valG, valB;
-    convertYUVToRGB8Bit(valY, valU, valV, valR, valG, valB, RGBConv, fullRange, bps);
+// Read one line of n samples into dst using the given read kernel and apply the YUV math (if required).
+inline void readLineOfSamples(const yuvConversionKernels::readLineFunction readLine, const unsigned char * restrict src, int32_t * restrict dst, const int n,
+                              const MathParameters &math, const int inMax, const int inValSkip)
+{
+  readLine(src, dst, n, inValSkip);
 
-    // Save the RGB values
-    dst[i*4  ] = valB;
-    dst[i*4+1] = valG;
-    dst[i*4+2] = valR;
-    dst[i*4+3] = 255;
-  }
+  if (!math.mathRequired())
+    return;
+  if (math.invert)
+    transformYUVLine<true>(dst, n, math.scale, math.offset, inMax);
+  else
+    transformYUVLine<false>(dst, n, math.scale, math.offset, inMax);
 }
 
-inline void YUVPlaneToRGB_422(const int w, const int h, const MathParameters mathY, const MathParameters mathC,
-                              const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const ChromaInterpolation interpolation, const int bps, const bool bigEndian, const int inValSkip)
+// Horizontal up-sampling of one line of wC chroma samples by the given factor (2 or 4).
+// For the last chroma sample, there is no next sample. Just sample and hold. No interpolation required either.
+template<int factor, ChromaInterpolation interpolation>
+inline void upsampleChromaLineHor(const int32_t * restrict src, int32_t * restrict dst, const int wC)
 {
-  const bool applyMathLuma = mathY.mathRequired();
-  const bool applyMathChroma = mathC.mathRequired();
-  // Horizontal up-sampling is required. Process two Y values at a time
-  for (int y = 0; y < h; y++)
+  for (int x = 0; x < wC-1; x++)
   {
-    const int srcIdxUV = y*w/2;
-    int curUSample = getValueFromSource(srcU, srcIdxUV*inValSkip, bps, bigEndian);
-    int curVSample = getValueFromSource(srcV, srcIdxUV*inValSkip, bps, bigEndian);
-    if (applyMathChroma)
+    if (factor == 2)
     {
-      curUSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, curUSample, inMax);
-      curVSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, curVSample, inMax);
+      dst[x*2  ] = src[x];
+      dst[x*2+1] = interpolateUVSample(interpolation, src[x], src[x+1]);
     }
-
-    for (int x = 0; x < (w/2)-1; x++)
+    else
     {
-      // Get the next U/V sample
-      const int srcPosLineUV = srcIdxUV + x + 1;
-      int nextUSample = getValueFromSource(srcU, srcPosLineUV*inValSkip, bps, bigEndian);
-      int nextVSample = getValueFromSource(srcV, srcPosLineUV*inValSkip, bps, bigEndian);
-      if (applyMathChroma)
-      {
-        nextUSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextUSample, inMax);
-        nextVSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextVSample, inMax);
-      }
-
-      // From the current and the next U/V sample, interpolate the UV sample in between
-      int interpolatedU = interpolateUVSample(interpolation, curUSample, nextUSample);
-      int interpolatedV = interpolateUVSample(interpolation, curVSample, nextVSample);
-
-      // Get the 2 Y samples
-      int valY1 = getValueFromSource(srcY, y*w+x*2,   bps, bigEndian);
-      int valY2 = getValueFromSource(srcY, y*w+x*2+1, bps, bigEndian);
-      if (applyMathLuma)
-      {
-        valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-        valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-      }
-
-      // Convert to 2 RGB values and save them (BGRA)
-      int valR1, valR2, valG1, valG2, valB1, valB2;
-      convertYUVToRGB8Bit(valY1, curUSample   , curVSample   , valR1, valG1, valB1, RGBConv, fullRange, bps);
-      convertYUVToRGB8Bit(valY2, interpolatedU, interpolatedV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-      const int pos = (y*w+x*2)*4;
-      dst[pos  ] = valB1;
-      dst[pos+1] = valG1;
-      dst[pos+2] = valR1;
-      dst[pos+3] = 255;
-      dst[pos+4] = valB2;
-      dst[pos+5] = valG2;
-      dst[pos+6] = valR2;
-      dst[pos+7] = 255;
-
-      // The next one is now the current one
-      curUSample = nextUSample;
-      curVSample = nextVSample;
+      for (int i = 0; i < 4; i++)
+        dst[x*4+i] = interpolateUVSampleQ(interpolation, src[x], src[x+1], i);
     }
+  }
+  for (int i = 0; i < factor; i++)
+    dst[(wC-1)*factor+i] = src[wC-1];
+}
 
-    // For the last row, there is no next sample. Just reuse the current one again. No interpolation required either.
-
-    // Get the 2 Y samples
-    int valY1 = getValueFromSource(srcY, (y+1)*w-2, bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (y+1)*w-1, bps, bigEndian);
-    if (applyMathLuma)
-    {
-      valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-      valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-    }
+// For 4:2:0, get the chroma samples for a luma line between the two given chroma lines (line and the next line _NL).
+// Interpolate vertically and in 2D for the positions in between 4 chroma samples. Only vertical interpolation at the right border.
+template<ChromaInterpolation interpolation>
+inline void upsampleChromaLine420Between(const int32_t * restrict src, const int32_t * restrict src_NL, int32_t * restrict dst, const int wC)
+{
+  for (int x = 0; x < wC-1; x++)
+  {
+    dst[x*2  ] = interpolateUVSample(interpolation, src[x], src_NL[x]);
+    dst[x*2+1] = interpolateUVSample2D(interpolation, src[x], src[x+1], src_NL[x], src_NL[x+1]);
+  }
+  dst[wC*2-2] = dst[wC*2-1] = interpolateUVSample(interpolation, src[wC-1], src_NL[wC-1]);
+}
 
-    // Convert to 2 RGB values and save them
-    int valR1, valR2, valG1, valG2, valB1, valB2;
-    convertYUVToRGB8Bit(valY1, curUSample, curVSample, valR1, valG1, valB1, RGBConv, fullRange, bps);
-    convertYUVToRGB8Bit(valY2, curUSample, curVSample, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos = ((y+1)*w)*4;
-    dst[pos-8] = valB1;
-    dst[pos-7] = valG1;
-    dst[pos-6] = valR1;
-    dst[pos-5] = 255;
-    dst[pos-4] = valB2;
-    dst[pos-3] = valG2;
-    dst[pos-2] = valR2;
-    dst[pos-1] = 255;
+// Vertical interpolation between two lines of chroma samples (line and the next line _NL) at the given quarter position
+template<ChromaInterpolation interpolation>
+inline void interpolateChromaLinesVer(const int32_t * restrict src, const int32_t * restrict src_NL, int32_t * restrict dst, const int n, const int quarterPos)
+{
+  if (interpolation != ChromaInterpolation::Bilinear || quarterPos == 0)
+  {
+    std::copy(src, src + n, dst);
+    return;
   }
+  for (int x = 0; x < n; x++)
+    dst[x] = interpolateUVSampleQ(interpolation, src[x], src_NL[x], quarterPos);
+}
+
+constexpr int getSubsamplingHor(const Subsampling subsampling)
+{
+  return (subsampling == Subsampling::YUV_422 || subsampling == Subsampling::YUV_420) ? 2 : (subsampling == Subsampling::YUV_410 || subsampling == Subsampling::YUV_411) ? 4 : 1;
+}
+
+constexpr int getSubsamplingVer(const Subsampling subsampling)
+{
+  return (subsampling == Subsampling::YUV_420 || subsampling == Subsampling::YUV_440) ? 2 : (subsampling == Subsampling::YUV_410) ? 4 : 1;
 }
 
-inline void YUVPlaneToRGB_440(const int w, const int h, const MathParameters mathY, const MathParameters mathC,
-                              const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange,const int inMax, const ChromaInterpolation interpolation, const int bps, const bool bigEndian, const int inValSkip)
+// Convert the given YUV planes to RGB (BGRA) with up-sampling of the chroma components (4:4:4, 4:2:2, 4:2:0, 4:4:0, 4:1:0, 4:1:1).
+// Only the lines [yStart, yEnd) of the frame are converted so that multiple bands can be converted in parallel. The conversion is performed line by line. For each line, the luma samples and the (up-sampled) chroma samples are read into
+// 32 bit buffers which are then converted using the fastest kernel that the CPU supports (see yuvConversionKernels).
+// The subsampling and the chroma interpolation are template parameters so that there is one specialized version of this function for
+// each combination without any branches on these in the inner loops. The bit depth and endianness select the read kernel once per call.
+// If lookup tables are given, they are used for the conversion instead of the conversion kernel. The tables include the luma math.
+// The output is BGRA with 8 bit per value or RGB30 with 10 bit per value (outputBitDepth 10, no lookup tables).
+template<Subsampling subsampling, ChromaInterpolation interpolation>
+void YUVPlaneToRGB(const yuvPixelFormat &format, const int w, const int h, const MathParameters mathY, const MathParameters mathC,
+                   const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
+                   unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const LineConversionLUT *lut, const int outputBitDepth,
+                   const int inValSkip, const int yStart, const int yEnd)
 {
-  const bool applyMathLuma = mathY.mathRequired();
-  const bool applyMathChroma = mathC.mathRequired();
-  // Vertical up-sampling is required. Process two Y values at a time
+  const auto &kernels = getYUVConversionKernels();
+  const LineConversionParameters par(RGBConv, fullRange, format.bitsPerSample, outputBitDepth);
+  const auto convertLine = (outputBitDepth == 10) ? kernels.convertLineToRGB30 : kernels.convertLineToBGRA;
 
-  for (int x = 0; x < w; x++)
+  const int bps = format.bitsPerSample;
+  const auto readLine = kernels.getReadLineFunction(bps, format.bigEndian);
+  const int inMax = (1<<bps)-1;
+  const int subH = getSubsamplingHor(subsampling);
+  const int subV = getSubsamplingVer(subsampling);
+  const int wC = w / subH;
+  const int hC = h / subV;
+  const int bytesPerSample = (bps > 8) ? 2 : 1;
+  const int strideY = w * bytesPerSample;
+  const int strideC = wC * bytesPerSample * inValSkip;
+  const MathParameters mathYRead = (lut == nullptr) ? mathY : MathParameters();
+
+  // One line of luma and (up-sampled) chroma samples in the luma resolution
+  std::vector<int32_t> lineY(w), lineU(w), lineV(w);
+  // The current and the next line of chroma samples and one line of vertically interpolated chroma samples
+  std::vector<int32_t> chromaU[2] = {std::vector<int32_t>(wC), std::vector<int32_t>(wC)};
+  std::vector<int32_t> chromaV[2] = {std::vector<int32_t>(wC), std::vector<int32_t>(wC)};
+  std::vector<int32_t> tmpU(wC), tmpV(wC);
+  int curChromaLine = -1;
+
+  for (int y = yStart; y < yEnd; y++)
   {
-    int curUSample = getValueFromSource(srcU, x*inValSkip, bps, bigEndian);
-    int curVSample = getValueFromSource(srcV, x*inValSkip, bps, bigEndian);
-    if (applyMathChroma)
-    {
-      curUSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, curUSample, inMax);
-      curVSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, curVSample, inMax);
-    }
+    readLineOfSamples(readLine, srcY + y*strideY, lineY.data(), w, mathYRead, inMax, 1);
 
-    for (int y = 0; y < (h/2)-1; y++)
+    // Get the current and the next line of chroma samples. At the bottom, there is no next line. Just sample and hold.
+    const int yC = y / subV;
+    if (yC != curChromaLine)
     {
-      // Get the next U/V sample
-      const int srcIdxUV = y*w+x;
-      int nextUSample = getValueFromSource(srcU, srcIdxUV*inValSkip, bps, bigEndian);
-      int nextVSample = getValueFromSource(srcV, srcIdxUV*inValSkip, bps, bigEndian);
-      if (applyMathChroma)
+      const int nextLine = std::min(yC + 1, hC - 1);
+      if (subV > 1 && curChromaLine >= 0 && yC == curChromaLine + 1)
       {
-        nextUSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextUSample, inMax);
-        nextVSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextVSample, inMax);
+        std::swap(chromaU[0], chromaU[1]);
+        std::swap(chromaV[0], chromaV[1]);
       }
-
-      // From the current and the next U/V sample, interpolate the UV sample in between
-      int interpolatedU = interpolateUVSample(interpolation, curUSample, nextUSample);
-      int interpolatedV = interpolateUVSample(interpolation, curVSample, nextVSample);
-
-      // Get the 2 Y samples
-      int valY1 = getValueFromSource(srcY,     y*2*w+x, bps, bigEndian);
-      int valY2 = getValueFromSource(srcY, (y*2+1)*w+x, bps, bigEndian);
-      if (applyMathLuma)
+      else
       {
-        valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-        valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
+        readLineOfSamples(readLine, srcU + yC*strideC, chromaU[0].data(), wC, mathC, inMax, inValSkip);
+        readLineOfSamples(readLine, srcV + yC*strideC, chromaV[0].data(), wC, mathC, inMax, inValSkip);
       }
-
-      // Convert to 2 RGB values and save them
-      int valR1, valR2, valG1, valG2, valB1, valB2;
-      convertYUVToRGB8Bit(valY1, curUSample   , curVSample   , valR1, valG1, valB1, RGBConv, fullRange, bps);
-      convertYUVToRGB8Bit(valY2, interpolatedU, interpolatedV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-      const int pos1 = (y*2*w+x)*4;
-      const int pos2 = pos1 + 4*w;
-      dst[pos1  ] = valB1;
-      dst[pos1+1] = valG1;
-      dst[pos1+2] = valR1;
-      dst[pos1+3] = 255;
-      dst[pos2  ] = valB2;
-      dst[pos2+1] = valG2;
-      dst[pos2+2] = valR2;
-      dst[pos2+3] = 255;
-
-      // The next one is now the current one
-      curUSample = nextUSample;
-      curVSample = nextVSample;
+      if (subV > 1)
+      {
+        readLineOfSamples(readLine, srcU + nextLine*strideC, chromaU[1].data(), wC, mathC, inMax, inValSkip);
+        readLineOfSamples(readLine, srcV + nextLine*strideC, chromaV[1].data(), wC, mathC, inMax, inValSkip);
+      }
+      curChromaLine = yC;
     }
 
-    // For the last column, there is no next sample. Just reuse the current one again. No interpolation required either.
-
-    // Get the 2 Y samples
-    int valY1 = getValueFromSource(srcY, (h-2)*w+x, bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (h-1)*w+x, bps, bigEndian);
-    if (applyMathLuma)
+    const int32_t *lineUOut = lineU.data();
+    const int32_t *lineVOut = lineV.data();
+    const bool lineBetweenChromaLines = (y % subV != 0 && yC < hC - 1);
+    if (subsampling == Subsampling::YUV_444 || (subsampling == Subsampling::YUV_440 && !lineBetweenChromaLines))
     {
-      valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-      valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
+      lineUOut = chromaU[0].data();
+      lineVOut = chromaV[0].data();
     }
-
-    // Convert to 2 RGB values and save them
-    int valR1, valR2, valG1, valG2, valB1, valB2;
-    convertYUVToRGB8Bit(valY1, curUSample, curVSample, valR1, valG1, valB1, RGBConv, fullRange, bps);
-    convertYUVToRGB8Bit(valY2, curUSample, curVSample, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos1 = ((h-2)*w+x)*4;
-    const int pos2 = pos1 + w*4;
-    dst[pos1  ] = valB1;
-    dst[pos1+1] = valG1;
-    dst[pos1+2] = valR1;
-    dst[pos1+3] = 255;
-    dst[pos2  ] = valB2;
-    dst[pos2+1] = valG2;
-    dst[pos2+2] = valR2;
-    dst[pos2+3] = 255;
-  }
-}
-
-inline void YUVPlaneToRGB_420(const int w, const int h, const MathParameters mathY, const MathParameters mathC,
-                              const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange,const int inMax, const ChromaInterpolation interpolation, const int bps, const bool bigEndian, const int inValSkip)
-{
-  const bool applyMathLuma = mathY.mathRequired();
-  const bool applyMathChroma = mathC.mathRequired();
-  // Format is YUV 4:2:0. Horizontal and vertical up-sampling is required. Process 4 Y positions at a time
-  const int hh = h/2; // The half values
-  const int wh = w/2;
-  for (int y = 0; y < hh-1; y++)
-  {
-    // Get the current U/V samples for this y line and the next one (_NL)
-    const int srcIdxUV0 = y*wh;
-    const int srcIdxUV1 = (y+1)*wh;
-    int curU    = getValueFromSource(srcU, srcIdxUV0*inValSkip, bps, bigEndian);
-    int curV    = getValueFromSource(srcV, srcIdxUV0*inValSkip, bps, bigEndian);
-    int curU_NL = getValueFromSource(srcU, srcIdxUV1*inValSkip, bps, bigEndian);
-    int curV_NL = getValueFromSource(srcV, srcIdxUV1*inValSkip, bps, bigEndian);
-    if (applyMathChroma)
+    else if (subsampling == Subsampling::YUV_440)
     {
-      curU    = transformYUV(mathC.invert, mathC.scale, mathC.offset, curU, inMax);
-      curV    = transformYUV(mathC.invert, mathC.scale, mathC.offset, curV, inMax);
-      curU_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, curU_NL, inMax);
-      curV_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, curV_NL, inMax);
+      interpolateChromaLinesVer<interpolation>(chromaU[0].data(), chromaU[1].data(), lineU.data(), w, 2);
+      interpolateChromaLinesVer<interpolation>(chromaV[0].data(), chromaV[1].data(), lineV.data(), w, 2);
     }
-
-    for (int x = 0; x < wh-1; x++)
+    else if (subsampling == Subsampling::YUV_420 && lineBetweenChromaLines)
     {
-      // Get the next U/V sample for this line and the next one
-      const int srcIdxUVLine0 = srcIdxUV0 + x + 1;
-      const int srcIdxUVLine1 = srcIdxUV1 + x + 1;
-      int nextU    = getValueFromSource(srcU, srcIdxUVLine0*inValSkip, bps, bigEndian);
-      int nextV    = getValueFromSource(srcV, srcIdxUVLine0*inValSkip, bps, bigEndian);
-      int nextU_NL = getValueFromSource(srcU, srcIdxUVLine1*inValSkip, bps, bigEndian);
-      int nextV_NL = getValueFromSource(srcV, srcIdxUVLine1*inValSkip, bps, bigEndian);
-      if (applyMathChroma)
-      {
-        nextU    = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextU, inMax);
-        nextV    = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextV, inMax);
-        nextU_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextU_NL, inMax);
-        nextV_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextV_NL, inMax);
-      }
-
-      // From the current and the next U/V sample, interpolate the 3 UV samples in between
-      int interpolatedU_Hor = interpolateUVSample(interpolation, curU, nextU);  // Horizontal interpolation
-      int interpolatedV_Hor = interpolateUVSample(interpolation, curV, nextV);
-      int interpolatedU_Ver = interpolateUVSample(interpolation, curU, curU_NL);  // Vertical interpolation
-      int interpolatedV_Ver = interpolateUVSample(interpolation, curV, curV_NL);
-      int interpolatedU_Bi  = interpolateUVSample2D(interpolation, curU, nextU, curU_NL, nextU_NL);   // 2D interpolation
-      int interpolatedV_Bi  = interpolateUVSample2D(interpolation, curV, nextV, curV_NL, nextV_NL);   // 2D interpolation
-
-      // Get the 4 Y samples
-      int valY1 = getValueFromSource(srcY, (y*w+x)*2,   bps, bigEndian);
-      int valY2 = getValueFromSource(srcY, (y*w+x)*2+1, bps, bigEndian);
-      int valY3 = getValueFromSource(srcY, (y*2+1)*w+x*2,   bps, bigEndian);
-      int valY4 = getValueFromSource(srcY, (y*2+1)*w+x*2+1, bps, bigEndian);
-      if (applyMathLuma)
-      {
-        valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-        valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-        valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-        valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
-      }
-
-      // Convert to 4 RGB values and save them
-      int valR1, valR2, valG1, valG2, valB1, valB2;
-      convertYUVToRGB8Bit(valY1, curU             , curV             , valR1, valG1, valB1, RGBConv, fullRange, bps);
-      convertYUVToRGB8Bit(valY2, interpolatedU_Hor, interpolatedV_Hor, valR2, valG2, valB2, RGBConv, fullRange, bps);
-      const int pos1 = (y*2*w+x*2)*4;
-      dst[pos1  ] = valB1;
-      dst[pos1+1] = valG1;
-      dst[pos1+2] = valR1;
-      dst[pos1+3] = 255;
-      dst[pos1+4] = valB2;
-      dst[pos1+5] = valG2;
-      dst[pos1+6] = valR2;
-      dst[pos1+7] = 255;
-      convertYUVToRGB8Bit(valY3, interpolatedU_Ver, interpolatedV_Ver, valR1, valG1, valB1, RGBConv, fullRange, bps);  // Second line
-      convertYUVToRGB8Bit(valY4, interpolatedU_Bi , interpolatedV_Bi , valR2, valG2, valB2, RGBConv, fullRange, bps);
-      const int pos2 = pos1 + w*4;  // Next line
-      dst[pos2  ] = valB1;
-      dst[pos2+1] = valG1;
-      dst[pos2+2] = valR1;
-      dst[pos2+3] = 255;
-      dst[pos2+4] = valB2;
-      dst[pos2+5] = valG2;
-      dst[pos2+6] = valR2;
-      dst[pos2+7] = 255;
-
-      // The next one is now the current one
-      curU = nextU;
-      curV = nextV;
-      curU_NL = nextU_NL;
-      curV_NL = nextV_NL;
+      upsampleChromaLine420Between<interpolation>(chromaU[0].data(), chromaU[1].data(), lineU.data(), wC);
+      upsampleChromaLine420Between<interpolation>(chromaV[0].data(), chromaV[1].data(), lineV.data(), wC);
     }
-
-    // For the last x value (the right border), there is no next value. Just sample and hold. Only vertical interpolation is required.
-    int interpolatedU_Ver = interpolateUVSample(interpolation, curU, curU_NL);  // Vertical interpolation
-    int interpolatedV_Ver = interpolateUVSample(interpolation, curV, curV_NL);
-
-    // Get the 4 Y samples
-    int valY1 = getValueFromSource(srcY, (y*2+1)*w-2, bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (y*2+1)*w-1, bps, bigEndian);
-    int valY3 = getValueFromSource(srcY, (y*2+2)*w-2, bps, bigEndian);
-    int valY4 = getValueFromSource(srcY, (y*2+2)*w-1, bps, bigEndian);
-    if (applyMathLuma)
+    else if (subsampling == Subsampling::YUV_410)
+    {
+      // Interpolate vertically first, then horizontally
+      interpolateChromaLinesVer<interpolation>(chromaU[0].data(), chromaU[1].data(), tmpU.data(), wC, y % 4);
+      interpolateChromaLinesVer<interpolation>(chromaV[0].data(), chromaV[1].data(), tmpV.data(), wC, y % 4);
+      upsampleChromaLineHor<subH, interpolation>(tmpU.data(), lineU.data(), wC);
+      upsampleChromaLineHor<subH, interpolation>(tmpV.data(), lineV.data(), wC);
+    }
+    else
     {
-      valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-      valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-      valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-      valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
+      // 4:2:2, 4:1:1 and the 4:2:0 lines at the position of a chroma line. Only horizontal interpolation is required.
+      upsampleChromaLineHor<subH, interpolation>(chromaU[0].data(), lineU.data(), wC);
+      upsampleChromaLineHor<subH, interpolation>(chromaV[0].data(), lineV.data(), wC);
     }
 
-    // Convert to 4 RGB values and save them
-    int valR1, valR2, valG1, valG2, valB1, valB2;
-    convertYUVToRGB8Bit(valY1, curU, curV, valR1, valG1, valB1, RGBConv, fullRange, bps);
-    convertYUVToRGB8Bit(valY2, curU, curV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos1 = ((y*2+1)*w)*4;
-    dst[pos1-8] = valB1;
-    dst[pos1-7] = valG1;
-    dst[pos1-6] = valR1;
-    dst[pos1-5] = 255;
-    dst[pos1-4] = valB2;
-    dst[pos1-3] = valG2;
-    dst[pos1-2] = valR2;
-    dst[pos1-1] = 255;
-    convertYUVToRGB8Bit(valY3, interpolatedU_Ver, interpolatedV_Ver, valR1, valG1, valB1, RGBConv, fullRange, bps);  // Second line
-    convertYUVToRGB8Bit(valY4, interpolatedU_Ver, interpolatedV_Ver, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos2 = pos1 + w*4;  // Next line
-    dst[pos2-8] = valB1;
-    dst[pos2-7] = valG1;
-    dst[pos2-6] = valR1;
-    dst[pos2-5] = 255;
-    dst[pos2-4] = valB2;
-    dst[pos2-3] = valG2;
-    dst[pos2-2] = valR2;
-    dst[pos2-1] = 255;
+    if (lut)
+      convertLineToBGRAWithLUT(lineY.data(), lineUOut, lineVOut, dst + y*w*4, w, *lut);
+    else
+      convertLine(lineY.data(), lineUOut, lineVOut, dst + y*w*4, w, par);
   }
+}
 
-  // At the last Y line (the bottom line) a similar scenario occurs. There is no next Y line. Just sample and hold. Only horizontal interpolation is required.
-
-  // Get the current U/V samples for this y line
-  const int y = hh-1;  // Just process the last y line
-  const int y2 = (hh-1)*2;
+typedef void (*YUVPlaneToRGBFunction)(const yuvPixelFormat &format, const int w, const int h, const MathParameters mathY, const MathParameters mathC,
+                                      const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
+                                      unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const LineConversionLUT *lut, const int outputBitDepth,
+                                      const int inValSkip, const int yStart, const int yEnd);
 
-  // Get 2 chroma samples from this line
-  const int srcIdxUV = y*wh;
-  int curU = getValueFromSource(srcU, srcIdxUV*inValSkip, bps, bigEndian);
-  int curV = getValueFromSource(srcV, srcIdxUV*inValSkip, bps, bigEndian);
-  if (applyMathChroma)
-  {
-    curU = transformYUV(mathC.invert, mathC.scale, mathC.offset, curU, inMax);
-    curV = transformYUV(mathC.invert, mathC.scale, mathC.offset, curV, inMax);
-  }
+// The dispatch table with all specializations of YUVPlaneToRGB. The first index is the subsampling (in the order of the
+// Subsampling enum, 4:0:0 is not included). The second index is the chroma interpolation (sample and hold or bilinear).
+// Interstitial interpolation is identical to sample and hold in the conversion.
+const YUVPlaneToRGBFunction YUVPlaneToRGBFunctionTable[6][2] =
+{
+  {&YUVPlaneToRGB<Subsampling::YUV_444, ChromaInterpolation::NearestNeighbor>, &YUVPlaneToRGB<Subsampling::YUV_444, ChromaInterpolation::NearestNeighbor>},
+  {&YUVPlaneToRGB<Subsampling::YUV_422, ChromaInterpolation::NearestNeighbor>, &YUVPlaneToRGB<Subsampling::YUV_422, ChromaInterpolation::Bilinear>},
+  {&YUVPlaneToRGB<Subsampling::YUV_420, ChromaInterpolation::NearestNeighbor>, &YUVPlaneToRGB<Subsampling::YUV_420, ChromaInterpolation::Bilinear>},
+  {&YUVPlaneToRGB<Subsampling::YUV_440, ChromaInterpolation::NearestNeighbor>, &YUVPlaneToRGB<Subsampling::YUV_440, ChromaInterpolation::Bilinear>},
+  {&YUVPlaneToRGB<Subsampling::YUV_410, ChromaInterpolation::NearestNeighbor>, &YUVPlaneToRGB<Subsampling::YUV_410, ChromaInterpolation::Bilinear>},
+  {&YUVPlaneToRGB<Subsampling::YUV_411, ChromaInterpolation::NearestNeighbor>, &YUVPlaneToRGB<Subsampling::YUV_411, ChromaInterpolation::Bilinear>}
+};
+
+// Get the specialized conversion function for the given subsampling and interpolation. Returns nullptr for 4:0:0 and unknown subsamplings.
+inline YUVPlaneToRGBFunction getYUVPlaneToRGBFunction(const Subsampling subsampling, const ChromaInterpolation interpolation)
+{
+  const int subsamplingIdx = int(subsampling);
+  if (subsamplingIdx < 0 || subsamplingIdx >= 6)
+    return nullptr;
+  return YUVPlaneToRGBFunctionTable[subsamplingIdx][interpolation == ChromaInterpolation::Bilinear ? 1 : 0];
+}
 
-  for (int x = 0; x < (w/2)-1; x++)
+// The positions of the components in packed YUV data. A block of valuesPerBlock values contains one pixel (4:4:4) or two pixels (4:2:2).
+// In 4:2:2, the second luma sample is at offsetY+2.
+struct PackedComponentOffsets
+{
+  PackedComponentOffsets(const PackingOrder packing, const Subsampling subsampling)
   {
-    // Get the next U/V sample for this line and the next one
-    const int srcIdxLineUV = srcIdxUV + x + 1;
-    int nextU = getValueFromSource(srcU, srcIdxLineUV*inValSkip, bps, bigEndian);
-    int nextV = getValueFromSource(srcV, srcIdxLineUV*inValSkip, bps, bigEndian);
-    if (applyMathChroma)
+    if (subsampling == Subsampling::YUV_422)
     {
-      nextU = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextU, inMax);
-      nextV = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextV, inMax);
+      offsetY = (packing == PackingOrder::YUYV || packing == PackingOrder::YVYU) ? 0 : 1;
+      offsetU = (packing == PackingOrder::UYVY) ? 0 : (packing == PackingOrder::YUYV) ? 1 : (packing == PackingOrder::VYUY) ? 2 : 3;
+      offsetV = (packing == PackingOrder::VYUY) ? 0 : (packing == PackingOrder::YVYU) ? 1 : (packing == PackingOrder::UYVY) ? 2 : 3;
+      valuesPerBlock = 4;
     }
-
-    // From the current and the next U/V sample, interpolate the 3 UV samples in between
-    int interpolatedU_Hor = interpolateUVSample(interpolation, curU, nextU);  // Horizontal interpolation
-    int interpolatedV_Hor = interpolateUVSample(interpolation, curV, nextV);
-
-    // Get the 4 Y samples
-    int valY1 = getValueFromSource(srcY, (y*w+x)*2,      bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (y*w+x)*2+1,    bps, bigEndian);
-    int valY3 = getValueFromSource(srcY, (y2+1)*w+x*2,   bps, bigEndian);
-    int valY4 = getValueFromSource(srcY, (y2+1)*w+x*2+1, bps, bigEndian);
-    if (applyMathLuma)
+    else
     {
-      valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-      valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-      valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-      valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
+      offsetY = (packing == PackingOrder::AYUV) ? 1 : 0;
+      offsetU = (packing == PackingOrder::YUV || packing == PackingOrder::YUVA) ? 1 : 2;
+      offsetV = (packing == PackingOrder::YVU) ? 1 : (packing == PackingOrder::AYUV) ? 3 : 2;
+      valuesPerBlock = (packing == PackingOrder::YUV || packing == PackingOrder::YVU) ? 3 : 4;
     }
-
-    // Convert to 4 RGB values and save them
-    int valR1, valR2, valG1, valG2, valB1, valB2;
-    convertYUVToRGB8Bit(valY1, curU             , curV             , valR1, valG1, valB1, RGBConv, fullRange, bps);
-    convertYUVToRGB8Bit(valY2, interpolatedU_Hor, interpolatedV_Hor, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos1 = (y2*w+x*2)*4;
-    dst[pos1  ] = valB1;
-    dst[pos1+1] = valG1;
-    dst[pos1+2] = valR1;
-    dst[pos1+3] = 255;
-    dst[pos1+4] = valB2;
-    dst[pos1+5] = valG2;
-    dst[pos1+6] = valR2;
-    dst[pos1+7] = 255;
-    convertYUVToRGB8Bit(valY3, curU             , curV             , valR1, valG1, valB1, RGBConv, fullRange, bps);  // Second line
-    convertYUVToRGB8Bit(valY4, interpolatedU_Hor, interpolatedV_Hor, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos2 = pos1 + w*4;  // Next line
-    dst[pos2  ] = valB1;
-    dst[pos2+1] = valG1;
-    dst[pos2+2] = valR1;
-    dst[pos2+3] = 255;
-    dst[pos2+4] = valB2;
-    dst[pos2+5] = valG2;
-    dst[pos2+6] = valR2;
-    dst[pos2+7] = 255;
-
-    // The next one is now the current one
-    curU = nextU;
-    curV = nextV;
   }
+  int offsetY, offsetU, offsetV;
+  int valuesPerBlock;
+};
+
+// Convert packed YUV 4:4:4 or 4:2:2 data directly to RGB (BGRA) in one pass. No planar copy of the frame is created. The read kernels
+// pick the components out of the packed data (using their inValSkip), the chroma samples are up-sampled and the line is converted
+// using the same kernels (or lookup tables) as in YUVPlaneToRGB, so the result is identical to the conversion of the planar data.
+// Only the lines [yStart, yEnd) of the frame are converted.
+template<Subsampling subsampling, ChromaInterpolation interpolation>
+void YUVPackedToRGB(const yuvPixelFormat &format, const int w, const MathParameters mathY, const MathParameters mathC, const unsigned char * restrict src,
+                    unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const LineConversionLUT *lut, const int outputBitDepth,
+                    const int yStart, const int yEnd)
+{
+  const auto &kernels = getYUVConversionKernels();
+  const LineConversionParameters par(RGBConv, fullRange, format.bitsPerSample, outputBitDepth);
+  const auto convertLine = (outputBitDepth == 10) ? kernels.convertLineToRGB30 : kernels.convertLineToBGRA;
 
-  // For the last x value in the last y row (the right bottom), there is no next value in neither direction.
-  // Just sample and hold. No interpolation is required.
-
-  // Get the 4 Y samples
-  int valY1 = getValueFromSource(srcY, (y2+1)*w-2, bps, bigEndian);
-  int valY2 = getValueFromSource(srcY, (y2+1)*w-1, bps, bigEndian);
-  int valY3 = getValueFromSource(srcY, (y2+2)*w-2, bps, bigEndian);
-  int valY4 = getValueFromSource(srcY, (y2+2)*w-1, bps, bigEndian);
-  if (applyMathLuma)
+  const int bps = format.bitsPerSample;
+  const auto readLine = kernels.getReadLineFunction(bps, format.bigEndian);
+  const int inMax = (1<<bps)-1;
+  const int subH = getSubsamplingHor(subsampling);
+  const int wC = w / subH;
+  const int bytesPerSample = (bps > 8) ? 2 : 1;
+  const PackedComponentOffsets offsets(format.packingOrder, subsampling);
+  // In 4:2:2, a block contains two luma samples. In 4:4:4 one.
+  const int skipY = offsets.valuesPerBlock / subH;
+  const int skipC = offsets.valuesPerBlock;
+  const int stride = wC * offsets.valuesPerBlock * bytesPerSample;
+  const MathParameters mathYRead = (lut == nullptr) ? mathY : MathParameters();
+
+  std::vector<int32_t> lineY(w), lineU(w), lineV(w);
+  std::vector<int32_t> chromaU(wC), chromaV(wC);
+
+  for (int y = yStart; y < yEnd; y++)
   {
-    valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-    valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-    valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-    valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
-  }
-
-  // Convert to 4 RGB values and save them
-  int valR1, valR2, valG1, valG2, valB1, valB2;
-  convertYUVToRGB8Bit(valY1, curU, curV, valR1, valG1, valB1, RGBConv, fullRange, bps);
-  convertYUVToRGB8Bit(valY2, curU, curV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-  const int pos1 = (y2+1)*w*4;
-  dst[pos1-8] = valB1;
-  dst[pos1-7] = valG1;
-  dst[pos1-6] = valR1;
-  dst[pos1-5] = 255;
-  dst[pos1-4] = valB2;
-  dst[pos1-3] = valG2;
-  dst[pos1-2] = valR2;
-  dst[pos1-1] = 255;
-  convertYUVToRGB8Bit(valY3, curU, curV, valR1, valG1, valB1, RGBConv, fullRange, bps);  // Second line
-  convertYUVToRGB8Bit(valY4, curU, curV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-  const int pos2 = pos1 + w*4;  // Next line
-  dst[pos2-8] = valB1;
-  dst[pos2-7] = valG1;
-  dst[pos2-6] = valR1;
-  dst[pos2-5] = 255;
-  dst[pos2-4] = valB2;
-  dst[pos2-3] = valG2;
-  dst[pos2-2] = valR2;
-  dst[pos2-1] = 255;
-}
-
-inline void YUVPlaneToRGB_410(const int w, const int h, const MathParameters mathY, const MathParameters mathC,
-                              const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange,const int inMax, const ChromaInterpolation interpolation, const int bps, const bool bigEndian, const int inValSkip)
-{
-  const bool applyMathLuma = mathY.mathRequired();
-  const bool applyMathChroma = mathC.mathRequired();
-  // Format is YUV 4:1:0. Horizontal and vertical up-sampling is required. Process 4 Y positions of 2 lines at a time
-  // Horizontal subsampling by 4, vertical subsampling by 2
-  const int hq = h/4; // The quarter values
-  const int wq = w/4;
-
-  for (int y = 0; y < hq; y++)
-  {
-    // Get the current U/V samples for this y line and the next one (_NL)
-    const int srcIdxUV0 = y*wq;
-    const int srcIdxUV1 = (y+1)*wq;
-    int curU    = getValueFromSource(srcU, srcIdxUV0*inValSkip, bps, bigEndian);
-    int curV    = getValueFromSource(srcV, srcIdxUV0*inValSkip, bps, bigEndian);
-    int curU_NL = (y < hq-1) ? getValueFromSource(srcU, srcIdxUV1*inValSkip, bps, bigEndian) : curU;
-    int curV_NL = (y < hq-1) ? getValueFromSource(srcV, srcIdxUV1*inValSkip, bps, bigEndian) : curV;
-    if (applyMathChroma)
+    const unsigned char *srcLine = src + y*stride;
+    readLineOfSamples(readLine, srcLine + offsets.offsetY*bytesPerSample, lineY.data(), w, mathYRead, inMax, skipY);
+    if (subsampling == Subsampling::YUV_444)
     {
-      curU    = transformYUV(mathC.invert, mathC.scale, mathC.offset, curU, inMax);
-      curV    = transformYUV(mathC.invert, mathC.scale, mathC.offset, curV, inMax);
-      curU_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, curU_NL, inMax);
-      curV_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, curV_NL, inMax);
+      readLineOfSamples(readLine, srcLine + offsets.offsetU*bytesPerSample, lineU.data(), w, mathC, inMax, skipC);
+      readLineOfSamples(readLine, srcLine + offsets.offsetV*bytesPerSample, lineV.data(), w, mathC, inMax, skipC);
     }
-
-    for (int x = 0; x < wq; x++)
+    else
     {
-      // We process 4*4 values per U/V value
-
-      // Get the next U/V sample for this line and the next one
-      const int srcIdxUVLine0 = srcIdxUV0 + x + 1;
-      const int srcIdxUVLine1 = srcIdxUV1 + x + 1;
-      int nextU    = (x < wq-1) ? getValueFromSource(srcU, srcIdxUVLine0*inValSkip, bps, bigEndian) : curU;
-      int nextV    = (x < wq-1) ? getValueFromSource(srcV, srcIdxUVLine0*inValSkip, bps, bigEndian) : curV;
-      int nextU_NL = (x < wq-1) ? getValueFromSource(srcU, srcIdxUVLine1*inValSkip, bps, bigEndian) : curU_NL;
-      int nextV_NL = (x < wq-1) ? getValueFromSource(srcV, srcIdxUVLine1*inValSkip, bps, bigEndian) : curV_NL;
-      if (applyMathChroma)
-      {
-        nextU    = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextU, inMax);
-        nextV    = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextV, inMax);
-        nextU_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextU_NL, inMax);
-        nextV_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextV_NL, inMax);
-      }
-
-      // Now we interpolate and set the RGB values for the 4x4 pixels
-      for (int yo = 0; yo < 4; yo++)
-      {
-        // Interpolate vertically
-        int curU_INT = interpolateUVSampleQ(interpolation, curU, curU_NL, yo);
-        int curV_INT = interpolateUVSampleQ(interpolation, curV, curV_NL, yo);
-        int nextU_INT = interpolateUVSampleQ(interpolation, nextU, nextU_NL, yo);
-        int nextV_INT = interpolateUVSampleQ(interpolation, nextV, nextV_NL, yo);
-
-        for (int xo = 0; xo < 4; xo++)
-        {
-          // Interpolate horizontally
-          int U = interpolateUVSampleQ(interpolation, curU_INT, nextU_INT, xo);
-          int V = interpolateUVSampleQ(interpolation, curV_INT, nextV_INT, xo);
-          // Get the Y sample
-          int Y = getValueFromSource(srcY, (y*4+yo)*w+x*4+xo, bps, bigEndian);
-          if (applyMathLuma)
-            Y = transformYUV(mathY.invert, mathY.scale, mathY.offset, Y, inMax);
-
-          // Convert to RGB and save (BGRA)
-          int R, G, B;
-          const int pos = ((y*4+yo)*w+x*4+xo)*4;
-          convertYUVToRGB8Bit(Y, U, V, R, G, B, RGBConv, fullRange, bps);
-          dst[pos  ] = B;
-          dst[pos+1] = G;
-          dst[pos+2] = R;
-          dst[pos+3] = 255;
-        }
-      }
-
-      curU = nextU;
-      curV = nextV;
-      curU_NL = nextU_NL;
-      curV_NL = nextV_NL;
+      readLineOfSamples(readLine, srcLine + offsets.offsetU*bytesPerSample, chromaU.data(), wC, mathC, inMax, skipC);
+      readLineOfSamples(readLine, srcLine + offsets.offsetV*bytesPerSample, chromaV.data(), wC, mathC, inMax, skipC);
+      upsampleChromaLineHor<subH, interpolation>(chromaU.data(), lineU.data(), wC);
+      upsampleChromaLineHor<subH, interpolation>(chromaV.data(), lineV.data(), wC);
     }
+
+    if (lut)
+      convertLineToBGRAWithLUT(lineY.data(), lineU.data(), lineV.data(), dst + y*w*4, w, *lut);
+    else
+      convertLine(lineY.data(), lineU.data(), lineV.data(), dst + y*w*4, w, par);
   }
 }
 
-inline void YUVPlaneToRGB_411(const int w, const int h, const MathParameters mathY, const MathParameters mathC,
-  const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-  unsigned char * restrict dst, const int RGBConv[5], const bool fullRange,const int inMax, const ChromaInterpolation interpolation, const int bps, const bool bigEndian, const int inValSkip)
+// Downscale the output lines [yStart, yEnd) of one plane by the given factor (a power of 2) using a box filter. Every output sample
+// is the rounded average of factor x factor input samples. Input samples outside of the plane (if the input size is not a multiple
+// of the factor) are repeated from the border. inValSkip is the number of interleaved values per sample in the input.
+inline void decimatePlaneLines(const yuvConversionKernels::readLineFunction readLine, const unsigned char * restrict src, const int wIn, const int hIn,
+                               const int inValSkip, const int bps, const bool bigEndian, const int factor, unsigned char * restrict dst, const int wOut,
+                               const int yStart, const int yEnd)
 {
-  // Chroma: quarter horizontal resolution
-  const bool applyMathLuma = mathY.mathRequired();
-  const bool applyMathChroma = mathC.mathRequired();
-
-  // Horizontal up-sampling is required. Process four Y values at a time.
-  for (int y = 0; y < h; y++)
+  const int bytesPerSample = (bps > 8) ? 2 : 1;
+  const int srcLineBytes = wIn * inValSkip * bytesPerSample;
+  int shift = 0;
+  while ((1 << shift) < factor)
+    shift++;
+  const int32_t rounding = (factor * factor) / 2;
+
+  std::vector<int32_t> line(wIn);
+  std::vector<int32_t> sum(wOut);
+  for (int yOut = yStart; yOut < yEnd; yOut++)
   {
-    const int srcIdxUV = y*w/4;
-    int curUSample = getValueFromSource(srcU, srcIdxUV*inValSkip, bps, bigEndian);
-    int curVSample = getValueFromSource(srcV, srcIdxUV*inValSkip, bps, bigEndian);
-    if (applyMathChroma)
+    std::fill(sum.begin(), sum.end(), 0);
+    for (int k = 0; k < factor; k++)
     {
-      curUSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, curUSample, inMax);
-      curVSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, curVSample, inMax);
+      const int yIn = std::min(yOut * factor + k, hIn - 1);
+      readLine(src + yIn * srcLineBytes, line.data(), wIn, inValSkip);
+      for (int xIn = 0; xIn < wOut * factor; xIn++)
+        sum[xIn >> shift] += line[std::min(xIn, wIn - 1)];
     }
+    for (int xOut = 0; xOut < wOut; xOut++)
+      setValueInBuffer(dst, (sum[xOut] + rounding) >> (2 * shift), yOut * wOut + xOut, bps, bigEndian);
+  }
+}
 
-    for (int x = 0; x < (w/4)-1; x++)
-    {
-      // Get the next U/V sample
-      const int srcIdxUVLine = srcIdxUV + x + 1;
-      int nextUSample = getValueFromSource(srcU, srcIdxUVLine*inValSkip, bps, bigEndian);
-      int nextVSample = getValueFromSource(srcV, srcIdxUVLine*inValSkip, bps, bigEndian);
-      if (applyMathChroma)
-      {
-        nextUSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextUSample, inMax);
-        nextVSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextVSample, inMax);
-      }
+QSize videoHandlerYUV::decimatePlanarYUV(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &curFrameSize, yuvPixelFormat &sourceBufferFormat, const int factor)
+{
+  const auto format = sourceBufferFormat;
+  const int subH = format.getSubsamplingHor();
+  const int subV = format.getSubsamplingVer();
+  const int bps = format.bitsPerSample;
+  const int bytesPerSample = (bps > 8) ? 2 : 1;
+  const bool hasChroma = (format.subsampling != Subsampling::YUV_400);
 
-      // From the current and the next U/V sample, interpolate the UV sample in between
-      int interpolatedU1 = interpolateUVSampleQ(interpolation, curUSample, nextUSample, 1);
-      int interpolatedV1 = interpolateUVSampleQ(interpolation, curVSample, nextVSample, 1);
-      int interpolatedU2 = interpolateUVSample(interpolation, curUSample, nextUSample);
-      int interpolatedV2 = interpolateUVSample(interpolation, curVSample, nextVSample);
-      int interpolatedU3 = interpolateUVSampleQ(interpolation, curUSample, nextUSample, 3);
-      int interpolatedV3 = interpolateUVSampleQ(interpolation, curVSample, nextVSample, 3);
-
-      // Get the 4 Y samples
-      int valY1 = getValueFromSource(srcY, y*w+x*4,   bps, bigEndian);
-      int valY2 = getValueFromSource(srcY, y*w+x*4+1, bps, bigEndian);
-      int valY3 = getValueFromSource(srcY, y*w+x*4+2, bps, bigEndian);
-      int valY4 = getValueFromSource(srcY, y*w+x*4+3, bps, bigEndian);
-      if (applyMathLuma)
-      {
-        valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-        valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-        valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-        valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
-      }
+  // The size of the input planes
+  const int w = curFrameSize.width();
+  const int h = curFrameSize.height();
+  const int wC = w / subH;
+  const int hC = h / subV;
 
-      // Convert to 4 RGB values and save them
-      int valR, valG, valB;
-      const int pos = (y*w+x*4)*4;
-      convertYUVToRGB8Bit(valY1, curUSample, curVSample, valR, valG, valB, RGBConv, fullRange, bps);
-      dst[pos  ] = valB;
-      dst[pos+1] = valG;
-      dst[pos+2] = valR;
-      dst[pos+3] = 255;
-      convertYUVToRGB8Bit(valY2, interpolatedU1, interpolatedV1, valR, valG, valB, RGBConv, fullRange, bps);
-      dst[pos+4] = valB;
-      dst[pos+5] = valG;
-      dst[pos+6] = valR;
-      dst[pos+7] = 255;
-      convertYUVToRGB8Bit(valY3, interpolatedU2, interpolatedV2, valR, valG, valB, RGBConv, fullRange, bps);
-      dst[pos+8] = valB;
-      dst[pos+9] = valG;
-      dst[pos+10] = valR;
-      dst[pos+11] = 255;
-      convertYUVToRGB8Bit(valY4, interpolatedU3, interpolatedV3, valR, valG, valB, RGBConv, fullRange, bps);
-      dst[pos+12] = valB;
-      dst[pos+13] = valG;
-      dst[pos+14] = valR;
-      dst[pos+15] = 255;
-
-      // The next one is now the current one
-      curUSample = nextUSample;
-      curVSample = nextVSample;
-    }
+  // The output size is rounded up to a multiple of the subsampling. All planes are decimated by the same factor so that the
+  // subsampling and the chroma offset of the format do not change.
+  const int wOut = ((w + factor * subH - 1) / (factor * subH)) * subH;
+  const int hOut = ((h + factor * subV - 1) / (factor * subV)) * subV;
+  const int wOutC = wOut / subH;
+  const int hOutC = hOut / subV;
+
+  const int nrChromaComponents = hasChroma ? 2 : 0;
+  targetBuffer.resize((wOut * hOut + wOutC * hOutC * nrChromaComponents) * bytesPerSample);
 
-    // For the last row, there is no next sample. Just reuse the current one again. No interpolation required either.
+  // If the U and V (and A if present) components are interleaved, we have to skip every nth value in the input when reading U and V
+  const int inputValSkip = format.uvInterleaved ? ((format.planeOrder == PlaneOrder::YUV || format.planeOrder == PlaneOrder::YVU) ? 2 : 3) : 1;
+  const auto readLine = getYUVConversionKernels().getReadLineFunction(bps, format.bigEndian);
 
-    // Get the 2 Y samples
-    int valY1 = getValueFromSource(srcY, (y+1)*w-4, bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (y+1)*w-3, bps, bigEndian);
-    int valY3 = getValueFromSource(srcY, (y+1)*w-2, bps, bigEndian);
-    int valY4 = getValueFromSource(srcY, (y+1)*w-1, bps, bigEndian);
-    if (applyMathLuma)
+  const unsigned char *srcY = (const unsigned char*)sourceBuffer.constData();
+  const unsigned char *srcC = srcY + w * h * bytesPerSample;
+  unsigned char *dstY = (unsigned char*)targetBuffer.data();
+  unsigned char *dstC = dstY + wOut * hOut * bytesPerSample;
+
+  videoHandler::convertInBands(hOut, subV, [&](int yStart, int yEnd)
+  {
+    decimatePlaneLines(readLine, srcY, w, h, 1, bps, format.bigEndian, factor, dstY, wOut, yStart, yEnd);
+    for (int c = 0; c < nrChromaComponents; c++)
     {
-      valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-      valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-      valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-      valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
+      // The chroma components are either interleaved in one plane or in two consecutive planes (in the order of the planeOrder).
+      const unsigned char *srcPlane = format.uvInterleaved ? srcC + c * bytesPerSample : srcC + c * wC * hC * bytesPerSample;
+      unsigned char *dstPlane = dstC + c * wOutC * hOutC * bytesPerSample;
+      decimatePlaneLines(readLine, srcPlane, wC, hC, inputValSkip, bps, format.bigEndian, factor, dstPlane, wOutC, yStart / subV, yEnd / subV);
     }
+  });
 
-    // Convert to 4 RGB values and save them
-    int valR, valG, valB;
-    const int pos = ((y+1)*w)*4;
-    convertYUVToRGB8Bit(valY1, curUSample, curVSample, valR, valG, valB, RGBConv, fullRange, bps);
-    dst[pos-16] = valB;
-    dst[pos-15] = valG;
-    dst[pos-14] = valR;
-    dst[pos-13] = 255;
-    convertYUVToRGB8Bit(valY2, curUSample, curVSample, valR, valG, valB, RGBConv, fullRange, bps);
-    dst[pos-12] = valB;
-    dst[pos-11] = valG;
-    dst[pos-10] = valR;
-    dst[pos-9] = 255;
-    convertYUVToRGB8Bit(valY3, curUSample, curVSample, valR, valG, valB, RGBConv, fullRange, bps);
-    dst[pos-8] = valB;
-    dst[pos-7] = valG;
-    dst[pos-6] = valR;
-    dst[pos-5] = 255;
-    convertYUVToRGB8Bit(valY4, curUSample, curVSample, valR, valG, valB, RGBConv, fullRange, bps);
-    dst[pos-4] = valB;
-    dst[pos-3] = valG;
-    dst[pos-2] = valR;
-    dst[pos-1] = 255;
-  }
+  // The output buffer is planar (not interleaved) with the same subsampling. The alpha plane is not needed for the conversion.
+  sourceBufferFormat.uvInterleaved = false;
+  if (format.planeOrder == PlaneOrder::YUVA)
+    sourceBufferFormat.planeOrder = PlaneOrder::YUV;
+  else if (format.planeOrder == PlaneOrder::YVUA)
+    sourceBufferFormat.planeOrder = PlaneOrder::YVU;
+
+  return QSize(wOut, hOut);
 }
 
 bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &curFrameSize, yuvPixelFormat &sourceBufferFormat)
@@ -2189,9 +1809,10 @@ bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, Q
     const int nr4Samples = w*h/2;
 
     // What are the offsets withing the 4 samples for the components?
-    const int oY = (packing == PackingOrder::YUYV || packing == PackingOrder::YVYU) ? 0 : 1;
-    const int oU = (packing == PackingOrder::UYVY) ? 0 : (packing == PackingOrder::YUYV) ? 1 : (packing == PackingOrder::VYUY) ? 2 : 3;
-    const int oV = (packing == PackingOrder::VYUY) ? 0 : (packing == PackingOrder::YVYU) ? 1 : (packing == PackingOrder::UYVY) ? 2 : 3;
+    const PackedComponentOffsets offsets(packing, format.subsampling);
+    const int oY = offsets.offsetY;
+    const int oU = offsets.offsetU;
+    const int oV = offsets.offsetV;
 
     if (bps == 1)
     {
@@ -2231,12 +1852,13 @@ bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, Q
   else if (format.subsampling == Subsampling::YUV_444)
   {
     // What are the offsets withing the 3 or 4 bytes per sample?
-    const int oY = (packing == PackingOrder::AYUV) ? 1 : 0;
-    const int oU = (packing == PackingOrder::YUV || packing == PackingOrder::YUVA) ? 1 : 2;
-    const int oV = (packing == PackingOrder::YVU) ? 1 : (packing == PackingOrder::AYUV) ? 3 : 2;
+    const PackedComponentOffsets offsets(packing, format.subsampling);
+    const int oY = offsets.offsetY;
+    const int oU = offsets.offsetU;
+    const int oV = offsets.offsetV;
 
     // How many samples to the next sample?
-    const int offsetNext = (packing == PackingOrder::YUV || packing == PackingOrder::YVU ? 3 : 4);
+    const int offsetNext = offsets.valuesPerBlock;
 
     if (bps == 1)
     {
@@ -2281,7 +1903,87 @@ bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, Q
   return true;
 }
 
-bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, uchar *targetBuffer, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat) const
+bool videoHandlerYUV::useHighBitDepthOutput(const yuvPixelFormat &format) const
+{
+  // Single components are shown as gray images. There is no benefit from more than 8 bit there.
+  return videoHandler::isHighBitDepthOutputEnabled() && format.bitsPerSample > 8 && componentDisplayMode == DisplayAll &&
+         format.subsampling != Subsampling::YUV_400;
+}
+
+QImage::Format videoHandlerYUV::getOutputImageFormat() const
+{
+  if (useHighBitDepthOutput(srcPixelFormat))
+    return QImage::Format_RGB30;
+  return videoHandler::getOutputImageFormat();
+}
+
+bool videoHandlerYUV::canConvertYUVPackedToRGB(const yuvPixelFormat &format) const
+{
+  // The single pass conversion supports packed 4:4:4 and 4:2:2 if all components are displayed and there is no chroma offset.
+  // All other cases are converted to planar first.
+  return !format.planar && !format.bytePacking && componentDisplayMode == DisplayAll &&
+         (format.subsampling == Subsampling::YUV_444 || format.subsampling == Subsampling::YUV_422) &&
+         format.chromaOffset[0] == 0 && format.chromaOffset[1] == 0;
+}
+
+bool videoHandlerYUV::convertYUVPackedToRGB(const QByteArray &sourceBuffer, uchar *targetBuffer, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat, int outputBitDepth) const
+{
+  const auto format = sourceBufferFormat;
+  if (!canConvertYUVPackedToRGB(format))
+    return false;
+
+  const auto w = curFrameSize.width();
+  const auto h = curFrameSize.height();
+  const auto mathY = mathParameters[Component::Luma];
+  const auto mathC = mathParameters[Component::Chroma];
+  const auto conversion = yuvColorConversionType;
+  const bool fullRange = (conversion == ColorConversion::BT709_FullRange || conversion == ColorConversion::BT601_FullRange || conversion == ColorConversion::BT2020_FullRange);
+  const bool bilinear = (chromaInterpolation == ChromaInterpolation::Bilinear);
+
+  int RGBConv[5];
+  getColorConversionCoefficients(yuvColorConversionType, RGBConv);
+  const auto lut = getConversionLUT(RGBConv, fullRange, format.bitsPerSample, mathY, outputBitDepth);
+
+  // Select the specialization once. 4:4:4 does not need any chroma interpolation.
+  typedef void (*YUVPackedToRGBFunction)(const yuvPixelFormat &format, const int w, const MathParameters mathY, const MathParameters mathC, const unsigned char * restrict src,
+                                         unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const LineConversionLUT *lut, const int outputBitDepth,
+                                         const int yStart, const int yEnd);
+  YUVPackedToRGBFunction convertPacked = &YUVPackedToRGB<Subsampling::YUV_444, ChromaInterpolation::NearestNeighbor>;
+  if (format.subsampling == Subsampling::YUV_422)
+    convertPacked = bilinear ? &YUVPackedToRGB<Subsampling::YUV_422, ChromaInterpolation::Bilinear> : &YUVPackedToRGB<Subsampling::YUV_422, ChromaInterpolation::NearestNeighbor>;
+
+  const unsigned char * restrict src = (const unsigned char*)sourceBuffer.constData();
+  videoHandler::convertInBands(h, 1, [&](int yStart, int yEnd)
+  {
+    convertPacked(format, w, mathY, mathC, src, targetBuffer, RGBConv, fullRange, lut.get(), outputBitDepth, yStart, yEnd);
+  });
+  return true;
+}
+
+QByteArray videoHandlerYUV::takeScratchBuffer(int size)
+{
+  QByteArray buffer;
+  {
+    QMutexLocker lock(&scratchBufferMutex);
+    if (!scratchBuffers.isEmpty())
+      buffer = scratchBuffers.takeLast();
+  }
+  // Shrinking the buffer keeps the allocated memory. Resizing to 0 would free it.
+  if (size > 0)
+    buffer.resize(size);
+  return buffer;
+}
+
+void videoHandlerYUV::returnScratchBuffer(QByteArray &buffer)
+{
+  QMutexLocker lock(&scratchBufferMutex);
+  // Keep one buffer for every thread that may convert at the same time (the caching threads and the main thread)
+  if (scratchBuffers.size() < QThread::idealThreadCount() + 1)
+    scratchBuffers.append(buffer);
+  buffer = QByteArray();
+}
+
+bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, uchar *targetBuffer, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat, int outputBitDepth) const
 {
   // These are constant for the runtime of this function. This way, the compiler can optimize the
   // hell out of this function.
@@ -2365,6 +2067,11 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
   }
   else
   {
+    // Get the specialized conversion function for the subsampling and interpolation
+    const auto convertPlanes = getYUVPlaneToRGBFunction(format.subsampling, interpolation);
+    if (convertPlanes == nullptr)
+      return false;
+
     // Is the U plane the first or the second?
     const bool uPlaneFirst = (format.planeOrder == PlaneOrder::YUV || format.planeOrder == PlaneOrder::YUVA);
 
@@ -2376,6 +2083,7 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
     // Get/set the parameters used for YUV -> RGB conversion
     int RGBConv[5];
     getColorConversionCoefficients(yuvColorConversionType, RGBConv);
+    const auto lut = getConversionLUT(RGBConv, fullRange, bps, mathY, outputBitDepth);
 
     // We are displaying all components, so we have to perform conversion to RGB (possibly including interpolation and YUV math)
     if (format.subsampling != Subsampling::YUV_400 && (format.chromaOffset[0] != 0 || format.chromaOffset[1] != 0))
@@ -2395,20 +2103,10 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
       unsigned char * restrict srcV = uPlaneFirst ? srcY + nrBytesLumaPlane + nrBytesToNextChromaPlane: srcY + nrBytesLumaPlane;
       UVPlaneResamplingChromaOffset(format, w / format.getSubsamplingHor(), h / format.getSubsamplingVer(), srcU, srcV, inputValSkip, dstU, dstV);
 
-      if (format.subsampling == Subsampling::YUV_444)
-        YUVPlaneToRGB_444(componentSizeLuma, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, bps, format.bigEndian, 1);
-      else if (format.subsampling == Subsampling::YUV_422)
-        YUVPlaneToRGB_422(w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, 1);
-      else if (format.subsampling == Subsampling::YUV_420)
-        YUVPlaneToRGB_420(w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, 1);
-      else if (format.subsampling == Subsampling::YUV_440)
-        YUVPlaneToRGB_440(w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, 1);
-      else if (format.subsampling == Subsampling::YUV_410)
-        YUVPlaneToRGB_410(w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, 1);
-      else if (format.subsampling == Subsampling::YUV_411)
-        YUVPlaneToRGB_411(w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, 1);
-      else
-        return false;
+      videoHandler::convertInBands(h, format.getSubsamplingVer(), [&](int yStart, int yEnd)
+      {
+        convertPlanes(format, w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, lut.get(), outputBitDepth, 1, yStart, yEnd);
+      });
     }
     else
     {
@@ -2417,22 +2115,10 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
       const unsigned char * restrict srcU = uPlaneFirst ? srcY + nrBytesLumaPlane : srcY + nrBytesLumaPlane + nrBytesToNextChromaPlane;
       const unsigned char * restrict srcV = uPlaneFirst ? srcY + nrBytesLumaPlane + nrBytesToNextChromaPlane: srcY + nrBytesLumaPlane;
 
-      if (format.subsampling == Subsampling::YUV_444)
-        YUVPlaneToRGB_444(componentSizeLuma, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, bps, format.bigEndian, inputValSkip);
-      else if (format.subsampling == Subsampling::YUV_422)
-        YUVPlaneToRGB_422(w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, inputValSkip);
-      else if (format.subsampling == Subsampling::YUV_420)
-        YUVPlaneToRGB_420(w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, inputValSkip);
-      else if (format.subsampling == Subsampling::YUV_440)
-        YUVPlaneToRGB_440(w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, inputValSkip);
-      else if (format.subsampling == Subsampling::YUV_410)
-        YUVPlaneToRGB_410(w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, inputValSkip);
-      else if (format.subsampling == Subsampling::YUV_411)
-        YUVPlaneToRGB_411(w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, inputValSkip);
-      else if (format.subsampling == Subsampling::YUV_400)
-        YUVPlaneToRGBMonochrome_444(componentSizeLuma, mathY, srcY, dst, fullRange, inputMax, bps, format.bigEndian, 1);
-      else
-        return false;
+      videoHandler::convertInBands(h, format.getSubsamplingVer(), [&](int yStart, int yEnd)
+      {
+        convertPlanes(format, w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, lut.get(), outputBitDepth, inputValSkip, yStart, yEnd);
+      });
     }
   }
 
@@ -2441,7 +2127,7 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
 
 // Convert the given raw YUV data in sourceBuffer (using srcPixelFormat) to image (RGB-888), using the
 // buffer tmpRGBBuffer for intermediate RGB values.
-void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const yuvPixelFormat &yuvFormat, const QSize &curFrameSize)
+void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const yuvPixelFormat &yuvFormat, const QSize &curFrameSize, int decimation)
 {
   if (!yuvFormat.canConvertToRGB(curFrameSize))
   {
@@ -2449,21 +2135,56 @@ void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &
     return;
   }
 
+  // Do not decimate small frames too much. The image must still have a few samples per line and column.
+  while (decimation > 1 && (curFrameSize.width() < decimation * 16 || curFrameSize.height() < decimation * 16))
+    decimation /= 2;
+  if (decimation > 1)
+  {
+    // Downscale the YUV data first and convert only the downscaled frame. A full resolution RGB image is never created.
+    DEBUG_YUV("videoHandlerYUV::convertYUVToImage decimation " << decimation);
+    yuvPixelFormat bufferPixelFormat = yuvFormat;
+    QByteArray tmpPlanarYUVSource;
+    if (!yuvFormat.planar)
+    {
+      tmpPlanarYUVSource = takeScratchBuffer(sourceBuffer.size());
+      if (!convertYUVPackedToPlanar(sourceBuffer, tmpPlanarYUVSource, curFrameSize, bufferPixelFormat))
+      {
+        returnScratchBuffer(tmpPlanarYUVSource);
+        outputImage = QImage();
+        return;
+      }
+    }
+    QByteArray tmpDecimatedYUVSource = takeScratchBuffer(0);
+    const QSize decimatedSize = decimatePlanarYUV(yuvFormat.planar ? sourceBuffer : tmpPlanarYUVSource, tmpDecimatedYUVSource, curFrameSize, bufferPixelFormat, decimation);
+    convertYUVToImage(tmpDecimatedYUVSource, outputImage, bufferPixelFormat, decimatedSize);
+    returnScratchBuffer(tmpDecimatedYUVSource);
+    if (!yuvFormat.planar)
+      returnScratchBuffer(tmpPlanarYUVSource);
+    return;
+  }
+
   DEBUG_YUV("videoHandlerYUV::convertYUVToImage");
 
   // Create the output image in the right format.
   // In both cases, we will set the alpha channel to 255. The format of the raw buffer is: BGRA (each 8 bit).
+  // For high bit depth sources the output can also be RGB30 (2 bit alpha, 10 bit per color), which also uses 32 bit per pixel.
   // Internally, this is how QImage allocates the number of bytes per line (with depth = 32):
   // const int bytes_per_line = ((width * depth + 31) >> 5) << 2; // bytes per scanline (must be multiple of 4)
-  if (is_Q_OS_WIN || is_Q_OS_MAC)
-    outputImage = QImage(curFrameSize, functions::platformImageFormat());
+  const bool highBitDepthOutput = useHighBitDepthOutput(yuvFormat);
+  // The image is taken from the frame buffer pool (the images of frames that were removed from the cache are reused).
+  const int outputBitDepth = highBitDepthOutput ? 10 : 8;
+  auto &pool = frameBufferPool::instance();
+  if (highBitDepthOutput)
+    outputImage = pool.getImage(curFrameSize, QImage::Format_RGB30);
+  else if (is_Q_OS_WIN || is_Q_OS_MAC)
+    outputImage = pool.getImage(curFrameSize, functions::platformImageFormat());
   else if (is_Q_OS_LINUX)
   {
     QImage::Format f = functions::platformImageFormat();
     if (f == QImage::Format_ARGB32_Premultiplied || f == QImage::Format_ARGB32)
-      outputImage = QImage(curFrameSize, f);
+      outputImage = pool.getImage(curFrameSize, f);
     else
-      outputImage = QImage(curFrameSize, QImage::Format_RGB32);
+      outputImage = pool.getImage(curFrameSize, QImage::Format_RGB32);
   }
 
   // Check the image buffer size before we write to it
@@ -2481,23 +2202,27 @@ void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &
       // We can use a specialized function for this.
       convOK = convertYUV420ToRGB(sourceBuffer, outputImage.bits(), curFrameSize, yuvFormat);
     else
-      convOK = convertYUVPlanarToRGB(sourceBuffer, outputImage.bits(), curFrameSize, yuvFormat);
+      convOK = convertYUVPlanarToRGB(sourceBuffer, outputImage.bits(), curFrameSize, yuvFormat, outputBitDepth);
   }
+  else if (canConvertYUVPackedToRGB(yuvFormat))
+    // Convert the packed data to RGB in one pass
+    convOK = convertYUVPackedToRGB(sourceBuffer, outputImage.bits(), curFrameSize, yuvFormat, outputBitDepth);
   else
   {
-    // Convert to a planar format first
-    QByteArray tmpPlanarYUVSource;
+    // Convert to a planar format first (in a pooled scratch buffer)
+    QByteArray tmpPlanarYUVSource = takeScratchBuffer(sourceBuffer.size());
     // This is the current format of the buffer. The conversion function will change this.
     yuvPixelFormat bufferPixelFormat = yuvFormat;
     convOK &= convertYUVPackedToPlanar(sourceBuffer, tmpPlanarYUVSource, curFrameSize, bufferPixelFormat);
 
     if (convOK)
-      convOK &= convertYUVPlanarToRGB(tmpPlanarYUVSource, outputImage.bits(), curFrameSize, bufferPixelFormat);
+      convOK &= convertYUVPlanarToRGB(tmpPlanarYUVSource, outputImage.bits(), curFrameSize, bufferPixelFormat, outputBitDepth);
+    returnScratchBuffer(tmpPlanarYUVSource);
   }
 
   assert(convOK);
 
-  if (is_Q_OS_LINUX)
+  if (is_Q_OS_LINUX && !highBitDepthOutput)
   {
     // On linux, we may have to convert the image to the platform image format if it is not one of the
     // RGBA formats.
@@ -2560,42 +2285,22 @@ videoHandlerYUV::yuv_t videoHandlerYUV::getPixelValue(const QPoint &pixelPos) co
       }
     }
   }
-  else
+  else if (format.subsampling == Subsampling::YUV_422 || format.subsampling == Subsampling::YUV_444)
   {
-    const auto packing = format.packingOrder;
-    if (format.subsampling == Subsampling::YUV_422)
-    {
-      // The data is arranged in blocks of 4 samples. How many of these are there?
-      // What are the offsets withing the 4 samples for the components?
-      const int oY = (packing == PackingOrder::YUYV || packing == PackingOrder::YVYU) ? 0 : 1;
-      const int oU = (packing == PackingOrder::UYVY) ? 0 : (packing == PackingOrder::YUYV) ? 1 : (packing == PackingOrder::VYUY) ? 2 : 3;
-      const int oV = (packing == PackingOrder::VYUY) ? 0 : (packing == PackingOrder::YVYU) ? 1 : (packing == PackingOrder::UYVY) ? 2 : 3;
-
-      // The offset of the pixel in bytes
-      const unsigned int offsetCoordinate4Block = (w * 2 * pixelPos.y() + (pixelPos.x() / 2 * 4)) * (format.bitsPerSample > 8 ? 2 : 1);
-      const unsigned char * restrict src = (unsigned char*)currentFrameRawData.data() + offsetCoordinate4Block;
-
-      value.Y = getValueFromSource(src, (pixelPos.x() % 2 == 0) ? oY : oY + 2,  format.bitsPerSample, format.bigEndian);
-      value.U = getValueFromSource(src, oU, format.bitsPerSample, format.bigEndian);
-      value.V = getValueFromSource(src, oV, format.bitsPerSample, format.bigEndian);
-    }
-    else if (format.subsampling == Subsampling::YUV_444)
-    {
-      // The samples are packed in 4:4:4.
-      // What are the offsets withing the 3 or 4 bytes per sample?
-      const int oY = (packing == PackingOrder::AYUV) ? 1 : 0;
-      const int oU = (packing == PackingOrder::YUV || packing == PackingOrder::YUVA) ? 1 : 2;
-      const int oV = (packing == PackingOrder::YVU) ? 1 : (packing == PackingOrder::AYUV) ? 3 : 2;
-
-      // How many bytes to the next sample?
-      const int offsetNext = (packing == PackingOrder::YUV || packing == PackingOrder::YVU ? 3 : 4) * (format.bitsPerSample > 8 ? 2 : 1);
-      const int offsetSrc = (w * pixelPos.y() + pixelPos.x()) * offsetNext;
-      const unsigned char * restrict src = (unsigned char*)currentFrameRawData.data() + offsetSrc;
-
-      value.Y = getValueFromSource(src, oY, format.bitsPerSample, format.bigEndian);
-      value.U = getValueFromSource(src, oU, format.bitsPerSample, format.bigEndian);
-      value.V = getValueFromSource(src, oV, format.bitsPerSample, format.bigEndian);
-    }
+    // The data is arranged in blocks of 4 samples (4:2:2, two pixels) or 3 or 4 samples (4:4:4, one pixel)
+    const PackedComponentOffsets offsets(format.packingOrder, format.subsampling);
+    const int pixelsPerBlock = (format.subsampling == Subsampling::YUV_422) ? 2 : 1;
+    const int bytesPerSample = (format.bitsPerSample > 8) ? 2 : 1;
+
+    // The offset of the block in bytes
+    const int offsetBlock = (w * pixelPos.y() * offsets.valuesPerBlock / pixelsPerBlock + pixelPos.x() / pixelsPerBlock * offsets.valuesPerBlock) * bytesPerSample;
+    const unsigned char * restrict src = (unsigned char*)currentFrameRawData.data() + offsetBlock;
+
+    // In 4:2:2, the second luma sample of the block is at offsetY+2
+    const int offsetY = (pixelPos.x() % pixelsPerBlock == 0) ? offsets.offsetY : offsets.offsetY + 2;
+    value.Y = getValueFromSource(src, offsetY, format.bitsPerSample, format.bigEndian);
+    value.U = getValueFromSource(src, offsets.offsetU, format.bitsPerSample, format.bigEndian);
+    value.V = getValueFromSource(src, offsets.offsetV, format.bitsPerSample, format.bigEndian);
   }
   
   return value;
@@ -2604,11 +2309,7 @@ videoHandlerYUV::yuv_t videoHandlerYUV::getPixelValue(const QPoint &pixelPos) co
 // This is a specialized function that can convert 8-bit YUV 4:2:0 to RGB888 using NearestNeighborInterpolation.
 // The chroma must be 0 in x direction and 1 in y direction. No yuvMath is supported.
 // TODO: Correct the chroma subsampling offset.
-#if SSE_CONVERSION
-bool videoHandlerYUV::convertYUV420ToRGB(const byteArrayAligned &sourceBuffer, byteArrayAligned &targetBuffer)
-#else
 bool videoHandlerYUV::convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const yuvPixelFormat format)
-#endif
 {
   const int frameWidth = size.width();
   const int frameHeight = size.height();
@@ -2620,118 +2321,11 @@ bool videoHandlerYUV::convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigne
   int componentLengthUV = componentLenghtY >> 2;
   Q_ASSERT(sourceBuffer.size() >= componentLenghtY + componentLengthUV + componentLengthUV); // YUV 420 must be (at least) 1.5*Y-area
 
-#if SSE_CONVERSION_420_ALT
-  quint8 *srcYRaw = (quint8*) sourceBuffer.data();
-  quint8 *srcURaw = srcYRaw + componentLenghtY;
-  quint8 *srcVRaw = srcURaw + componentLengthUV;
-
-  quint8 *dstBuffer = (quint8*)targetBuffer.data();
-  quint32 dstBufferStride = frameWidth*4;
-
-  yuv420_to_argb8888(srcYRaw,srcURaw,srcVRaw,frameWidth,frameWidth>>1,frameWidth,frameHeight,dstBuffer,dstBufferStride);
-  return false;
-#endif
-
-#if SSE_CONVERSION
-  // Try to use SSE. If this fails use conventional algorithm
-
-  if (frameWidth % 32 == 0 && frameHeight % 2 == 0)
-  {
-    // We can use 16byte aligned read/write operations
-
-    quint8 *srcY = (quint8*) sourceBuffer.data();
-    quint8 *srcU = srcY + componentLenghtY;
-    quint8 *srcV = srcU + componentLengthUV;
-
-    __m128i yMult  = _mm_set_epi16(75, 75, 75, 75, 75, 75, 75, 75);
-    __m128i ySub   = _mm_set_epi16(16, 16, 16, 16, 16, 16, 16, 16);
-    __m128i ugMult = _mm_set_epi16(25, 25, 25, 25, 25, 25, 25, 25);
-    //__m128i sub16  = _mm_set_epi8(16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16);
-    __m128i sub128 = _mm_set_epi8(128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128);
-
-    //__m128i test = _mm_set_epi8(128, 0, 1, 2, 3, 245, 254, 255, 128, 128, 128, 128, 128, 128, 128, 128);
-
-    __m128i y, u, v, uMult, vMult;
-    __m128i RGBOut0, RGBOut1, RGBOut2;
-    __m128i tmp;
-
-    for (int yh=0; yh < frameHeight / 2; yh++)
-    {
-      for (int x=0; x < frameWidth / 32; x+=32)
-      {
-        // Load 16 bytes U/V
-        u  = _mm_load_si128((__m128i *) &srcU[x / 2]);
-        v  = _mm_load_si128((__m128i *) &srcV[x / 2]);
-        // Subtract 128 from each U/V value (16 values)
-        u = _mm_sub_epi8(u, sub128);
-        v = _mm_sub_epi8(v, sub128);
-
-        // Load 16 bytes Y from this line and the next one
-        y = _mm_load_si128((__m128i *) &srcY[x]);
-
-        // Get the lower 8 (8bit signed) Y values and put them into a 16bit register
-        tmp = _mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8);
-        // Subtract 16 and multiply by 75
-        tmp = _mm_sub_epi16(tmp, ySub);
-        tmp = _mm_mullo_epi16(tmp, yMult);
-
-        // Now to add them to the 16 bit RGB output values
-        RGBOut0 = _mm_shuffle_epi32(tmp, _MM_SHUFFLE(1, 0, 1, 0));
-        RGBOut0 = _mm_shufflelo_epi16(RGBOut0, _MM_SHUFFLE(1, 0, 0, 0));
-        RGBOut0 = _mm_shufflehi_epi16(RGBOut0, _MM_SHUFFLE(2, 2, 1, 1));
-
-        RGBOut1 = _mm_shuffle_epi32(tmp, _MM_SHUFFLE(2, 1, 2, 1));
-        RGBOut1 = _mm_shufflelo_epi16(RGBOut1, _MM_SHUFFLE(1, 1, 1, 0));
-        RGBOut1 = _mm_shufflehi_epi16(RGBOut1, _MM_SHUFFLE(3, 2, 2, 2));
-
-        RGBOut2 = _mm_shuffle_epi32(tmp, _MM_SHUFFLE(3, 2, 3, 2));
-        RGBOut2 = _mm_shufflelo_epi16(RGBOut2, _MM_SHUFFLE(2, 2, 1, 1));
-        RGBOut2 = _mm_shufflehi_epi16(RGBOut2, _MM_SHUFFLE(3, 3, 3, 2));
-
-        //y2 = _mm_load_si128((__m128i *) &srcY[x + 16]);
-
-        // --- Start with the left 8 values from U/V
-
-        // Get the lower 8 (8bit signed) U/V values and put them into a 16bit register
-        uMult = _mm_srai_epi16(_mm_unpacklo_epi8(u, u), 8);
-        vMult = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
-
-        // Multiply
-
-
-        /*y3 = _mm_load_si128((__m128i *) &srcY[x + frameWidth]);
-        y4 = _mm_load_si128((__m128i *) &srcY[x + frameWidth + 16]);*/
-      }
-    }
-
-    return true;
-  }
-#endif
-
-  // Perform software based 420 to RGB conversion
-  static unsigned char clp_buf[384+256+384];
-  static unsigned char *clip_buf = clp_buf+384;
-  static bool clp_buf_initialized = false;
-
-  if (!clp_buf_initialized)
-  {
-    // Initialize clipping table. Because of the static bool, this will only be called once.
-    memset(clp_buf, 0, 384);
-    int i;
-    for (i = 0; i < 256; i++)
-      clp_buf[384+i] = i;
-    memset(clp_buf+384+256, 255, 384);
-    clp_buf_initialized = true;
-  }
-
-  unsigned char * restrict dst = targetBuffer;
-
   // Get/set the parameters used for YUV -> RGB conversion
   const bool fullRange = (yuvColorConversionType == ColorConversion::BT709_FullRange || yuvColorConversionType == ColorConversion::BT601_FullRange || yuvColorConversionType == ColorConversion::BT2020_FullRange);
-  const int yOffset = (fullRange ? 0 : 16);
-  const int cZero = 128;
   int RGBConv[5];
   getColorConversionCoefficients(yuvColorConversionType, RGBConv);
+  const auto lut = getConversionLUT(RGBConv, fullRange, format.bitsPerSample, MathParameters());
   
   // Get pointers to the source and the output array
   const bool uPplaneFirst = (format.planeOrder == PlaneOrder::YUV || format.planeOrder == PlaneOrder::YUVA); // Is the U plane the first or the second?
@@ -2739,87 +2333,27 @@ bool videoHandlerYUV::convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigne
   const unsigned char * restrict srcU = uPplaneFirst ? srcY + componentLenghtY : srcY + componentLenghtY + componentLengthUV;
   const unsigned char * restrict srcV = uPplaneFirst ? srcY + componentLenghtY + componentLengthUV : srcY + componentLenghtY;
 
-  int yh;
-  for (yh=0; yh < frameHeight / 2; yh++)
+  // Without chroma offset resampling and interpolation, this is a plain line by line conversion using the SIMD kernels (in parallel bands)
+  videoHandler::convertInBands(frameHeight, 2, [&](int yStart, int yEnd)
   {
-    // Process two lines at once, always 4 RGB values at a time (they have the same U/V components)
-
-    int dstAddr1 = yh * 2 * frameWidth * 4;         // The RGB output address of line yh*2
-    int dstAddr2 = (yh * 2 + 1) * frameWidth * 4;   // The RGB output address of line yh*2+1
-    int srcAddrY1 = yh * 2 * frameWidth;            // The Y source address of line yh*2
-    int srcAddrY2 = (yh * 2 + 1) * frameWidth;      // The Y source address of line yh*2+1
-    int srcAddrUV = yh * frameWidth / 2;            // The UV source address of both lines (UV are identical)
-
-    for (int xh=0, x=0; xh < frameWidth / 2; xh++, x+=2)
-    {
-      // Process four pixels (the ones for which U/V are valid
-
-      // Load UV and pre-multiply
-      const int U_tmp_G = ((int)srcU[srcAddrUV + xh] - cZero) * RGBConv[2];
-      const int U_tmp_B = ((int)srcU[srcAddrUV + xh] - cZero) * RGBConv[4];
-      const int V_tmp_R = ((int)srcV[srcAddrUV + xh] - cZero) * RGBConv[1];
-      const int V_tmp_G = ((int)srcV[srcAddrUV + xh] - cZero) * RGBConv[3];
-
-      // Pixel top left
-      {
-        const int Y_tmp = ((int)srcY[srcAddrY1 + x] - yOffset) * RGBConv[0];
-
-        const int R_tmp = (Y_tmp           + V_tmp_R) >> 16;
-        const int G_tmp = (Y_tmp + U_tmp_G + V_tmp_G) >> 16;
-        const int B_tmp = (Y_tmp + U_tmp_B          ) >> 16;
-
-        dst[dstAddr1]   = clip_buf[B_tmp];
-        dst[dstAddr1+1] = clip_buf[G_tmp];
-        dst[dstAddr1+2] = clip_buf[R_tmp];
-        dst[dstAddr1+3] = 255;
-        dstAddr1 += 4;
-      }
-      // Pixel top right
-      {
-        const int Y_tmp = ((int)srcY[srcAddrY1 + x + 1] - yOffset) * RGBConv[0];
-
-        const int R_tmp = (Y_tmp           + V_tmp_R) >> 16;
-        const int G_tmp = (Y_tmp + U_tmp_G + V_tmp_G) >> 16;
-        const int B_tmp = (Y_tmp + U_tmp_B          ) >> 16;
-
-        dst[dstAddr1]   = clip_buf[B_tmp];
-        dst[dstAddr1+1] = clip_buf[G_tmp];
-        dst[dstAddr1+2] = clip_buf[R_tmp];
-        dst[dstAddr1+3] = 255;
-        dstAddr1 += 4;
-      }
-      // Pixel bottom left
-      {
-        const int Y_tmp = ((int)srcY[srcAddrY2 + x] - yOffset) * RGBConv[0];
-
-        const int R_tmp = (Y_tmp           + V_tmp_R) >> 16;
-        const int G_tmp = (Y_tmp + U_tmp_G + V_tmp_G) >> 16;
-        const int B_tmp = (Y_tmp + U_tmp_B          ) >> 16;
-
-        dst[dstAddr2]   = clip_buf[B_tmp];
-        dst[dstAddr2+1] = clip_buf[G_tmp];
-        dst[dstAddr2+2] = clip_buf[R_tmp];
-        dst[dstAddr2+3] = 255;
-        dstAddr2 += 4;
-      }
-      // Pixel bottom right
-      {
-        const int Y_tmp = ((int)srcY[srcAddrY2 + x + 1] - yOffset) * RGBConv[0];
+    YUVPlaneToRGB<Subsampling::YUV_420, ChromaInterpolation::NearestNeighbor>(format, frameWidth, frameHeight, MathParameters(), MathParameters(), srcY, srcU, srcV, targetBuffer, RGBConv, fullRange, lut.get(), 8, 1, yStart, yEnd);
+  });
+  return true;
+}
 
-        const int R_tmp = (Y_tmp           + V_tmp_R) >> 16;
-        const int G_tmp = (Y_tmp + U_tmp_G + V_tmp_G) >> 16;
-        const int B_tmp = (Y_tmp + U_tmp_B          ) >> 16;
+std::shared_ptr<const LineConversionLUT> videoHandlerYUV::getConversionLUT(const int RGBConv[5], bool fullRange, int bps, const MathParameters &mathY, int outputBitDepth) const
+{
+  // The SIMD kernels are faster than the lookup tables. The tables only produce 8 bit output.
+  if (outputBitDepth != 8 || !LineConversionLUT::supportsBitDepth(bps) || &getYUVConversionKernels() != &getYUVConversionKernelsScalar())
+    return {};
 
-        dst[dstAddr2]   = clip_buf[B_tmp];
-        dst[dstAddr2+1] = clip_buf[G_tmp];
-        dst[dstAddr2+2] = clip_buf[R_tmp];
-        dst[dstAddr2+3] = 255;
-        dstAddr2 += 4;
-      }
-    }
+  QMutexLocker locker(&conversionLUTMutex);
+  if (!conversionLUT || !conversionLUT->matches(RGBConv, fullRange, bps, mathY))
+  {
+    DEBUG_YUV("videoHandlerYUV::getConversionLUT rebuild lookup tables for " << bps << " bit");
+    conversionLUT = std::make_shared<const LineConversionLUT>(RGBConv, fullRange, bps, mathY);
   }
-
-  return true;
+  return conversionLUT;
 }
 
 bool videoHandlerYUV::markDifferencesYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat) const
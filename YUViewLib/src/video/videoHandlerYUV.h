@@ -32,7 +32,10 @@
 
 #pragma once
 
+#include <memory>
+
 #include "videoHandler.h"
+#include "yuvConversionKernels.h"
 #include "yuvPixelFormat.h"
 
 #include "ui_videoHandlerYUV.h"
@@ -104,6 +107,17 @@ public:
   // contain the frame with the given frame index.
   virtual void loadFrame(int frameIndex, bool loadToDoubleBuffer=false) Q_DECL_OVERRIDE;
 
+  // Convert a region of a frame from the raw YUV data. This is possible if the raw data of the frame is loaded
+  // and the format is planar.
+  virtual QImage convertFrameRegion(int frameIdx, const QRect &region, int decimation=1) Q_DECL_OVERRIDE;
+  virtual bool canConvertFrameRegion(int frameIdx) const Q_DECL_OVERRIDE;
+  // Frames can be converted at a lower resolution if they are drawn zoomed out
+  virtual bool supportsDecimatedConversion() const Q_DECL_OVERRIDE { return true; }
+  virtual QImage::Format getOutputImageFormat() const Q_DECL_OVERRIDE;
+  // The raw YUV data can be cached instead of the converted images
+  virtual bool supportsRawDataCaching() const Q_DECL_OVERRIDE { return true; }
+  virtual int getRawDataBytesPerSample() const Q_DECL_OVERRIDE { return srcPixelFormat.bitsPerSample > 8 ? 2 : 1; }
+
   // If this is set, the pixel values drawn in the drawPixels function will be scaled according to the bit depth.
   // E.g: The bit depth is 8 and the pixel value is 127, then the value shown will be -1.
   bool showPixelValuesAsDiff {false};
@@ -156,6 +170,7 @@ protected:
   // Load the given frame and return it for caching. The current buffers (currentFrameRawYUVData and currentFrame)
   // will not be modified.
   virtual void loadFrameForCaching(int frameIndex, QImage &frameToCache) Q_DECL_OVERRIDE;
+  virtual void loadRawDataForCaching(int frameIndex, QByteArray &rawDataToCache) Q_DECL_OVERRIDE;
 
 private:
 
@@ -163,8 +178,10 @@ private:
   // Return false is loading failed.
   bool loadRawYUVData(int frameIndex);
 
-  // Convert from YUV (which ever format is selected) to image (RGB-888)
-  void convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const YUV_Internals::yuvPixelFormat &yuvFormat, const QSize &curFrameSize);
+  // Convert from YUV (which ever format is selected) to image (RGB-888). If decimation is greater 1, the image is downscaled
+  // by this factor (the YUV data is decimated before the conversion). If useHighBitDepthOutput is true for the format, the
+  // output image is RGB30 (10 bit per color).
+  void convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const YUV_Internals::yuvPixelFormat &yuvFormat, const QSize &curFrameSize, int decimation=1);
 
   // Set the new pixel format thread save (lock the mutex). We should also emit that something changed (can be disabled).
   void setSrcPixelFormat(YUV_Internals::yuvPixelFormat newFormat, bool emitChangedSignal=true);
@@ -174,22 +191,35 @@ private:
   bool setFormatFromSizeAndNamePlanar(QString name, const QSize size, int bitDepth, YUV_Internals::Subsampling subsampling, int64_t fileSize);
   bool setFormatFromSizeAndNamePacked(QString name, const QSize size, int bitDepth, YUV_Internals::Subsampling subsampling, int64_t fileSize);
 
-#if SSE_CONVERSION
-  bool convertYUV420ToRGB(const byteArrayAligned &sourceBuffer, byteArrayAligned &targetBuffer);
-#else
+  // Convert to RGB30 instead of 8 bit RGB? Only for sources with more than 8 bit where all components are shown
+  // and only if enabled in the settings (see videoHandler::isHighBitDepthOutputEnabled).
+  bool useHighBitDepthOutput(const YUV_Internals::yuvPixelFormat &format) const;
+
   bool convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const YUV_Internals::yuvPixelFormat format);
-#endif
 
   bool convertYUVPackedToPlanar(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &frameSize, YUV_Internals::yuvPixelFormat &sourceBufferFormat);
-  bool convertYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
-  bool markDifferencesYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
+  // Downscale planar YUV data by the given factor (a power of 2). The format is updated to the format of the output buffer
+  // and the size of the output frame is returned.
+  static QSize decimatePlanarYUV(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &curFrameSize, YUV_Internals::yuvPixelFormat &sourceBufferFormat, const int factor);
+  bool convertYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat, int outputBitDepth=8) const;
+  // Convert packed YUV data directly to RGB without a planar intermediate. This is possible for packed 4:4:4 and 4:2:2 formats
+  // (see canConvertYUVPackedToRGB). Other packed formats are converted to planar first.
+  bool canConvertYUVPackedToRGB(const YUV_Internals::yuvPixelFormat &format) const;
+  bool convertYUVPackedToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat, int outputBitDepth=8) const;
+  // Get the lookup tables for the conversion to RGB (only used if they are faster than the conversion kernels). The tables are
+  // created on first use and rebuilt if the color conversion, the bit depth or the luma math changed. Returns nullptr if no LUT should be used.
+  std::shared_ptr<const YUV_Internals::LineConversionLUT> getConversionLUT(const int RGBConv[5], bool fullRange, int bps, const YUV_Internals::MathParameters &mathY, int outputBitDepth=8) const;
+  mutable std::shared_ptr<const YUV_Internals::LineConversionLUT> conversionLUT;
+  mutable QMutex conversionLUTMutex;
+
+  // Temporary buffers (e.g. for the planar intermediate of packed formats) are reused instead of allocating a new frame sized buffer
+  // for every conversion. Take a buffer from the pool (resized to the given size if it is not 0) and return it when it is not needed anymore.
+  QByteArray takeScratchBuffer(int size);
+  void returnScratchBuffer(QByteArray &buffer);
+  QList<QByteArray> scratchBuffers;
+  QMutex scratchBufferMutex;
 
-#if SSE_CONVERSION_420_ALT
-  void yuv420_to_argb8888(quint8 *yp, quint8 *up, quint8 *vp,
-                          quint32 sy, quint32 suv,
-                           int width, int height,
-                           quint8 *rgb, quint32 srgb);
-#endif
+  bool markDifferencesYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
 
   SafeUi<Ui::videoHandlerYUV> ui;
 
@@ -0,0 +1,422 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "yuvConversionKernels.h"
+
+#include <algorithm>
+
+#include "common/functions.h"
+#include "common/typedef.h"
+
+// SIMD_X86 is defined in typedef.h
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace YUV_Internals
+{
+
+LineConversionParameters::LineConversionParameters(const int conv[5], bool fullRange, int bps, int outputBitDepth)
+{
+  for (int i = 0; i < 5; i++)
+    RGBConv[i] = conv[i];
+
+  // The bit depth of an int (32) is not enough to perform a YUV -> RGB conversion for a bit depth > 14 bits.
+  // We are clipping the result to 8 bit anyways so let's just get rid of 2 of the bits for the YUV values.
+  const int internalBitDepth = (bps > 14) ? bps - 2 : bps;
+  inShift = (bps > 14) ? 2 : 0;
+  yOffset = fullRange ? 0 : 16 << (internalBitDepth - 8);
+  cZero = 128 << (internalBitDepth - 8);
+  outShift = 16 + internalBitDepth - outputBitDepth;
+}
+
+LineConversionLUT::LineConversionLUT(const int conv[5], bool fullRange, int bps, const MathParameters &mathY) :
+  fullRange(fullRange), bps(bps), mathY(mathY)
+{
+  for (int i = 0; i < 5; i++)
+    RGBConv[i] = conv[i];
+
+  const LineConversionParameters par(conv, fullRange, bps);
+  const int nrValues = 1 << bps;
+  inMask = nrValues - 1;
+  outShift = par.outShift;
+
+  lumaY.resize(nrValues);
+  chromaRV.resize(nrValues);
+  chromaGU.resize(nrValues);
+  chromaGV.resize(nrValues);
+  chromaBU.resize(nrValues);
+  for (int i = 0; i < nrValues; i++)
+  {
+    // Apply the luma math (identical to transformYUV in videoHandlerYUV)
+    int valY = i;
+    if (mathY.mathRequired())
+    {
+      valY = (mathY.invert ? -(valY - mathY.offset) : (valY - mathY.offset)) * mathY.scale + mathY.offset;
+      valY = std::min(std::max(valY, 0), inMask);
+    }
+    lumaY[i] = (valY - par.yOffset) * conv[0];
+
+    const int valC = i - par.cZero;
+    chromaRV[i] = valC * conv[1];
+    chromaGU[i] = valC * conv[2];
+    chromaGV[i] = valC * conv[3];
+    chromaBU[i] = valC * conv[4];
+  }
+
+  // Get the range of all possible shifted values of R, G and B
+  auto minOf = [](const std::vector<int32_t> &v) { return *std::min_element(v.begin(), v.end()); };
+  auto maxOf = [](const std::vector<int32_t> &v) { return *std::max_element(v.begin(), v.end()); };
+  const int minR = minOf(lumaY) + minOf(chromaRV);
+  const int maxR = maxOf(lumaY) + maxOf(chromaRV);
+  const int minG = minOf(lumaY) + minOf(chromaGU) + minOf(chromaGV);
+  const int maxG = maxOf(lumaY) + maxOf(chromaGU) + maxOf(chromaGV);
+  const int minB = minOf(lumaY) + minOf(chromaBU);
+  const int maxB = maxOf(lumaY) + maxOf(chromaBU);
+  const int minShifted = std::min({minR, minG, minB}) >> outShift;
+  const int maxShifted = std::max({maxR, maxG, maxB}) >> outShift;
+
+  clipOffset = minShifted;
+  clip.resize(maxShifted - minShifted + 1);
+  for (int i = minShifted; i <= maxShifted; i++)
+    clip[i - clipOffset] = (unsigned char)std::min(std::max(i, 0), 255);
+}
+
+bool LineConversionLUT::matches(const int conv[5], bool fullRange, int bps, const MathParameters &mathY) const
+{
+  return std::equal(conv, conv + 5, RGBConv) && this->fullRange == fullRange && this->bps == bps &&
+         this->mathY.scale == mathY.scale && this->mathY.offset == mathY.offset && this->mathY.invert == mathY.invert;
+}
+
+void convertLineToBGRAWithLUT(const int32_t *srcY, const int32_t *srcU, const int32_t *srcV, unsigned char *dst, int n, const LineConversionLUT &lut)
+{
+  const int32_t *lumaY = lut.lumaY.data();
+  const int32_t *chromaRV = lut.chromaRV.data();
+  const int32_t *chromaGU = lut.chromaGU.data();
+  const int32_t *chromaGV = lut.chromaGV.data();
+  const int32_t *chromaBU = lut.chromaBU.data();
+  const unsigned char *clip = lut.clip.data() - lut.clipOffset;
+  const int inMask = lut.inMask;
+  const int outShift = lut.outShift;
+
+  for (int i = 0; i < n; i++)
+  {
+    const int valY = lumaY[srcY[i] & inMask];
+    const int valU = srcU[i] & inMask;
+    const int valV = srcV[i] & inMask;
+
+    dst[i*4  ] = clip[(valY + chromaBU[valU]) >> outShift];
+    dst[i*4+1] = clip[(valY + chromaGU[valU] + chromaGV[valV]) >> outShift];
+    dst[i*4+2] = clip[(valY + chromaRV[valV]) >> outShift];
+    dst[i*4+3] = 255;
+  }
+}
+
+namespace
+{
+
+inline int clip8Bit(int val)
+{
+  return (val < 0) ? 0 : (val > 255) ? 255 : val;
+}
+
+inline int clip10Bit(int val)
+{
+  return (val < 0) ? 0 : (val > 1023) ? 1023 : val;
+}
+
+// ------------------ Scalar (C++) kernels ------------------
+
+void readLine8BitScalar(const unsigned char *src, int32_t *dst, int n, int inValSkip)
+{
+  for (int i = 0; i < n; i++)
+    dst[i] = src[i * inValSkip];
+}
+
+template<bool bigEndian>
+void readLine16BitScalar(const unsigned char *src, int32_t *dst, int n, int inValSkip)
+{
+  for (int i = 0; i < n; i++)
+  {
+    const unsigned char *s = src + i * inValSkip * 2;
+    dst[i] = bigEndian ? (s[0] << 8 | s[1]) : (s[0] | s[1] << 8);
+  }
+}
+
+// Write one pixel as BGRA (8 bit per value) or as RGB30 (10 bit per value, B in the lowest bits of the 32 bit value)
+template<bool rgb30>
+inline void writePixel(const int valR, const int valG, const int valB, unsigned char *dst)
+{
+  if (rgb30)
+  {
+    const uint32_t pixel = 0xc0000000u | uint32_t(clip10Bit(valR)) << 20 | uint32_t(clip10Bit(valG)) << 10 | uint32_t(clip10Bit(valB));
+    dst[0] = pixel & 0xff;
+    dst[1] = (pixel >> 8) & 0xff;
+    dst[2] = (pixel >> 16) & 0xff;
+    dst[3] = pixel >> 24;
+  }
+  else
+  {
+    dst[0] = clip8Bit(valB);
+    dst[1] = clip8Bit(valG);
+    dst[2] = clip8Bit(valR);
+    dst[3] = 255;
+  }
+}
+
+template<bool rgb30>
+inline void convertSampleToBGRA(const int valY, const int valU, const int valV, unsigned char *dst, const LineConversionParameters &par)
+{
+  const int Y_tmp = ((valY >> par.inShift) - par.yOffset) * par.RGBConv[0];
+  const int U_tmp = (valU >> par.inShift) - par.cZero;
+  const int V_tmp = (valV >> par.inShift) - par.cZero;
+
+  const int R_tmp = (Y_tmp                          + V_tmp * par.RGBConv[1]) >> par.outShift;
+  const int G_tmp = (Y_tmp + U_tmp * par.RGBConv[2] + V_tmp * par.RGBConv[3]) >> par.outShift;
+  const int B_tmp = (Y_tmp + U_tmp * par.RGBConv[4]                         ) >> par.outShift;
+
+  writePixel<rgb30>(R_tmp, G_tmp, B_tmp, dst);
+}
+
+template<bool rgb30>
+void convertLineToBGRAScalar(const int32_t *srcY, const int32_t *srcU, const int32_t *srcV, unsigned char *dst, int n, const LineConversionParameters &par)
+{
+  for (int i = 0; i < n; i++)
+    convertSampleToBGRA<rgb30>(srcY[i], srcU[i], srcV[i], dst + i * 4, par);
+}
+
+#if SIMD_X86
+
+// ------------------ SSE4.1 kernels ------------------
+
+SIMD_TARGET("sse4.1")
+void readLine8BitSSE41(const unsigned char *src, int32_t *dst, int n, int inValSkip)
+{
+  if (inValSkip != 1)
+    return readLine8BitScalar(src, dst, n, inValSkip);
+
+  int i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm_storeu_si128((__m128i*)(dst + i),      _mm_cvtepu8_epi32(in));
+    _mm_storeu_si128((__m128i*)(dst + i + 4),  _mm_cvtepu8_epi32(_mm_srli_si128(in, 4)));
+    _mm_storeu_si128((__m128i*)(dst + i + 8),  _mm_cvtepu8_epi32(_mm_srli_si128(in, 8)));
+    _mm_storeu_si128((__m128i*)(dst + i + 12), _mm_cvtepu8_epi32(_mm_srli_si128(in, 12)));
+  }
+  readLine8BitScalar(src + i, dst + i, n - i, 1);
+}
+
+template<bool bigEndian>
+SIMD_TARGET("sse4.1")
+void readLine16BitSSE41(const unsigned char *src, int32_t *dst, int n, int inValSkip)
+{
+  if (inValSkip != 1)
+    return readLine16BitScalar<bigEndian>(src, dst, n, inValSkip);
+
+  const __m128i swapBytes = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128i in = _mm_loadu_si128((const __m128i*)(src + i * 2));
+    if (bigEndian)
+      in = _mm_shuffle_epi8(in, swapBytes);
+    _mm_storeu_si128((__m128i*)(dst + i),     _mm_cvtepu16_epi32(in));
+    _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_cvtepu16_epi32(_mm_srli_si128(in, 8)));
+  }
+  readLine16BitScalar<bigEndian>(src + i * 2, dst + i, n - i, 1);
+}
+
+template<bool rgb30>
+SIMD_TARGET("sse4.1")
+void convertLineToBGRASSE41(const int32_t *srcY, const int32_t *srcU, const int32_t *srcV, unsigned char *dst, int n, const LineConversionParameters &par)
+{
+  const __m128i inShift  = _mm_cvtsi32_si128(par.inShift);
+  const __m128i outShift = _mm_cvtsi32_si128(par.outShift);
+  const __m128i yOffset  = _mm_set1_epi32(par.yOffset);
+  const __m128i cZero    = _mm_set1_epi32(par.cZero);
+  const __m128i coefY    = _mm_set1_epi32(par.RGBConv[0]);
+  const __m128i coefRV   = _mm_set1_epi32(par.RGBConv[1]);
+  const __m128i coefGU   = _mm_set1_epi32(par.RGBConv[2]);
+  const __m128i coefGV   = _mm_set1_epi32(par.RGBConv[3]);
+  const __m128i coefBU   = _mm_set1_epi32(par.RGBConv[4]);
+  const __m128i zero     = _mm_setzero_si128();
+  const __m128i max      = _mm_set1_epi32(rgb30 ? 1023 : 255);
+  const __m128i alpha    = _mm_set1_epi32(rgb30 ? int(0xc0000000) : int(0xff000000));
+
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128i y = _mm_loadu_si128((const __m128i*)(srcY + i));
+    __m128i u = _mm_loadu_si128((const __m128i*)(srcU + i));
+    __m128i v = _mm_loadu_si128((const __m128i*)(srcV + i));
+
+    y = _mm_mullo_epi32(_mm_sub_epi32(_mm_sra_epi32(y, inShift), yOffset), coefY);
+    u = _mm_sub_epi32(_mm_sra_epi32(u, inShift), cZero);
+    v = _mm_sub_epi32(_mm_sra_epi32(v, inShift), cZero);
+
+    __m128i r = _mm_sra_epi32(_mm_add_epi32(y, _mm_mullo_epi32(v, coefRV)), outShift);
+    __m128i g = _mm_sra_epi32(_mm_add_epi32(_mm_add_epi32(y, _mm_mullo_epi32(u, coefGU)), _mm_mullo_epi32(v, coefGV)), outShift);
+    __m128i b = _mm_sra_epi32(_mm_add_epi32(y, _mm_mullo_epi32(u, coefBU)), outShift);
+
+    r = _mm_min_epi32(_mm_max_epi32(r, zero), max);
+    g = _mm_min_epi32(_mm_max_epi32(g, zero), max);
+    b = _mm_min_epi32(_mm_max_epi32(b, zero), max);
+
+    // Each 32 bit value is one pixel. In memory (little endian) this is B, G, R, A.
+    const __m128i bgra = rgb30 ? _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 10)), _mm_or_si128(_mm_slli_epi32(r, 20), alpha)) :
+                                 _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), alpha));
+    _mm_storeu_si128((__m128i*)(dst + i * 4), bgra);
+  }
+  convertLineToBGRAScalar<rgb30>(srcY + i, srcU + i, srcV + i, dst + i * 4, n - i, par);
+}
+
+// ------------------ AVX2 kernels ------------------
+
+SIMD_TARGET("avx2")
+void readLine8BitAVX2(const unsigned char *src, int32_t *dst, int n, int inValSkip)
+{
+  if (inValSkip != 1)
+    return readLine8BitScalar(src, dst, n, inValSkip);
+
+  int i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm256_storeu_si256((__m256i*)(dst + i),     _mm256_cvtepu8_epi32(in));
+    _mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(in, 8)));
+  }
+  readLine8BitScalar(src + i, dst + i, n - i, 1);
+}
+
+template<bool bigEndian>
+SIMD_TARGET("avx2")
+void readLine16BitAVX2(const unsigned char *src, int32_t *dst, int n, int inValSkip)
+{
+  if (inValSkip != 1)
+    return readLine16BitScalar<bigEndian>(src, dst, n, inValSkip);
+
+  const __m128i swapBytes = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128i in = _mm_loadu_si128((const __m128i*)(src + i * 2));
+    if (bigEndian)
+      in = _mm_shuffle_epi8(in, swapBytes);
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_cvtepu16_epi32(in));
+  }
+  readLine16BitScalar<bigEndian>(src + i * 2, dst + i, n - i, 1);
+}
+
+template<bool rgb30>
+SIMD_TARGET("avx2")
+void convertLineToBGRAAVX2(const int32_t *srcY, const int32_t *srcU, const int32_t *srcV, unsigned char *dst, int n, const LineConversionParameters &par)
+{
+  const __m128i inShift  = _mm_cvtsi32_si128(par.inShift);
+  const __m128i outShift = _mm_cvtsi32_si128(par.outShift);
+  const __m256i yOffset  = _mm256_set1_epi32(par.yOffset);
+  const __m256i cZero    = _mm256_set1_epi32(par.cZero);
+  const __m256i coefY    = _mm256_set1_epi32(par.RGBConv[0]);
+  const __m256i coefRV   = _mm256_set1_epi32(par.RGBConv[1]);
+  const __m256i coefGU   = _mm256_set1_epi32(par.RGBConv[2]);
+  const __m256i coefGV   = _mm256_set1_epi32(par.RGBConv[3]);
+  const __m256i coefBU   = _mm256_set1_epi32(par.RGBConv[4]);
+  const __m256i zero     = _mm256_setzero_si256();
+  const __m256i max      = _mm256_set1_epi32(rgb30 ? 1023 : 255);
+  const __m256i alpha    = _mm256_set1_epi32(rgb30 ? int(0xc0000000) : int(0xff000000));
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m256i y = _mm256_loadu_si256((const __m256i*)(srcY + i));
+    __m256i u = _mm256_loadu_si256((const __m256i*)(srcU + i));
+    __m256i v = _mm256_loadu_si256((const __m256i*)(srcV + i));
+
+    y = _mm256_mullo_epi32(_mm256_sub_epi32(_mm256_sra_epi32(y, inShift), yOffset), coefY);
+    u = _mm256_sub_epi32(_mm256_sra_epi32(u, inShift), cZero);
+    v = _mm256_sub_epi32(_mm256_sra_epi32(v, inShift), cZero);
+
+    __m256i r = _mm256_sra_epi32(_mm256_add_epi32(y, _mm256_mullo_epi32(v, coefRV)), outShift);
+    __m256i g = _mm256_sra_epi32(_mm256_add_epi32(_mm256_add_epi32(y, _mm256_mullo_epi32(u, coefGU)), _mm256_mullo_epi32(v, coefGV)), outShift);
+    __m256i b = _mm256_sra_epi32(_mm256_add_epi32(y, _mm256_mullo_epi32(u, coefBU)), outShift);
+
+    r = _mm256_min_epi32(_mm256_max_epi32(r, zero), max);
+    g = _mm256_min_epi32(_mm256_max_epi32(g, zero), max);
+    b = _mm256_min_epi32(_mm256_max_epi32(b, zero), max);
+
+    const __m256i bgra = rgb30 ? _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 10)), _mm256_or_si256(_mm256_slli_epi32(r, 20), alpha)) :
+                                 _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(r, 16), alpha));
+    _mm256_storeu_si256((__m256i*)(dst + i * 4), bgra);
+  }
+  convertLineToBGRAScalar<rgb30>(srcY + i, srcU + i, srcV + i, dst + i * 4, n - i, par);
+}
+
+#endif // SIMD_X86
+
+const yuvConversionKernels kernelsScalar = {&readLine8BitScalar, &readLine16BitScalar<false>, &readLine16BitScalar<true>, &convertLineToBGRAScalar<false>, &convertLineToBGRAScalar<true>, "C++"};
+#if SIMD_X86
+const yuvConversionKernels kernelsSSE41 = {&readLine8BitSSE41, &readLine16BitSSE41<false>, &readLine16BitSSE41<true>, &convertLineToBGRASSE41<false>, &convertLineToBGRASSE41<true>, "SSE4.1"};
+const yuvConversionKernels kernelsAVX2 = {&readLine8BitAVX2, &readLine16BitAVX2<false>, &readLine16BitAVX2<true>, &convertLineToBGRAAVX2<false>, &convertLineToBGRAAVX2<true>, "AVX2"};
+#endif
+
+const yuvConversionKernels *selectKernels()
+{
+#if SIMD_X86
+  if (functions::cpuSupportsAVX2())
+    return &kernelsAVX2;
+  if (functions::cpuSupportsSSE41())
+    return &kernelsSSE41;
+#endif
+  return &kernelsScalar;
+}
+
+} // namespace
+
+yuvConversionKernels::readLineFunction yuvConversionKernels::getReadLineFunction(int bps, bool bigEndian) const
+{
+  if (bps > 8)
+    return bigEndian ? readLine16BitBE : readLine16BitLE;
+  return readLine8Bit;
+}
+
+const yuvConversionKernels &getYUVConversionKernels()
+{
+  static const yuvConversionKernels *kernels = selectKernels();
+  return *kernels;
+}
+
+const yuvConversionKernels &getYUVConversionKernelsScalar()
+{
+  return kernelsScalar;
+}
+
+} // namespace YUV_Internals
@@ -0,0 +1,116 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "yuvPixelFormat.h"
+
+namespace YUV_Internals
+{
+
+// The parameters for the conversion of one line of YUV 4:4:4 samples to 8 bit BGRA values (or 10 bit RGB30 values).
+// The scalar kernel (getYUVConversionKernelsScalar) is the reference for the calculation. For bit depths
+// above 14 bit, 2 bits of the input values are dropped (inShift) so that all values fit into 32 bit.
+struct LineConversionParameters
+{
+  LineConversionParameters(const int RGBConv[5], bool fullRange, int bps, int outputBitDepth=8);
+
+  int RGBConv[5];
+  int yOffset;
+  int cZero;
+  int inShift;
+  int outShift;
+};
+
+// A set of conversion kernels for YUV to RGB conversion. Depending on the instruction sets that the CPU
+// supports, the fastest available implementation (AVX2, SSE4.1 or plain C++) is selected once at runtime.
+struct yuvConversionKernels
+{
+  // Read n samples with 8 bit (readLine8Bit) or 16 bit (little or big endian) per sample from src into dst.
+  // inValSkip: Only read every inValSkip-th value (for interleaved U/V components this is 2 or 3).
+  typedef void (*readLineFunction)(const unsigned char *src, int32_t *dst, int n, int inValSkip);
+  readLineFunction readLine8Bit;
+  readLineFunction readLine16BitLE;
+  readLineFunction readLine16BitBE;
+  // Convert n YUV samples (one line in 4:4:4) to BGRA. Each output value is 8 bit. Alpha is set to 255.
+  void (*convertLineToBGRA)(const int32_t *srcY, const int32_t *srcU, const int32_t *srcV, unsigned char *dst, int n, const LineConversionParameters &par);
+  // Convert n YUV samples to RGB30 (QImage::Format_RGB30). Each output value is 10 bit. The parameters must be created
+  // with an output bit depth of 10.
+  void (*convertLineToRGB30)(const int32_t *srcY, const int32_t *srcU, const int32_t *srcV, unsigned char *dst, int n, const LineConversionParameters &par);
+  // The name of the implementation ("AVX2", "SSE4.1" or "C++")
+  const char *name;
+
+  // Get the read function for the given bit depth and endianness
+  readLineFunction getReadLineFunction(int bps, bool bigEndian) const;
+};
+
+// Lookup tables for the conversion of YUV values with up to 10 bit to 8 bit BGRA values. For every input value, the
+// contribution of the component to R, G and B (including the luma math) is precomputed so that the conversion of one pixel
+// only consists of table lookups, additions and a shift. The result is identical to convertLineToBGRA. This is faster than
+// the plain C++ kernel but not faster than the SIMD kernels.
+struct LineConversionLUT
+{
+  LineConversionLUT(const int RGBConv[5], bool fullRange, int bps, const MathParameters &mathY);
+
+  // Can the lookup tables be used for the given bit depth?
+  static bool supportsBitDepth(int bps) { return bps >= 8 && bps <= 10; }
+  // Were the tables created for the given parameters?
+  bool matches(const int RGBConv[5], bool fullRange, int bps, const MathParameters &mathY) const;
+
+  // Indexed by the input value. Input values with more than bps bits are masked.
+  std::vector<int32_t> lumaY, chromaRV, chromaGU, chromaGV, chromaBU;
+  int inMask;
+  int outShift;
+  // Clip the shifted result to 8 bit. Indexed by the shifted value minus clipOffset.
+  std::vector<unsigned char> clip;
+  int clipOffset;
+
+private:
+  int RGBConv[5];
+  bool fullRange;
+  int bps;
+  MathParameters mathY;
+};
+
+// Convert n YUV samples (one line in 4:4:4) to BGRA using the given lookup tables. The luma math is applied by the tables,
+// so srcY must contain the values without the math applied.
+void convertLineToBGRAWithLUT(const int32_t *srcY, const int32_t *srcU, const int32_t *srcV, unsigned char *dst, int n, const LineConversionLUT &lut);
+
+// Get the fastest kernels for the CPU that we are running on.
+const yuvConversionKernels &getYUVConversionKernels();
+// Get the plain C++ kernels. These are the reference for all SIMD kernels.
+const yuvConversionKernels &getYUVConversionKernelsScalar();
+
+} // namespace YUV_Internals
@@ -2,5 +2,6 @@ TEMPLATE = subdirs
 
 requires(qtHaveModule(testlib))
 
-SUBDIRS = filesource \
+SUBDIRS = common \
+          filesource \
           video
@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+requires(qtHaveModule(testlib))
+
+SUBDIRS = taskPoolTest.pro \
+          systemMemoryTest.pro \
+          frameBufferPoolTest.pro
@@ -0,0 +1,170 @@
+#include <QtTest>
+
+#include <common/frameBufferPool.h>
+
+const int bufferSize = 1920 * 1080 * 3 / 2;
+
+class frameBufferPoolTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  frameBufferPoolTest() {};
+  ~frameBufferPoolTest() {};
+
+private slots:
+  void init();
+  void cleanupTestCase();
+  void testByteArrayIsReused();
+  void testSharedByteArrayIsNotReused();
+  void testPrepareByteArray();
+  void testImageIsReused();
+  void testAlignedMemoryIsReused();
+  void testMaxSize();
+};
+
+void frameBufferPoolTest::init()
+{
+  frameBufferPool::instance().setMaxSize(FRAME_BUFFER_POOL_DEFAULT_MAX_BYTES);
+  frameBufferPool::instance().clear();
+}
+
+void frameBufferPoolTest::cleanupTestCase()
+{
+  frameBufferPool::instance().clear();
+}
+
+void frameBufferPoolTest::testByteArrayIsReused()
+{
+  auto &pool = frameBufferPool::instance();
+  const auto statsBefore = pool.getStatistics();
+
+  QByteArray buffer = pool.getByteArray(bufferSize);
+  QCOMPARE(buffer.size(), bufferSize);
+  const char *data = buffer.constData();
+  pool.release(buffer);
+  QVERIFY(buffer.isNull());
+  QCOMPARE(pool.getStatistics().nrBuffers, 1);
+
+  // A slightly smaller buffer is in the same bucket
+  QByteArray reused = pool.getByteArray(bufferSize - 100);
+  QCOMPARE(reused.size(), bufferSize - 100);
+  QCOMPARE(reused.constData(), data);
+  QCOMPARE(pool.getStatistics().nrBuffers, 0);
+
+  const auto statsAfter = pool.getStatistics();
+  QCOMPARE(statsAfter.hits - statsBefore.hits, int64_t(1));
+  QCOMPARE(statsAfter.misses - statsBefore.misses, int64_t(1));
+}
+
+void frameBufferPoolTest::testSharedByteArrayIsNotReused()
+{
+  auto &pool = frameBufferPool::instance();
+  QByteArray buffer = pool.getByteArray(bufferSize);
+  QByteArray copy = buffer;
+  pool.release(buffer);
+  QCOMPARE(pool.getStatistics().nrBuffers, 0);
+
+  // Buffers that were not allocated by the pool are not pooled
+  QByteArray other(bufferSize, 'a');
+  pool.release(other);
+  QCOMPARE(pool.getStatistics().nrBuffers, 0);
+}
+
+void frameBufferPoolTest::testPrepareByteArray()
+{
+  auto &pool = frameBufferPool::instance();
+
+  // A buffer that is not shared and large enough is not changed
+  QByteArray buffer = pool.getByteArray(bufferSize);
+  const char *data = buffer.constData();
+  pool.prepareByteArray(buffer, bufferSize);
+  QCOMPARE(buffer.constData(), data);
+
+  // If the buffer is shared, it is replaced. The copy is not modified.
+  buffer.fill('x');
+  QByteArray cached = buffer;
+  pool.prepareByteArray(buffer, bufferSize);
+  QVERIFY(buffer.constData() != cached.constData());
+  QVERIFY(buffer.size() >= bufferSize);
+  buffer.fill('y');
+  QCOMPARE(cached.at(0), 'x');
+  QCOMPARE(cached.at(bufferSize - 1), 'x');
+
+  // Small buffers are resized
+  QByteArray small;
+  pool.prepareByteArray(small, 100);
+  QCOMPARE(small.size(), 100);
+}
+
+void frameBufferPoolTest::testImageIsReused()
+{
+  auto &pool = frameBufferPool::instance();
+  QImage image = pool.getImage(QSize(1920, 1080), QImage::Format_RGB32);
+  QCOMPARE(image.size(), QSize(1920, 1080));
+  QCOMPARE(image.format(), QImage::Format_RGB32);
+  const uchar *bits = image.constBits();
+  pool.release(image);
+  QVERIFY(image.isNull());
+
+  // Another format or size does not match
+  QImage otherFormat = pool.getImage(QSize(1920, 1080), QImage::Format_ARGB32);
+  QVERIFY(otherFormat.constBits() != bits);
+  QImage otherSize = pool.getImage(QSize(1280, 720), QImage::Format_RGB32);
+  QVERIFY(otherSize.constBits() != bits);
+
+  QImage reused = pool.getImage(QSize(1920, 1080), QImage::Format_RGB32);
+  QCOMPARE(reused.constBits(), bits);
+
+  // A shared image is not pooled
+  QImage copy = reused;
+  pool.release(reused);
+  QCOMPARE(pool.getStatistics().nrBuffers, 0);
+}
+
+void frameBufferPoolTest::testAlignedMemoryIsReused()
+{
+  auto &pool = frameBufferPool::instance();
+  frameBufferPool::alignedMemory memory = pool.getAlignedMemory(bufferSize, 4096);
+  QVERIFY(!memory.isNull());
+  QCOMPARE(quintptr(memory.data()) % 4096, quintptr(0));
+  const char *data = memory.data();
+  pool.release(memory, bufferSize, 4096);
+  QVERIFY(memory.isNull());
+  QCOMPARE(pool.getStatistics().nrBuffers, 1);
+
+  // Another alignment does not match
+  frameBufferPool::alignedMemory otherAlignment = pool.getAlignedMemory(bufferSize, 512);
+  QVERIFY(otherAlignment.data() != data);
+  QCOMPARE(quintptr(otherAlignment.data()) % 512, quintptr(0));
+
+  // A slightly smaller size is in the same bucket
+  frameBufferPool::alignedMemory reused = pool.getAlignedMemory(bufferSize - 100, 4096);
+  QCOMPARE(reused.data(), data);
+  QCOMPARE(pool.getStatistics().nrBuffers, 0);
+}
+
+void frameBufferPoolTest::testMaxSize()
+{
+  auto &pool = frameBufferPool::instance();
+  QList<QByteArray> buffers;
+  for (int i = 0; i < 4; i++)
+    buffers.append(pool.getByteArray(bufferSize));
+
+  // Only two buffers fit into the pool. The oldest ones are freed.
+  pool.setMaxSize(int64_t(bufferSize) * 2 + 64 * 1024 * 2);
+  for (auto &b : buffers)
+    pool.release(b);
+  QCOMPARE(pool.getStatistics().nrBuffers, 2);
+  QVERIFY(pool.getStatistics().nrBytes <= pool.getStatistics().maxBytes);
+
+  pool.setMaxSize(0);
+  QCOMPARE(pool.getStatistics().nrBuffers, 0);
+  QByteArray buffer = pool.getByteArray(bufferSize);
+  pool.release(buffer);
+  QCOMPARE(pool.getStatistics().nrBuffers, 0);
+}
+
+QTEST_MAIN(frameBufferPoolTest)
+
+#include "frameBufferPoolTest.moc"
@@ -0,0 +1,130 @@
+#include <QtTest>
+
+#include <limits>
+
+#include <common/systemMemory.h>
+
+using namespace systemMemory;
+
+const int64_t MB = 1000 * 1000;
+const int64_t MiB = 1024 * 1024;
+
+class systemMemoryTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  systemMemoryTest() {};
+  ~systemMemoryTest() {};
+
+private slots:
+  void testParseMeminfo();
+  void testParseMeminfoMissingValues();
+  void testParseCgroupValue();
+  void testBudgetWithoutMemoryInfo();
+  void testBudgetEnoughMemory();
+  void testBudgetLowSystemMemory();
+  void testBudgetLowCgroupMemory();
+  void testBudgetMinimum();
+};
+
+void systemMemoryTest::testParseMeminfo()
+{
+  const QByteArray meminfo = "MemTotal:       16307648 kB\n"
+                             "MemFree:          512000 kB\n"
+                             "MemAvailable:    8153824 kB\n"
+                             "Buffers:          123456 kB\n";
+  memoryState state;
+  QVERIFY(parseMeminfo(meminfo, state));
+  QVERIFY(state.isValid());
+  QCOMPARE(state.totalBytes, int64_t(16307648) * 1024);
+  QCOMPARE(state.availableBytes, int64_t(8153824) * 1024);
+  QCOMPARE(state.cgroupLimitBytes, int64_t(-1));
+}
+
+void systemMemoryTest::testParseMeminfoMissingValues()
+{
+  // Old kernels do not report MemAvailable
+  memoryState state;
+  QVERIFY(!parseMeminfo("MemTotal:       16307648 kB\nMemFree:          512000 kB\n", state));
+  QVERIFY(!state.isValid());
+  QVERIFY(!parseMeminfo("", state));
+  QVERIFY(!parseMeminfo("MemTotal: abc kB\nMemAvailable: 100 kB\n", state));
+}
+
+void systemMemoryTest::testParseCgroupValue()
+{
+  QCOMPARE(parseCgroupValue("2147483648\n"), int64_t(2147483648));
+  QCOMPARE(parseCgroupValue("0"), int64_t(0));
+  QCOMPARE(parseCgroupValue("max\n"), int64_t(-1));
+  QCOMPARE(parseCgroupValue(""), int64_t(-1));
+}
+
+void systemMemoryTest::testBudgetWithoutMemoryInfo()
+{
+  const auto budget = getCacheBudget(memoryState(), 0, 1000 * MB);
+  QCOMPARE(budget.bytes, 1000 * MB);
+  QVERIFY(!budget.underPressure);
+  QVERIFY(!budget.reason.isEmpty());
+}
+
+void systemMemoryTest::testBudgetEnoughMemory()
+{
+  memoryState state;
+  state.totalBytes = 16000 * MiB;
+  state.availableBytes = 8000 * MiB;
+  const auto budget = getCacheBudget(state, 500 * MB, 4000 * MB);
+  QCOMPARE(budget.bytes, 4000 * MB);
+  QVERIFY(!budget.underPressure);
+
+  // A cgroup limit above the system memory (cgroups v1 without a limit) is ignored
+  state.cgroupLimitBytes = std::numeric_limits<int64_t>::max() / 2;
+  state.cgroupUsageBytes = 15000 * MiB;
+  QCOMPARE(getCacheBudget(state, 500 * MB, 4000 * MB).bytes, 4000 * MB);
+}
+
+void systemMemoryTest::testBudgetLowSystemMemory()
+{
+  memoryState state;
+  state.totalBytes = 16000 * MiB;
+  state.availableBytes = 2000 * MiB;
+  // The reserve is 10% of the memory. The memory used by the cache could be freed.
+  const int64_t cacheLevel = 3000 * MB;
+  const auto budget = getCacheBudget(state, cacheLevel, 8000 * MB);
+  QCOMPARE(budget.bytes, cacheLevel + 2000 * MiB - 1600 * MiB);
+  QVERIFY(budget.underPressure);
+
+  // If no memory is available, the cache has to shrink
+  state.availableBytes = 100 * MiB;
+  const auto shrunk = getCacheBudget(state, cacheLevel, 8000 * MB);
+  QVERIFY(shrunk.bytes < cacheLevel);
+  QVERIFY(shrunk.underPressure);
+}
+
+void systemMemoryTest::testBudgetLowCgroupMemory()
+{
+  memoryState state;
+  state.totalBytes = 64000 * MiB;
+  state.availableBytes = 32000 * MiB;
+  state.cgroupLimitBytes = 4000 * MiB;
+  state.cgroupUsageBytes = 3000 * MiB;
+  const auto budget = getCacheBudget(state, 0, 8000 * MB);
+  // 1000 MiB free in the cgroup, the reserve is 400 MiB (10% of the limit)
+  QCOMPARE(budget.bytes, 600 * MiB);
+  QVERIFY(budget.underPressure);
+  QVERIFY(budget.reason.contains("cgroup"));
+}
+
+void systemMemoryTest::testBudgetMinimum()
+{
+  memoryState state;
+  state.totalBytes = 1000 * MiB;
+  state.availableBytes = 0;
+  const auto budget = getCacheBudget(state, 0, 500 * MB);
+  QCOMPARE(budget.bytes, 20 * MB);
+  QVERIFY(budget.underPressure);
+}
+
+QTEST_MAIN(systemMemoryTest)
+
+#include "systemMemoryTest.moc"
@@ -0,0 +1,117 @@
+#include <QtTest>
+
+#include <common/taskPool.h>
+
+class taskPoolTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  taskPoolTest() {};
+  ~taskPoolTest() {};
+
+private slots:
+  void testAllTasksAreRun();
+  void testTasksSubmittedFromTasks();
+  void testWaitForTaskThatWasNotStarted();
+  void testCancelTaskThatWasNotStarted();
+  void testPriorityOfTask();
+};
+
+void taskPoolTest::testAllTasksAreRun()
+{
+  QAtomicInt counter {0};
+  QList<taskPool::taskHandle> handles;
+  for (int i = 0; i < 1000; i++)
+    handles.append(taskPool::instance().submit([&counter]() { counter.fetchAndAddOrdered(1); }, (i % 3 == 0) ? taskPriority::interactive : taskPriority::background));
+  for (auto &h : handles)
+    h.waitForFinished();
+  QCOMPARE(counter.loadAcquire(), 1000);
+  for (auto &h : handles)
+    QVERIFY(!h.isRunning());
+}
+
+void taskPoolTest::testTasksSubmittedFromTasks()
+{
+  // Each task waits for the tasks that it submitted. This must not dead lock even if there are more tasks than threads.
+  QAtomicInt counter {0};
+  const int nrOuterTasks = taskPool::instance().getNrThreads() * 2;
+  QList<taskPool::taskHandle> handles;
+  for (int i = 0; i < nrOuterTasks; i++)
+    handles.append(taskPool::instance().submit([&counter]()
+    {
+      QList<taskPool::taskHandle> innerHandles;
+      for (int j = 0; j < 10; j++)
+        innerHandles.append(taskPool::instance().submit([&counter]() { counter.fetchAndAddOrdered(1); }));
+      for (auto &h : innerHandles)
+        h.waitForFinished();
+    }));
+  for (auto &h : handles)
+    h.waitForFinished();
+  QCOMPARE(counter.loadAcquire(), nrOuterTasks * 10);
+}
+
+void taskPoolTest::testWaitForTaskThatWasNotStarted()
+{
+  // Block all threads of the pool. The next task is then run by the thread that waits for it.
+  QMutex blockMutex;
+  blockMutex.lock();
+  QList<taskPool::taskHandle> blockingHandles;
+  for (int i = 0; i < taskPool::instance().getNrThreads(); i++)
+    blockingHandles.append(taskPool::instance().submit([&blockMutex]() { QMutexLocker lock(&blockMutex); }));
+
+  Qt::HANDLE runningThread = nullptr;
+  auto handle = taskPool::instance().submit([&runningThread]() { runningThread = QThread::currentThreadId(); });
+  handle.waitForFinished();
+  QVERIFY(!handle.isRunning());
+
+  blockMutex.unlock();
+  for (auto &h : blockingHandles)
+    h.waitForFinished();
+  QVERIFY(runningThread != nullptr);
+}
+
+void taskPoolTest::testCancelTaskThatWasNotStarted()
+{
+  // Block all threads of the pool and wait until they are all blocked
+  QMutex blockMutex;
+  blockMutex.lock();
+  QAtomicInt nrBlocked {0};
+  QList<taskPool::taskHandle> blockingHandles;
+  for (int i = 0; i < taskPool::instance().getNrThreads(); i++)
+    blockingHandles.append(taskPool::instance().submit([&blockMutex, &nrBlocked]() { nrBlocked.fetchAndAddOrdered(1); QMutexLocker lock(&blockMutex); }));
+  while (nrBlocked.loadAcquire() < taskPool::instance().getNrThreads())
+    QThread::msleep(1);
+
+  QAtomicInt counter {0};
+  auto handle = taskPool::instance().submit([&counter]() { counter.fetchAndAddOrdered(1); });
+  QVERIFY(handle.cancel());
+  QVERIFY(!handle.isRunning());
+  // It can only be cancelled once and waiting for it does not run it
+  QVERIFY(!handle.cancel());
+  handle.waitForFinished();
+
+  blockMutex.unlock();
+  for (auto &h : blockingHandles)
+  {
+    h.waitForFinished();
+    QVERIFY(!h.cancel());
+  }
+  QCOMPARE(counter.loadAcquire(), 0);
+}
+
+void taskPoolTest::testPriorityOfTask()
+{
+  QCOMPARE(taskPool::getCurrentPriority(), taskPriority::interactive);
+
+  taskPriority priority = taskPriority::interactive;
+  auto handle = taskPool::instance().submit([&priority]() { priority = taskPool::getCurrentPriority(); }, taskPriority::background);
+  // Don't use waitForFinished here. It could run the task in this thread.
+  while (handle.isRunning())
+    QThread::msleep(1);
+  QCOMPARE(priority, taskPriority::background);
+}
+
+QTEST_MAIN(taskPoolTest)
+
+#include "taskPoolTest.moc"
@@ -1,6 +1,7 @@
 #include <QtTest>
 
 #include <filesource/fileSource.h>
+#include <filesource/startCodeScanner.h>
 
 class fileSourceTest : public QObject
 {
@@ -11,8 +12,13 @@ public:
   ~fileSourceTest();
 
 private slots:
+  void initTestCase();
   void testFormatFromFilename_data();
   void testFormatFromFilename();
+  void testMemoryMappedView();
+  void testParallelReads();
+  void testDirectIO();
+  void testStartCodeScanner();
 
 };
 
@@ -24,6 +30,13 @@ fileSourceTest::~fileSourceTest()
 {
 }
 
+void fileSourceTest::initTestCase()
+{
+  // Don't change the settings of YUView
+  QCoreApplication::setOrganizationName("YUViewUnitTest");
+  QCoreApplication::setApplicationName("tst_filesource");
+}
+
 void fileSourceTest::testFormatFromFilename_data()
 {
   QTest::addColumn<QString>("filename");
@@ -120,6 +133,222 @@ void fileSourceTest::testFormatFromFilename()
   QCOMPARE(fileFormat.packed, packed);
 }
 
+void fileSourceTest::testMemoryMappedView()
+{
+  QTemporaryFile file;
+  QVERIFY(file.open());
+  QByteArray content(100000, 0);
+  for (int i = 0; i < content.size(); i++)
+    content[i] = char(i * 7);
+  QCOMPARE(file.write(content), qint64(content.size()));
+  file.flush();
+
+  QSettings settings;
+  settings.setValue("MemoryMapFiles", false);
+
+  fileSource source;
+  QVERIFY(source.openFile(file.fileName()));
+  source.updateMemoryMappingSetting();
+  QVERIFY(!source.isMemoryMapped());
+  QByteArray view;
+  QVERIFY(!source.getMappedView(view, 0, 100));
+
+  // Files that are watched for changes are not mapped
+  settings.setValue("MemoryMapFiles", true);
+  settings.setValue("WatchFiles", true);
+  source.updateMemoryMappingSetting();
+  QVERIFY(!source.isMemoryMapped());
+
+  settings.setValue("WatchFiles", false);
+  source.updateMemoryMappingSetting();
+  QVERIFY(source.isMemoryMapped());
+  QVERIFY(source.getMappedView(view, 1000, 5000));
+  QCOMPARE(view, content.mid(1000, 5000));
+  // The view points into the mapped file. Nothing was allocated.
+  QCOMPARE(view.capacity(), 0);
+  QVERIFY(!source.getMappedView(view, content.size() - 10, 20));
+  QVERIFY(!source.getMappedView(view, -1, 20));
+
+  // Reading the file works as before
+  QByteArray data;
+  QCOMPARE(source.readBytes(data, 1000, 5000), int64_t(5000));
+  QCOMPARE(data.left(5000), content.mid(1000, 5000));
+
+  // The view (and all copies of it) stays valid if the file is opened again
+  QVERIFY(source.getMappedView(view, 0, 100));
+  const QByteArray viewCopy = view;
+  QVERIFY(source.openFile(file.fileName()));
+  QVERIFY(!source.isMemoryMapped());
+  source.updateMemoryMappingSetting();
+  QVERIFY(source.isMemoryMapped());
+  view.clear();
+  QVERIFY(source.getMappedView(view, 100, 100));
+  QCOMPARE(viewCopy, content.left(100));
+  QCOMPARE(view, content.mid(100, 100));
+
+  settings.remove("MemoryMapFiles");
+  settings.remove("WatchFiles");
+}
+
+// Reads all blocks with the given index modulo the number of threads and checks the content
+class readerThread : public QThread
+{
+public:
+  readerThread(fileSource *source, const QByteArray &content, int blockSize, int threadIdx, int nrThreads) :
+    source(source), content(content), blockSize(blockSize), threadIdx(threadIdx), nrThreads(nrThreads) {}
+  int nrErrors {0};
+protected:
+  void run() override
+  {
+    QByteArray data;
+    for (int repeat = 0; repeat < 10; repeat++)
+      for (int pos = threadIdx * blockSize; pos < content.size(); pos += nrThreads * blockSize)
+      {
+        const int nrBytes = qMin(blockSize, content.size() - pos);
+        if (source->readBytes(data, pos, nrBytes) != nrBytes || data.left(nrBytes) != content.mid(pos, nrBytes))
+          nrErrors++;
+      }
+  }
+private:
+  fileSource *source;
+  QByteArray content;
+  int blockSize, threadIdx, nrThreads;
+};
+
+void fileSourceTest::testParallelReads()
+{
+  QTemporaryFile file;
+  QVERIFY(file.open());
+  QByteArray content(1000000, 0);
+  for (int i = 0; i < content.size(); i++)
+    content[i] = char(i * 13 + i / 1000);
+  QCOMPARE(file.write(content), qint64(content.size()));
+  file.flush();
+
+  fileSource source;
+  QVERIFY(source.openFile(file.fileName()));
+
+  const int nrThreads = 4;
+  QList<readerThread*> threads;
+  for (int i = 0; i < nrThreads; i++)
+    threads.append(new readerThread(&source, content, 30000, i, nrThreads));
+  for (auto t : threads)
+    t->start();
+  for (auto t : threads)
+  {
+    QVERIFY(t->wait(30000));
+    QCOMPARE(t->nrErrors, 0);
+  }
+  qDeleteAll(threads);
+
+  // Reading beyond the end of the file only returns the bytes in the file
+  QByteArray data;
+  QCOMPARE(source.readBytes(data, content.size() - 100, 1000), int64_t(100));
+  QCOMPARE(data.left(100), content.right(100));
+
+  // The reads are counted in the file info
+  bool foundBytesRead = false;
+  for (auto &item : source.getFileInfoList())
+    if (item.name == "Bytes Read")
+      foundBytesRead = item.text.endsWith(QString("in %1 reads").arg(10 * 34 + 1));
+  QVERIFY(foundBytesRead);
+}
+
+void fileSourceTest::testDirectIO()
+{
+  QTemporaryFile file;
+  QVERIFY(file.open());
+  QByteArray content(1000000, 0);
+  for (int i = 0; i < content.size(); i++)
+    content[i] = char(i * 11 + i / 500);
+  QCOMPARE(file.write(content), qint64(content.size()));
+  file.flush();
+
+  QSettings settings;
+  settings.setValue("DirectIORawFiles", true);
+  settings.setValue("MemoryMapFiles", true);
+  settings.setValue("WatchFiles", false);
+
+  fileSource source;
+  QVERIFY(source.openFile(file.fileName()));
+  source.updateDirectIOSetting();
+  source.updateMemoryMappingSetting();
+  // Direct I/O is not supported by all file systems (e.g. tmpfs). The reads must work either way.
+  const bool directIOSupported = source.isDirectIO();
+  if (directIOSupported)
+    QVERIFY(!source.isMemoryMapped());
+
+  // Reads that are not aligned to the block size
+  QByteArray data;
+  QCOMPARE(source.readBytes(data, 0, 4096), int64_t(4096));
+  QCOMPARE(data.left(4096), content.left(4096));
+  QCOMPARE(source.readBytes(data, 1234, 300000), int64_t(300000));
+  QCOMPARE(data.left(300000), content.mid(1234, 300000));
+  QCOMPARE(source.readBytes(data, content.size() - 5000, 10000), int64_t(5000));
+  QCOMPARE(data.left(5000), content.right(5000));
+
+  settings.setValue("DirectIORawFiles", false);
+  source.updateDirectIOSetting();
+  QVERIFY(!source.isDirectIO());
+  QCOMPARE(source.readBytes(data, 1234, 300000), int64_t(300000));
+  QCOMPARE(data.left(300000), content.mid(1234, 300000));
+
+  // Enabling it again uses the file that was opened for direct I/O before (or fails again without trying)
+  settings.setValue("DirectIORawFiles", true);
+  source.updateDirectIOSetting();
+  QCOMPARE(source.isDirectIO(), directIOSupported);
+  QCOMPARE(source.readBytes(data, 1234, 300000), int64_t(300000));
+  QCOMPARE(data.left(300000), content.mid(1234, 300000));
+
+  settings.remove("DirectIORawFiles");
+  settings.remove("MemoryMapFiles");
+  settings.remove("WatchFiles");
+}
+
+// The reference: Check every position
+int64_t findStartCodeReference(const char *data, int64_t size)
+{
+  for (int64_t i = 0; i + 2 < size; i++)
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+      return i;
+  return -1;
+}
+
+void fileSourceTest::testStartCodeScanner()
+{
+  // Random data with many 0 and 1 bytes so that there are many (partial) start codes
+  QByteArray data(4096, 0);
+  quint32 seed = 12345;
+  for (int i = 0; i < data.size(); i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    const int r = (seed >> 16) % 16;
+    data[i] = char((r < 6) ? 0 : (r < 8) ? 1 : (seed >> 8));
+  }
+
+  const startCodeScanner &scanner = getStartCodeScanner();
+  const startCodeScanner &scalar = getStartCodeScannerScalar();
+
+  // All start positions (also unaligned ones) and sizes around the block sizes of the SIMD implementations
+  for (int start = 0; start < 64; start++)
+    for (int size = 0; size < 200; size++)
+    {
+      const char *d = data.constData() + start;
+      const int64_t expected = findStartCodeReference(d, size);
+      QCOMPARE(scanner.findStartCode(d, size), expected);
+      QCOMPARE(scalar.findStartCode(d, size), expected);
+    }
+
+  // No start code at all, a start code at the very end and one that is cut off at the end
+  QByteArray noStartCode(1000, char(2));
+  QCOMPARE(scanner.findStartCode(noStartCode.constData(), noStartCode.size()), int64_t(-1));
+  noStartCode[997] = 0;
+  noStartCode[998] = 0;
+  noStartCode[999] = 1;
+  QCOMPARE(scanner.findStartCode(noStartCode.constData(), noStartCode.size()), int64_t(997));
+  QCOMPARE(scanner.findStartCode(noStartCode.constData(), noStartCode.size() - 1), int64_t(-1));
+}
+
 QTEST_MAIN(fileSourceTest)
 
 #include "tst_filesource.moc"
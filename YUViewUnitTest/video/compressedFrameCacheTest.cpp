@@ -0,0 +1,148 @@
+#include <cstdint>
+
+#include <QtTest>
+
+#include <video/compressedFrameCache.h>
+
+class compressedFrameCacheTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  compressedFrameCacheTest() {};
+  ~compressedFrameCacheTest() {};
+
+private slots:
+  void testCodecRoundtrip_data();
+  void testCodecRoundtrip();
+  void testDecompressWrongSize();
+  void testInsertAndGet();
+  void testSizeLimit();
+};
+
+namespace
+{
+
+QByteArray createTestData(int size, bool smooth, uint32_t seed)
+{
+  QByteArray data;
+  data.resize(size);
+  uint32_t state = seed;
+  auto dst = (unsigned char*)data.data();
+  for (int i = 0; i < size; i++)
+  {
+    state = state * 1664525 + 1013904223;
+    // A smooth gradient with a little noise (like a natural image) or pure noise
+    dst[i] = smooth ? (unsigned char)(i / 64 + ((state >> 24) & 0x3)) : (unsigned char)(state >> 24);
+  }
+  return data;
+}
+
+// The cache never dereferences the handler. It is only used as a key.
+const videoHandler *getTestHandler(int i)
+{
+  static char handlers[2];
+  return reinterpret_cast<const videoHandler*>(&handlers[i]);
+}
+
+} // namespace
+
+void compressedFrameCacheTest::testCodecRoundtrip_data()
+{
+  QTest::addColumn<int>("size");
+  QTest::addColumn<int>("predictionStride");
+  QTest::addColumn<bool>("smooth");
+
+  for (int size : {1, 3, 1000 + 7, 1920 * 4 * 16})
+    for (int predictionStride : {1, 2, 4})
+      for (bool smooth : {false, true})
+        QTest::newRow(QString("size %1 stride %2%3").arg(size).arg(predictionStride).arg(smooth ? " smooth" : "").toLocal8Bit().data()) << size << predictionStride << smooth;
+}
+
+void compressedFrameCacheTest::testCodecRoundtrip()
+{
+  QFETCH(int, size);
+  QFETCH(int, predictionStride);
+  QFETCH(bool, smooth);
+
+  const QByteArray data = createTestData(size, smooth, 42);
+  const QByteArray compressed = compressedFrameCache::compressData((const unsigned char*)data.constData(), size, predictionStride);
+  QVERIFY(!compressed.isEmpty());
+  if (smooth && size > 10000)
+    QVERIFY(compressed.size() < size / 2);
+
+  QByteArray decompressed;
+  decompressed.resize(size);
+  QVERIFY(compressedFrameCache::decompressData(compressed, (unsigned char*)decompressed.data(), size, predictionStride));
+  QCOMPARE(decompressed, data);
+}
+
+void compressedFrameCacheTest::testDecompressWrongSize()
+{
+  const QByteArray data = createTestData(1000, true, 1);
+  const QByteArray compressed = compressedFrameCache::compressData((const unsigned char*)data.constData(), data.size(), 1);
+  QByteArray decompressed;
+  decompressed.resize(999);
+  QVERIFY(!compressedFrameCache::decompressData(compressed, (unsigned char*)decompressed.data(), decompressed.size(), 1));
+}
+
+void compressedFrameCacheTest::testInsertAndGet()
+{
+  auto &cache = compressedFrameCache::instance();
+  cache.setMaxSize(100 * 1000 * 1000);
+  QVERIFY(cache.isEnabled());
+
+  QImage image(64, 32, QImage::Format_ARGB32);
+  image.fill(Qt::darkCyan);
+  image.setPixel(10, 10, qRgb(1, 2, 3));
+  cache.insert(getTestHandler(0), 5, image);
+  const QByteArray rawData = createTestData(3000, true, 7);
+  cache.insert(getTestHandler(1), 5, rawData, 2);
+
+  // The compression is performed in the background
+  QTRY_VERIFY(cache.contains(getTestHandler(0), 5) && cache.contains(getTestHandler(1), 5));
+
+  QImage restoredImage;
+  QVERIFY(cache.getImage(getTestHandler(0), 5, restoredImage));
+  QCOMPARE(restoredImage, image);
+  QByteArray restoredRawData;
+  QVERIFY(!cache.getImage(getTestHandler(1), 5, restoredImage));
+  QVERIFY(cache.getRawData(getTestHandler(1), 5, restoredRawData));
+  QCOMPARE(restoredRawData, rawData);
+  QVERIFY(!cache.getRawData(getTestHandler(1), 6, restoredRawData));
+
+  cache.removeAll(getTestHandler(0));
+  QVERIFY(!cache.contains(getTestHandler(0), 5));
+  QVERIFY(cache.contains(getTestHandler(1), 5));
+  cache.remove(getTestHandler(1), 5);
+  QVERIFY(!cache.contains(getTestHandler(1), 5));
+  QCOMPARE(cache.getStatistics().nrFrames, 0);
+  QCOMPARE(cache.getStatistics().compressedBytes, int64_t(0));
+
+  cache.setMaxSize(0);
+  QVERIFY(!cache.isEnabled());
+}
+
+void compressedFrameCacheTest::testSizeLimit()
+{
+  auto &cache = compressedFrameCache::instance();
+  cache.setMaxSize(100 * 1000 * 1000);
+
+  // Noise can not be compressed so every frame needs about 10000 bytes
+  for (int i = 0; i < 10; i++)
+    cache.insert(getTestHandler(0), i, createTestData(10000, false, i), 1);
+  QTRY_COMPARE(cache.getStatistics().nrFrames, 10);
+
+  // Only the newest frames are kept
+  cache.setMaxSize(35000);
+  QVERIFY(cache.getStatistics().compressedBytes <= 35000);
+  QVERIFY(cache.getStatistics().nrFrames < 10);
+  QVERIFY(cache.getStatistics().nrFrames > 0);
+
+  cache.setMaxSize(0);
+  QCOMPARE(cache.getStatistics().nrFrames, 0);
+}
+
+QTEST_MAIN(compressedFrameCacheTest)
+
+#include "compressedFrameCacheTest.moc"
@@ -0,0 +1,302 @@
+#include <cstdint>
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QtTest>
+
+#include <video/videoHandlerRGB.h>
+#include <video/videoHandlerYUV.h>
+
+using namespace RGB_Internals;
+using namespace YUV_Internals;
+
+Q_DECLARE_METATYPE(YUV_Internals::yuvPixelFormat)
+Q_DECLARE_METATYPE(RGB_Internals::rgbPixelFormat)
+
+// Measure the speed of the conversion of raw frames to images. The frames are synthesized in memory, so no file I/O is measured.
+// The conversion is performed by loadFrameForCaching (like in the caching workers). All other calls use the public interface
+// of the video handlers. The raw data is provided in the same way as a playlist item does it (as a response to signalRequestRawData).
+// This is not run by "make check". Run it manually, e.g. "./conversionBenchmark -platform offscreen". Single rows can be selected
+// with the data tag of a row, e.g. "./conversionBenchmark -platform offscreen 'benchmarkYUVToImage:YUV 4:2:0 10-bit LE 4K'".
+class conversionBenchmark : public QObject
+{
+  Q_OBJECT
+
+public:
+  conversionBenchmark() {};
+  ~conversionBenchmark() {};
+
+private slots:
+  void benchmarkYUVToImage_data();
+  void benchmarkYUVToImage();
+  void benchmarkYUVDifference_data();
+  void benchmarkYUVDifference();
+  void benchmarkRGBToImage_data();
+  void benchmarkRGBToImage();
+  void benchmarkRGBDifference_data();
+  void benchmarkRGBDifference();
+};
+
+namespace
+{
+
+struct benchmarkResolution
+{
+  const char *name;
+  QSize size;
+};
+const benchmarkResolution benchmarkResolutions[] = {{"1080p", QSize(1920, 1080)}, {"4K", QSize(3840, 2160)}, {"8K", QSize(7680, 4320)}};
+
+// Fill the buffer with pseudo random samples of the given bit depth (little endian for more than 8 bit).
+// The generator is seeded so that every run converts the same data.
+QByteArray createRandomFrame(int64_t nrBytes, int bitDepth, uint32_t seed)
+{
+  QByteArray data;
+  data.resize(int(nrBytes));
+  uint32_t state = seed;
+  auto nextRandom = [&state]() { state = state * 1664525 + 1013904223; return state >> 8; };
+  auto dst = (unsigned char*)data.data();
+  if (bitDepth <= 8)
+  {
+    for (int i = 0; i < data.size(); i++)
+      dst[i] = (unsigned char)nextRandom();
+  }
+  else
+  {
+    const uint32_t mask = (1u << bitDepth) - 1;
+    for (int i = 0; i + 1 < data.size(); i += 2)
+    {
+      const uint32_t val = nextRandom() & mask;
+      dst[i] = (unsigned char)val;
+      dst[i+1] = (unsigned char)(val >> 8);
+    }
+  }
+  return data;
+}
+
+// loadFrameForCaching is protected. Make it accessible for the benchmark.
+class benchmarkVideoHandlerYUV : public videoHandlerYUV
+{
+public:
+  using videoHandlerYUV::loadFrameForCaching;
+};
+
+class benchmarkVideoHandlerRGB : public videoHandlerRGB
+{
+public:
+  using videoHandlerRGB::loadFrameForCaching;
+};
+
+// Provide the raw data of all frames to the handler in the same way that a playlist item does it
+void connectRawData(videoHandler *handler, const QByteArray &frameData)
+{
+  QObject::connect(handler, &videoHandler::signalRequestRawData, handler, [handler, frameData](int frameIdx, bool caching)
+  {
+    Q_UNUSED(caching);
+    handler->rawData = frameData;
+    handler->rawData_frameIdx = frameIdx;
+  }, Qt::DirectConnection);
+}
+
+void addResolutionRows(const QString &name, std::function<void(QTestData &row)> addColumns)
+{
+  for (const auto &resolution : benchmarkResolutions)
+  {
+    auto &row = QTest::newRow(QString("%1 %2").arg(name).arg(resolution.name).toLocal8Bit().data());
+    row << resolution.size;
+    addColumns(row);
+  }
+}
+
+// Run the benchmark and report the throughput in MPixel/s in addition to the time per iteration reported by QBENCHMARK
+void benchmarkPixelRate(const QSize &frameSize, const std::function<void()> &convert)
+{
+  int iterations = 0;
+  QElapsedTimer timer;
+  timer.start();
+  QBENCHMARK
+  {
+    convert();
+    iterations++;
+  }
+  const double seconds = double(timer.nsecsElapsed()) / 1e9;
+  if (iterations > 0 && seconds > 0)
+    qInfo("%s: %.1f MPixel/s", QTest::currentDataTag(), double(frameSize.width()) * frameSize.height() * iterations / seconds / 1e6);
+}
+
+QList<yuvPixelFormat> getBenchmarkYUVFormats()
+{
+  QList<yuvPixelFormat> formats;
+  for (int bitDepth : {8, 10, 16})
+  {
+    for (auto subsampling : subsamplingList)
+      formats << yuvPixelFormat(subsampling, bitDepth, PlaneOrder::YUV);
+
+    yuvPixelFormat interleaved(Subsampling::YUV_420, bitDepth, PlaneOrder::YUV);
+    interleaved.uvInterleaved = true;
+    formats << interleaved;
+
+    formats << yuvPixelFormat(Subsampling::YUV_420, bitDepth, PlaneOrder::YUVA);
+
+    // Packed 4:4:4 and 4:2:2 formats are converted in a single pass
+    for (auto packing : {PackingOrder::YUV, PackingOrder::AYUV, PackingOrder::UYVY, PackingOrder::YUYV})
+    {
+      const auto subsampling = (packing == PackingOrder::YUV || packing == PackingOrder::AYUV) ? Subsampling::YUV_444 : Subsampling::YUV_422;
+      formats << yuvPixelFormat(subsampling, bitDepth, packing);
+    }
+  }
+
+  // These packed formats are converted to planar first (convertYUVPackedToPlanar)
+  formats << yuvPixelFormat(Subsampling::YUV_422, 10, PackingOrder::UYVY, true);
+  yuvPixelFormat packedWithChromaOffset(Subsampling::YUV_422, 8, PackingOrder::UYVY);
+  packedWithChromaOffset.chromaOffset[0] = 1;
+  formats << packedWithChromaOffset;
+
+  return formats;
+}
+
+QList<rgbPixelFormat> getBenchmarkRGBFormats()
+{
+  QList<rgbPixelFormat> formats;
+  for (int bitDepth : {8, 10, 16})
+    for (bool planar : {false, true})
+    {
+      formats << rgbPixelFormat(bitDepth, planar, 0, 1, 2);
+      formats << rgbPixelFormat(bitDepth, planar, 2, 1, 0);
+      formats << rgbPixelFormat(bitDepth, planar, 0, 1, 2, 3);
+    }
+  return formats;
+}
+
+} // namespace
+
+void conversionBenchmark::benchmarkYUVToImage_data()
+{
+  QTest::addColumn<QSize>("frameSize");
+  QTest::addColumn<yuvPixelFormat>("format");
+
+  for (const auto &format : getBenchmarkYUVFormats())
+    addResolutionRows(format.getName(), [&format](QTestData &row) { row << format; });
+}
+
+void conversionBenchmark::benchmarkYUVToImage()
+{
+  QFETCH(QSize, frameSize);
+  QFETCH(yuvPixelFormat, format);
+  QVERIFY(format.canConvertToRGB(frameSize));
+
+  benchmarkVideoHandlerYUV handler;
+  handler.setFrameSize(frameSize);
+  handler.setYUVPixelFormat(format);
+  connectRawData(&handler, createRandomFrame(format.bytesPerFrame(frameSize), format.bitsPerSample, 1));
+
+  QImage image;
+  benchmarkPixelRate(frameSize, [&]() { handler.loadFrameForCaching(0, image); });
+  QCOMPARE(image.size(), frameSize);
+}
+
+void conversionBenchmark::benchmarkYUVDifference_data()
+{
+  QTest::addColumn<QSize>("frameSize");
+  QTest::addColumn<yuvPixelFormat>("format");
+  QTest::addColumn<int>("amplificationFactor");
+  QTest::addColumn<bool>("markDifference");
+
+  for (auto format : {yuvPixelFormat(Subsampling::YUV_420, 8), yuvPixelFormat(Subsampling::YUV_420, 10), yuvPixelFormat(Subsampling::YUV_444, 16)})
+  {
+    addResolutionRows(format.getName(), [&format](QTestData &row) { row << format << 1 << false; });
+    addResolutionRows(format.getName() + " amplified", [&format](QTestData &row) { row << format << 4 << false; });
+    addResolutionRows(format.getName() + " marked", [&format](QTestData &row) { row << format << 1 << true; });
+  }
+}
+
+void conversionBenchmark::benchmarkYUVDifference()
+{
+  QFETCH(QSize, frameSize);
+  QFETCH(yuvPixelFormat, format);
+  QFETCH(int, amplificationFactor);
+  QFETCH(bool, markDifference);
+
+  videoHandlerYUV handler[2];
+  for (int i = 0; i < 2; i++)
+  {
+    handler[i].setFrameSize(frameSize);
+    handler[i].setYUVPixelFormat(format);
+    connectRawData(&handler[i], createRandomFrame(format.bytesPerFrame(frameSize), format.bitsPerSample, i + 1));
+  }
+
+  QImage difference;
+  QList<infoItem> differenceInfoList;
+  benchmarkPixelRate(frameSize, [&]()
+  {
+    differenceInfoList.clear();
+    difference = handler[0].calculateDifference(&handler[1], 0, 0, differenceInfoList, amplificationFactor, markDifference);
+  });
+  QCOMPARE(difference.size(), frameSize);
+}
+
+void conversionBenchmark::benchmarkRGBToImage_data()
+{
+  QTest::addColumn<QSize>("frameSize");
+  QTest::addColumn<rgbPixelFormat>("format");
+
+  for (const auto &format : getBenchmarkRGBFormats())
+    addResolutionRows(format.getName(), [&format](QTestData &row) { row << format; });
+}
+
+void conversionBenchmark::benchmarkRGBToImage()
+{
+  QFETCH(QSize, frameSize);
+  QFETCH(rgbPixelFormat, format);
+  QVERIFY(format.isValid());
+
+  benchmarkVideoHandlerRGB handler;
+  handler.setFrameSize(frameSize);
+  handler.setRGBPixelFormat(format);
+  connectRawData(&handler, createRandomFrame(format.bytesPerFrame(frameSize), format.bitsPerValue, 1));
+
+  QImage image;
+  benchmarkPixelRate(frameSize, [&]() { handler.loadFrameForCaching(0, image); });
+  QCOMPARE(image.size(), frameSize);
+}
+
+void conversionBenchmark::benchmarkRGBDifference_data()
+{
+  QTest::addColumn<QSize>("frameSize");
+  QTest::addColumn<rgbPixelFormat>("format");
+  QTest::addColumn<bool>("markDifference");
+
+  for (auto format : {rgbPixelFormat(8, false), rgbPixelFormat(10, true)})
+  {
+    addResolutionRows(format.getName(), [&format](QTestData &row) { row << format << false; });
+    addResolutionRows(format.getName() + " marked", [&format](QTestData &row) { row << format << true; });
+  }
+}
+
+void conversionBenchmark::benchmarkRGBDifference()
+{
+  QFETCH(QSize, frameSize);
+  QFETCH(rgbPixelFormat, format);
+  QFETCH(bool, markDifference);
+
+  videoHandlerRGB handler[2];
+  for (int i = 0; i < 2; i++)
+  {
+    handler[i].setFrameSize(frameSize);
+    handler[i].setRGBPixelFormat(format);
+    connectRawData(&handler[i], createRandomFrame(format.bytesPerFrame(frameSize), format.bitsPerValue, i + 1));
+  }
+
+  QImage difference;
+  QList<infoItem> differenceInfoList;
+  benchmarkPixelRate(frameSize, [&]()
+  {
+    differenceInfoList.clear();
+    difference = handler[0].calculateDifference(&handler[1], 0, 0, differenceInfoList, 1, markDifference);
+  });
+  QCOMPARE(difference.size(), frameSize);
+}
+
+QTEST_MAIN(conversionBenchmark)
+
+#include "conversionBenchmark.moc"
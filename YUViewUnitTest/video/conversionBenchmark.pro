@@ -0,0 +1,17 @@
+TEMPLATE = app
+
+# This is a benchmark and not a test case. It is not added to "make check" and has to be run manually.
+CONFIG += qt console warn_on no_testcase_installs depend_includepath
+CONFIG -= debug_and_release
+CONFIG -= app_bundled
+
+TARGET = conversionBenchmark
+
+QT += testlib gui opengl xml concurrent network
+
+INCLUDEPATH += $$top_srcdir/YUViewLib/src
+# The generated ui headers of the video handlers
+INCLUDEPATH += $$top_builddir/YUViewLib
+LIBS += -L$$top_builddir/YUViewLib -lYUViewLib
+
+SOURCES += conversionBenchmark.cpp
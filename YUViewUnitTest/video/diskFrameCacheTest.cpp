@@ -0,0 +1,122 @@
+#include <QtTest>
+
+#include <video/diskFrameCache.h>
+
+class diskFrameCacheTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  diskFrameCacheTest() {};
+  ~diskFrameCacheTest() {};
+
+private slots:
+  void testDisabled();
+  void testWriteAndRead();
+  void testLeastRecentlyUsedFrameIsOverwritten();
+  void testFrameSizeChange();
+};
+
+namespace
+{
+
+QByteArray createFrame(int size, int frameIdx)
+{
+  QByteArray data;
+  data.resize(size);
+  for (int i = 0; i < size; i++)
+    data[i] = char((i + frameIdx * 7) & 0xff);
+  return data;
+}
+
+} // namespace
+
+void diskFrameCacheTest::testDisabled()
+{
+  diskFrameCache cache;
+  QVERIFY(!cache.isEnabled());
+  QVERIFY(!cache.write(0, createFrame(100, 0)));
+  QVERIFY(!cache.contains(0));
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  cache.setLimits(dir.path(), 0);
+  QVERIFY(!cache.isEnabled());
+  QVERIFY(!cache.write(0, createFrame(100, 0)));
+}
+
+void diskFrameCacheTest::testWriteAndRead()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  diskFrameCache cache;
+  cache.setLimits(dir.path(), 10000);
+  QVERIFY(cache.isEnabled());
+
+  for (int i = 0; i < 5; i++)
+    QVERIFY(cache.write(i * 2, createFrame(1000, i * 2)));
+  QCOMPARE(QDir(dir.path()).entryList(QDir::Files).size(), 1);
+
+  for (int i = 0; i < 10; i++)
+  {
+    QByteArray data;
+    QCOMPARE(cache.read(i, data), i % 2 == 0);
+    if (i % 2 == 0)
+      QCOMPARE(data, createFrame(1000, i));
+  }
+
+  // The file is deleted when the cache is cleared
+  cache.clear();
+  QVERIFY(!cache.contains(0));
+  QCOMPARE(QDir(dir.path()).entryList(QDir::Files).size(), 0);
+}
+
+void diskFrameCacheTest::testLeastRecentlyUsedFrameIsOverwritten()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  // There is space for 3 frames
+  diskFrameCache cache;
+  cache.setLimits(dir.path(), 3500);
+  for (int i = 0; i < 3; i++)
+    QVERIFY(cache.write(i, createFrame(1000, i)));
+
+  // Use frame 0 so that frame 1 is the least recently used one
+  QByteArray data;
+  QVERIFY(cache.read(0, data));
+  QVERIFY(cache.write(3, createFrame(1000, 3)));
+
+  QVERIFY(cache.contains(0));
+  QVERIFY(!cache.contains(1));
+  QVERIFY(cache.contains(2));
+  QVERIFY(cache.read(3, data));
+  QCOMPARE(data, createFrame(1000, 3));
+  QVERIFY(cache.read(0, data));
+  QCOMPARE(data, createFrame(1000, 0));
+}
+
+void diskFrameCacheTest::testFrameSizeChange()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  diskFrameCache cache;
+  cache.setLimits(dir.path(), 10000);
+  QVERIFY(cache.write(0, createFrame(1000, 0)));
+  QVERIFY(cache.write(1, createFrame(2000, 1)));
+  QVERIFY(!cache.contains(0));
+
+  QByteArray data;
+  QVERIFY(cache.read(1, data));
+  QCOMPARE(data, createFrame(2000, 1));
+
+  // A frame that is bigger than the limit can not be stored
+  QVERIFY(!cache.write(2, createFrame(20000, 2)));
+  QVERIFY(!cache.isEnabled());
+}
+
+QTEST_MAIN(diskFrameCacheTest)
+
+#include "diskFrameCacheTest.moc"
@@ -0,0 +1,136 @@
+#include <QtTest>
+
+#include <limits>
+
+#include <video/frameCacheIndex.h>
+
+// Insert the given number of frames in ascending order
+class writerThread : public QThread
+{
+public:
+  writerThread(frameCacheIndex &index, int nrFrames) : index(index), nrFrames(nrFrames) {}
+  void run() override
+  {
+    for (int frame = 0; frame < nrFrames; frame++)
+      index.insert(frame, frame + 1);
+  }
+private:
+  frameCacheIndex &index;
+  int nrFrames;
+};
+
+class frameCacheIndexTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  frameCacheIndexTest() {};
+  ~frameCacheIndexTest() {};
+
+private slots:
+  void testInsertAndRemove();
+  void testAccessTime();
+  void testFramesAreSorted();
+  void testClear();
+  void testReadWhileWriting();
+};
+
+void frameCacheIndexTest::testInsertAndRemove()
+{
+  frameCacheIndex index;
+  QCOMPARE(index.count(), 0);
+  QVERIFY(!index.contains(0));
+  QVERIFY(!index.contains(-1));
+
+  index.insert(0, 1);
+  index.insert(63, 1);
+  index.insert(64, 1);
+  index.insert(100000, 1);
+  index.insert(std::numeric_limits<int>::max(), 1);
+  QCOMPARE(index.count(), 5);
+  for (int frame : {0, 63, 64, 100000, std::numeric_limits<int>::max()})
+    QVERIFY(index.contains(frame));
+  QVERIFY(!index.contains(1));
+  QVERIFY(!index.contains(65));
+
+  // Inserting a frame twice does not change the count
+  index.insert(63, 2);
+  QCOMPARE(index.count(), 5);
+
+  index.remove(63);
+  QVERIFY(!index.contains(63));
+  QCOMPARE(index.count(), 4);
+  // Removing a frame that is not in the index does nothing
+  index.remove(63);
+  index.remove(5000000);
+  index.remove(-1);
+  QCOMPARE(index.count(), 4);
+}
+
+void frameCacheIndexTest::testAccessTime()
+{
+  frameCacheIndex index;
+  QCOMPARE(index.getAccessTime(10), int64_t(0));
+  index.insert(10, 100);
+  QCOMPARE(index.getAccessTime(10), int64_t(100));
+  index.setAccessTime(10, 200);
+  QCOMPARE(index.getAccessTime(10), int64_t(200));
+  index.remove(10);
+  QCOMPARE(index.getAccessTime(10), int64_t(0));
+}
+
+void frameCacheIndexTest::testFramesAreSorted()
+{
+  frameCacheIndex index;
+  QList<int> expected;
+  for (int frame = 99999; frame >= 0; frame -= 7)
+  {
+    index.insert(frame, 1);
+    expected.prepend(frame);
+  }
+  QCOMPARE(index.getFrames(), expected);
+}
+
+void frameCacheIndexTest::testClear()
+{
+  frameCacheIndex index;
+  for (int frame = 0; frame < 10000; frame++)
+    index.insert(frame, frame + 1);
+  index.clear();
+  QCOMPARE(index.count(), 0);
+  QVERIFY(index.getFrames().isEmpty());
+  QVERIFY(!index.contains(5000));
+  QCOMPARE(index.getAccessTime(5000), int64_t(0));
+
+  index.insert(5000, 1);
+  QCOMPARE(index.getFrames(), QList<int>() << 5000);
+}
+
+void frameCacheIndexTest::testReadWhileWriting()
+{
+  // The index is read without locking while another thread modifies it
+  frameCacheIndex index;
+  const int nrFrames = 50000;
+  writerThread writer(index, nrFrames);
+  writer.start();
+
+  int lastCount = 0;
+  while (!writer.isFinished())
+  {
+    const int count = index.count();
+    QVERIFY(count >= lastCount);
+    lastCount = count;
+    // A frame that is in the index has a valid access time
+    if (count > 0)
+    {
+      QVERIFY(index.contains(count - 1));
+      QVERIFY(index.getAccessTime(count - 1) > 0);
+    }
+  }
+  writer.wait();
+  QCOMPARE(index.count(), nrFrames);
+}
+
+QTEST_MAIN(frameCacheIndexTest)
+
+#include "frameCacheIndexTest.moc"
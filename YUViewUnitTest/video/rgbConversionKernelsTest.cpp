@@ -0,0 +1,98 @@
+#include <cstdlib>
+#include <vector>
+
+#include <QtTest>
+
+#include <video/rgbConversionKernels.h>
+
+using namespace RGB_Internals;
+
+class rgbConversionKernelsTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  rgbConversionKernelsTest() {};
+  ~rgbConversionKernelsTest() {};
+
+private slots:
+  void testScaleLimitedToFullRange();
+  void testConvertLineToBGRA_data();
+  void testConvertLineToBGRA();
+};
+
+// An odd number of pixels so that the scalar tail of the SIMD kernels is tested as well
+const int nrPixels = 1000 + 7;
+
+void rgbConversionKernelsTest::testScaleLimitedToFullRange()
+{
+  QCOMPARE(scaleLimitedToFullRange(0), 0);
+  QCOMPARE(scaleLimitedToFullRange(16), 0);
+  QCOMPARE(scaleLimitedToFullRange(17), 1);
+  QCOMPARE(scaleLimitedToFullRange(128), 130);
+  QCOMPARE(scaleLimitedToFullRange(234), 253);
+  QCOMPARE(scaleLimitedToFullRange(235), 255);
+  QCOMPARE(scaleLimitedToFullRange(255), 255);
+}
+
+void rgbConversionKernelsTest::testConvertLineToBGRA_data()
+{
+  QTest::addColumn<int>("bitsPerValue");
+  QTest::addColumn<int>("valueStride");
+  QTest::addColumn<bool>("limitedRange");
+
+  for (int bitsPerValue : {8, 10, 12, 16})
+    for (int valueStride : {1, 3, 4})
+      for (bool limitedRange : {false, true})
+        QTest::newRow(QString("%1 bit stride %2%3").arg(bitsPerValue).arg(valueStride).arg(limitedRange ? " limited" : "").toLocal8Bit().data()) << bitsPerValue << valueStride << limitedRange;
+}
+
+void rgbConversionKernelsTest::testConvertLineToBGRA()
+{
+  QFETCH(int, bitsPerValue);
+  QFETCH(int, valueStride);
+  QFETCH(bool, limitedRange);
+
+  const auto &kernels = getRGBConversionKernels();
+  const auto &reference = getRGBConversionKernelsScalar();
+
+  const int bytesPerValue = (bitsPerValue > 8) ? 2 : 1;
+  QByteArray src;
+  src.resize(nrPixels * valueStride * bytesPerValue * 3);
+  for (int i = 0; i < src.size(); i++)
+    src[i] = char(std::rand());
+  auto srcData = (const unsigned char*)src.constData();
+
+  // For planar data, the components are in consecutive planes (GBR). For packed data, the components of one pixel are
+  // next to each other (BGR or BGRA).
+  const unsigned char * srcComponents[3];
+  if (valueStride == 1)
+  {
+    srcComponents[0] = srcData + nrPixels * bytesPerValue * 2;
+    srcComponents[1] = srcData;
+    srcComponents[2] = srcData + nrPixels * bytesPerValue;
+  }
+  else
+  {
+    srcComponents[0] = srcData + bytesPerValue * 2;
+    srcComponents[1] = srcData + bytesPerValue;
+    srcComponents[2] = srcData;
+  }
+
+  for (int variant = 0; variant < 8; variant++)
+  {
+    const int scale[3] = {1 + variant % 3, 1, 2 + (variant & 1)};
+    const bool invert[3] = {(variant & 1) != 0, (variant & 2) != 0, (variant & 4) != 0};
+    const RGBLineConversionParameters par(bitsPerValue, valueStride, scale, invert, limitedRange);
+
+    std::vector<unsigned char> out(nrPixels * 4), outReference(nrPixels * 4);
+    kernels.convertLineToBGRA(srcComponents, out.data(), nrPixels, par);
+    reference.convertLineToBGRA(srcComponents, outReference.data(), nrPixels, par);
+    if (out != outReference)
+      QFAIL(QString("Kernel %1 differs from the reference").arg(kernels.name).toLocal8Bit().data());
+  }
+}
+
+QTEST_MAIN(rgbConversionKernelsTest)
+
+#include "rgbConversionKernelsTest.moc"
@@ -4,4 +4,10 @@ requires(qtHaveModule(testlib))
 
 SUBDIRS = yuvPixelFormatTest.pro \
           rgbPixelFormatTest.pro \
-          yuvPixelFormatGuessTest.pro
+          yuvPixelFormatGuessTest.pro \
+          yuvConversionKernelsTest.pro \
+          rgbConversionKernelsTest.pro \
+          compressedFrameCacheTest.pro \
+          diskFrameCacheTest.pro \
+          frameCacheIndexTest.pro \
+          conversionBenchmark.pro
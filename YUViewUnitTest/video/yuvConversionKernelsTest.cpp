@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <QtTest>
+
+#include <video/yuvConversionKernels.h>
+#include <video/yuvPixelFormat.h>
+
+using namespace YUV_Internals;
+
+class yuvConversionKernelsTest : public QObject
+{
+  Q_OBJECT
+
+public:
+  yuvConversionKernelsTest() {};
+  ~yuvConversionKernelsTest() {};
+
+private slots:
+  void testReadLine();
+  void testConvertLineToBGRA();
+  void testConvertLineToBGRAWithLUT();
+  void testConvertLineToRGB30();
+};
+
+// An odd number of samples so that the scalar tail of the SIMD kernels is tested as well
+const int nrSamples = 1000 + 7;
+
+void yuvConversionKernelsTest::testReadLine()
+{
+  const auto &kernels = getYUVConversionKernels();
+  const auto &reference = getYUVConversionKernelsScalar();
+
+  QByteArray src;
+  src.resize(nrSamples * 2 * 3);
+  for (int i = 0; i < src.size(); i++)
+    src[i] = char(std::rand());
+  auto srcData = (const unsigned char*)src.constData();
+
+  for (int inValSkip = 1; inValSkip <= 3; inValSkip++)
+  {
+    std::vector<int32_t> out(nrSamples), outReference(nrSamples);
+    kernels.readLine8Bit(srcData, out.data(), nrSamples, inValSkip);
+    reference.readLine8Bit(srcData, outReference.data(), nrSamples, inValSkip);
+    QVERIFY(out == outReference);
+
+    kernels.readLine16BitLE(srcData, out.data(), nrSamples, inValSkip);
+    reference.readLine16BitLE(srcData, outReference.data(), nrSamples, inValSkip);
+    QVERIFY(out == outReference);
+
+    kernels.readLine16BitBE(srcData, out.data(), nrSamples, inValSkip);
+    reference.readLine16BitBE(srcData, outReference.data(), nrSamples, inValSkip);
+    QVERIFY(out == outReference);
+  }
+}
+
+void yuvConversionKernelsTest::testConvertLineToBGRA()
+{
+  const auto &kernels = getYUVConversionKernels();
+  const auto &reference = getYUVConversionKernelsScalar();
+
+  for (auto colorConversion : colorConversionList)
+  {
+    int RGBConv[5];
+    getColorConversionCoefficients(colorConversion, RGBConv);
+    const bool fullRange = (colorConversion == ColorConversion::BT709_FullRange || colorConversion == ColorConversion::BT601_FullRange || colorConversion == ColorConversion::BT2020_FullRange);
+
+    for (int bps = 8; bps <= 16; bps++)
+    {
+      const LineConversionParameters par(RGBConv, fullRange, bps);
+
+      std::vector<int32_t> y(nrSamples), u(nrSamples), v(nrSamples);
+      for (int i = 0; i < nrSamples; i++)
+      {
+        y[i] = std::rand() % (1 << bps);
+        u[i] = std::rand() % (1 << bps);
+        v[i] = std::rand() % (1 << bps);
+      }
+
+      std::vector<unsigned char> out(nrSamples * 4), outReference(nrSamples * 4);
+      kernels.convertLineToBGRA(y.data(), u.data(), v.data(), out.data(), nrSamples, par);
+      reference.convertLineToBGRA(y.data(), u.data(), v.data(), outReference.data(), nrSamples, par);
+      if (out != outReference)
+        QFAIL(QString("Kernel %1 differs from the reference for %2 bit").arg(kernels.name).arg(bps).toLocal8Bit().data());
+    }
+  }
+}
+
+void yuvConversionKernelsTest::testConvertLineToBGRAWithLUT()
+{
+  const auto &reference = getYUVConversionKernelsScalar();
+
+  for (auto colorConversion : colorConversionList)
+  {
+    int RGBConv[5];
+    getColorConversionCoefficients(colorConversion, RGBConv);
+    const bool fullRange = (colorConversion == ColorConversion::BT709_FullRange || colorConversion == ColorConversion::BT601_FullRange || colorConversion == ColorConversion::BT2020_FullRange);
+
+    for (int bps = 8; bps <= 10; bps++)
+    {
+      const LineConversionParameters par(RGBConv, fullRange, bps);
+      const int inMax = (1 << bps) - 1;
+
+      std::vector<int32_t> y(nrSamples), u(nrSamples), v(nrSamples);
+      for (int i = 0; i < nrSamples; i++)
+      {
+        y[i] = std::rand() % (1 << bps);
+        u[i] = std::rand() % (1 << bps);
+        v[i] = std::rand() % (1 << bps);
+      }
+
+      for (auto mathY : {MathParameters(), MathParameters(2, 1 << (bps - 1), true)})
+      {
+        // The lookup tables apply the luma math. For the reference, apply it before the conversion.
+        std::vector<int32_t> yMath(y);
+        if (mathY.mathRequired())
+          for (auto &val : yMath)
+            val = std::min(std::max(-(val - mathY.offset) * mathY.scale + mathY.offset, 0), inMax);
+
+        const LineConversionLUT lut(RGBConv, fullRange, bps, mathY);
+        QVERIFY(lut.matches(RGBConv, fullRange, bps, mathY));
+
+        std::vector<unsigned char> out(nrSamples * 4), outReference(nrSamples * 4);
+        convertLineToBGRAWithLUT(y.data(), u.data(), v.data(), out.data(), nrSamples, lut);
+        reference.convertLineToBGRA(yMath.data(), u.data(), v.data(), outReference.data(), nrSamples, par);
+        if (out != outReference)
+          QFAIL(QString("LUT conversion differs from the reference for %1 bit").arg(bps).toLocal8Bit().data());
+      }
+    }
+  }
+}
+
+void yuvConversionKernelsTest::testConvertLineToRGB30()
+{
+  const auto &kernels = getYUVConversionKernels();
+  const auto &reference = getYUVConversionKernelsScalar();
+
+  for (auto colorConversion : colorConversionList)
+  {
+    int RGBConv[5];
+    getColorConversionCoefficients(colorConversion, RGBConv);
+    const bool fullRange = (colorConversion == ColorConversion::BT709_FullRange || colorConversion == ColorConversion::BT601_FullRange || colorConversion == ColorConversion::BT2020_FullRange);
+
+    for (int bps = 9; bps <= 16; bps++)
+    {
+      const LineConversionParameters par(RGBConv, fullRange, bps, 10);
+      const LineConversionParameters par8Bit(RGBConv, fullRange, bps);
+
+      std::vector<int32_t> y(nrSamples), u(nrSamples), v(nrSamples);
+      for (int i = 0; i < nrSamples; i++)
+      {
+        y[i] = std::rand() % (1 << bps);
+        u[i] = std::rand() % (1 << bps);
+        v[i] = std::rand() % (1 << bps);
+      }
+
+      std::vector<unsigned char> out(nrSamples * 4), outReference(nrSamples * 4), out8Bit(nrSamples * 4);
+      kernels.convertLineToRGB30(y.data(), u.data(), v.data(), out.data(), nrSamples, par);
+      reference.convertLineToRGB30(y.data(), u.data(), v.data(), outReference.data(), nrSamples, par);
+      if (out != outReference)
+        QFAIL(QString("Kernel %1 differs from the reference for %2 bit").arg(kernels.name).arg(bps).toLocal8Bit().data());
+
+      // The 2 most significant bits of each 10 bit value are the 8 bit result
+      reference.convertLineToBGRA(y.data(), u.data(), v.data(), out8Bit.data(), nrSamples, par8Bit);
+      for (int i = 0; i < nrSamples; i++)
+      {
+        const uint32_t pixel = uint32_t(out[i*4]) | uint32_t(out[i*4+1]) << 8 | uint32_t(out[i*4+2]) << 16 | uint32_t(out[i*4+3]) << 24;
+        QCOMPARE(int(pixel >> 30), 3);
+        QCOMPARE(int((pixel >> 22) & 0xff), int(out8Bit[i*4+2]));
+        QCOMPARE(int((pixel >> 12) & 0xff), int(out8Bit[i*4+1]));
+        QCOMPARE(int((pixel >> 2) & 0xff), int(out8Bit[i*4]));
+      }
+    }
+  }
+}
+
+QTEST_MAIN(yuvConversionKernelsTest)
+
+#include "yuvConversionKernelsTest.moc"